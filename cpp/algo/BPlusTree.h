@@ -0,0 +1,835 @@
+#ifndef ALGO_BPLUSTREE_H_
+#define ALGO_BPLUSTREE_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+
+#include "algo/BTree.h"
+#include "algo/ParamTrait.h"
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// The header of the inner nodes and the leaves of a BPlusTree.
+class BPlusTreeNode
+{
+public:
+    explicit BPlusTreeNode(const bool is_leaf)
+    : m_key_num(0), m_is_leaf(is_leaf)
+    {}
+
+    unsigned GetKeyNum() const { return m_key_num; }
+    bool IsLeaf() const { return m_is_leaf; }
+
+protected:
+    unsigned int m_key_num;
+    const bool m_is_leaf;
+};
+
+// The keys of an inner node separate its children: the keys of child i
+// are not less than key i - 1 and less than key i. MAX_KEY_NUM is odd,
+// so that a full node splits into two halves and a middle key.
+template<typename KType, unsigned int NodeSize>
+class BPlusTreeInner : public BPlusTreeNode
+{
+public:
+    typedef KType KeyType;
+    typedef typename ParamTrait<const KeyType>::DeclType KeyDeclType;
+
+    // the header and the padding of the 16 bytes aligned keys
+    enum { MAX_KEY_NUM = BTreeMaxKeyNum<NodeSize, sizeof(KType),
+                                        sizeof(BPlusTreeNode) + 15>::Result };
+    enum { IS_SPLIT_LAYOUT = true };
+
+    BPlusTreeInner() : BPlusTreeNode(false) {}
+
+    const KType& GetKey(const unsigned i) const { return m_keys[i]; }
+    const KType* GetKeys() const { return m_keys; }
+    void SetKey(const unsigned i, KeyDeclType key) { m_keys[i] = key; }
+
+    BPlusTreeNode* GetChild(const unsigned i) const { return m_children[i]; }
+    void SetChild(const unsigned i, BPlusTreeNode* child) { m_children[i] = child; }
+
+    /// insert key at i, with the child at its right.
+    void Insert(const unsigned i, KeyDeclType key, BPlusTreeNode* right_child)
+    {
+        for (unsigned j = m_key_num; j > i; --j)
+        {
+            m_keys[j] = m_keys[j - 1];
+            m_children[j + 1] = m_children[j];
+        }
+        m_keys[i] = key;
+        m_children[i + 1] = right_child;
+        ++m_key_num;
+    }
+
+    void Append(KeyDeclType key, BPlusTreeNode* right_child)
+    {
+        m_keys[m_key_num] = key;
+        m_children[m_key_num + 1] = right_child;
+        ++m_key_num;
+    }
+
+    /// insert key and its left child in front of the others.
+    void Prepend(KeyDeclType key, BPlusTreeNode* left_child)
+    {
+        m_children[m_key_num + 1] = m_children[m_key_num];
+        for (unsigned j = m_key_num; j > 0; --j)
+        {
+            m_keys[j] = m_keys[j - 1];
+            m_children[j] = m_children[j - 1];
+        }
+        m_keys[0] = key;
+        m_children[0] = left_child;
+        ++m_key_num;
+    }
+
+    /// erase the key at i and the child at its right.
+    void Erase(const unsigned i)
+    {
+        for (unsigned j = i + 1; j < m_key_num; ++j)
+        {
+            m_keys[j - 1] = m_keys[j];
+            m_children[j] = m_children[j + 1];
+        }
+        --m_key_num;
+    }
+
+    /// erase the first key and the child at its left.
+    void EraseFront()
+    {
+        for (unsigned j = 1; j < m_key_num; ++j)
+        {
+            m_keys[j - 1] = m_keys[j];
+            m_children[j - 1] = m_children[j];
+        }
+        m_children[m_key_num - 1] = m_children[m_key_num];
+        --m_key_num;
+    }
+
+    /// erase the last key and the child at its right.
+    void EraseBack()
+    {
+        --m_key_num;
+    }
+
+    /// keep the first key_num keys, and the children at their left and
+    /// right.
+    void Truncate(const unsigned key_num)
+    {
+        m_key_num = key_num;
+    }
+
+private:
+    alignas(16) KType m_keys[MAX_KEY_NUM];
+    BPlusTreeNode* m_children[MAX_KEY_NUM + 1];
+};
+
+// A leaf keeps its keys and values in two arrays, and is linked to the
+// leaves before and after it.
+template<typename KType, typename VType, unsigned int NodeSize>
+class BPlusTreeLeaf : public BPlusTreeNode
+{
+public:
+    typedef KType KeyType;
+    typedef typename ParamTrait<const KeyType>::DeclType KeyDeclType;
+    typedef VType ValueType;
+
+    // the links and the padding of the 16 bytes aligned keys too
+    enum { HEADER_SIZE = sizeof(BPlusTreeNode) + 2 * sizeof(void*) + 15 };
+    enum { FIT_NUM = NodeSize > HEADER_SIZE ?
+                     (NodeSize - HEADER_SIZE) / (sizeof(KType) + sizeof(VType)) : 0,
+           MAX_KEY_NUM = FIT_NUM > 3 ? FIT_NUM : 3 };
+    enum { IS_SPLIT_LAYOUT = true };
+
+    BPlusTreeLeaf() : BPlusTreeNode(true), m_prev(NULL), m_next(NULL) {}
+
+    const KType& GetKey(const unsigned i) const { return m_keys[i]; }
+    const KType* GetKeys() const { return m_keys; }
+    const VType& GetValue(const unsigned i) const { return m_values[i]; }
+    VType& GetValue(const unsigned i) { return m_values[i]; }
+
+    BPlusTreeLeaf* GetPrev() const { return m_prev; }
+    BPlusTreeLeaf* GetNext() const { return m_next; }
+    void SetPrev(BPlusTreeLeaf* prev) { m_prev = prev; }
+    void SetNext(BPlusTreeLeaf* next) { m_next = next; }
+
+    void Insert(const unsigned i, KeyDeclType key, const VType& value)
+    {
+        for (unsigned j = m_key_num; j > i; --j)
+        {
+            m_keys[j] = m_keys[j - 1];
+            m_values[j] = m_values[j - 1];
+        }
+        m_keys[i] = key;
+        m_values[i] = value;
+        ++m_key_num;
+    }
+
+    void Erase(const unsigned i)
+    {
+        for (unsigned j = i + 1; j < m_key_num; ++j)
+        {
+            m_keys[j - 1] = m_keys[j];
+            m_values[j - 1] = m_values[j];
+        }
+        --m_key_num;
+    }
+
+    /// move the items from first on to the end of leaf.
+    void MoveItemsTo(const unsigned first, BPlusTreeLeaf& leaf)
+    {
+        for (unsigned j = first; j < m_key_num; ++j)
+        {
+            leaf.m_keys[leaf.m_key_num] = m_keys[j];
+            leaf.m_values[leaf.m_key_num] = m_values[j];
+            ++leaf.m_key_num;
+        }
+        m_key_num = first;
+    }
+
+private:
+    alignas(16) KType m_keys[MAX_KEY_NUM];
+    VType m_values[MAX_KEY_NUM];
+    BPlusTreeLeaf* m_prev;
+    BPlusTreeLeaf* m_next;
+};
+
+}  // namespace detail
+
+
+// An ordered map of Key to Value like BTree, but with all the values in
+// the leaves, which are linked in the order of the keys for range scans.
+// The inner nodes only hold keys routing to the leaves, so more of them
+// fit in NodeSize bytes.
+//
+// The iterators are invalidated by Insert() and Delete().
+template<typename Key, typename Value,
+         typename Compare = ::std::less<Key>,
+         unsigned int NodeSize = 512,
+         typename Allocator = ::std::allocator<Key> >
+class BPlusTree
+{
+public:
+    typedef detail::BPlusTreeNode Node;
+    typedef detail::BPlusTreeInner<Key, NodeSize> Inner;
+    typedef detail::BPlusTreeLeaf<Key, Value, NodeSize> Leaf;
+
+private:
+    class IteratorBase
+    {
+        friend class BPlusTree;
+
+        friend bool operator== (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.IsEqual(rhs);
+        }
+
+        friend bool operator!= (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return !lhs.IsEqual(rhs);
+        }
+
+    public:
+        // leaf is NULL at the end, index is less than the keys of leaf.
+        IteratorBase(const BPlusTree* tree, Leaf* leaf, const unsigned index)
+        : m_tree(tree), m_leaf(leaf), m_index(index)
+        {}
+
+        void Next()
+        {
+            if (++m_index == m_leaf->GetKeyNum())
+            {
+                m_leaf = m_leaf->GetNext();
+                m_index = 0;
+            }
+        }
+
+        void Prev()
+        {
+            if (m_leaf != NULL && m_index > 0)
+            {
+                --m_index;
+                return;
+            }
+
+            m_leaf = m_leaf != NULL ? m_leaf->GetPrev() : m_tree->m_last_leaf;
+            m_index = m_leaf->GetKeyNum() - 1;
+        }
+
+    protected:
+        bool IsEqual(const IteratorBase& other) const
+        {
+            return m_leaf == other.m_leaf && m_index == other.m_index;
+        }
+
+        const BPlusTree* m_tree;
+        Leaf* m_leaf;
+        unsigned m_index;
+    };
+
+public:
+    class Iterator : public IteratorBase
+    {
+    public:
+        Iterator(const BPlusTree* tree, Leaf* leaf, const unsigned index)
+        : IteratorBase(tree, leaf, index)
+        {}
+
+        Iterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        Iterator& operator--()
+        {
+            this->Prev();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_leaf->GetKey(this->m_index);
+        }
+
+        Value& GetValue()
+        {
+            return this->m_leaf->GetValue(this->m_index);
+        }
+    };
+
+    class ConstIterator : public IteratorBase
+    {
+    public:
+        ConstIterator(const BPlusTree* tree, Leaf* leaf, const unsigned index)
+        : IteratorBase(tree, leaf, index)
+        {}
+
+        // We can convert a Iterator to ConstIterator
+        ConstIterator(const Iterator& it)
+        : IteratorBase(it)
+        {}
+
+        ConstIterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        ConstIterator& operator--()
+        {
+            this->Prev();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_leaf->GetKey(this->m_index);
+        }
+
+        typename ParamTrait<const Value>::DeclType GetValue() const
+        {
+            return this->m_leaf->GetValue(this->m_index);
+        }
+    };
+
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+    typedef Compare key_compare;
+    typedef Allocator allocator_type;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Inner>
+            InnerAllocator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Leaf>
+            LeafAllocator;
+
+    enum { CACHE_LINE_SIZE = 64 };
+
+    explicit BPlusTree(const Compare& compare = Compare(),
+                       const Allocator& alloc = Allocator())
+    : m_impl(LeafAllocator(alloc), compare)
+    , m_root(NULL)
+    , m_first_leaf(NULL)
+    , m_last_leaf(NULL)
+    , m_size(0)
+    {
+        m_first_leaf = m_last_leaf = NewLeaf();
+        m_root = m_first_leaf;
+    }
+
+    ~BPlusTree()
+    {
+        FreeNodes(m_root);
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        const Leaf* leaf = FindLeaf(key);
+        const unsigned i = LeafLowerBound(*leaf, key);
+        if (i < leaf->GetKeyNum() && !GetCompare()(key, leaf->GetKey(i)))
+        {
+            value = leaf->GetValue(i);
+            return true;
+        }
+        return false;
+    }
+
+    // Returns false and keeps the old value if key is already present.
+    // The full nodes on the way down are split.
+    bool Insert(typename ParamTrait<const Key>::DeclType key, const Value& value)
+    {
+        if (IsFull(*m_root))
+        {
+            Inner* root = NewInner();
+            root->SetChild(0, m_root);
+            m_root = root;
+            SplitChild(*root, 0);
+        }
+
+        Node* node = m_root;
+        while (!node->IsLeaf())
+        {
+            Inner* inner = static_cast<Inner*>(node);
+            unsigned i = ChildIndex(*inner, key);
+            if (IsFull(*inner->GetChild(i)))
+            {
+                SplitChild(*inner, i);
+                if (!GetCompare()(key, inner->GetKey(i)))
+                {
+                    ++i;
+                }
+            }
+            node = inner->GetChild(i);
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        const unsigned i = LeafLowerBound(*leaf, key);
+        if (i < leaf->GetKeyNum() && !GetCompare()(key, leaf->GetKey(i)))
+        {
+            return false;
+        }
+        leaf->Insert(i, key, value);
+        ++m_size;
+        return true;
+    }
+
+    // Returns false if key is not present.
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        if (!Delete(*m_root, key))
+        {
+            return false;
+        }
+
+        if (!m_root->IsLeaf() && m_root->GetKeyNum() == 0)
+        {
+            Inner* old_root = static_cast<Inner*>(m_root);
+            m_root = old_root->GetChild(0);
+            FreeInner(old_root);
+        }
+        --m_size;
+        return true;
+    }
+
+    // The first entry whose key is not less than key.
+    iterator LowerBound(typename ParamTrait<const Key>::DeclType key)
+    {
+        Leaf* leaf = FindLeaf(key);
+        return MakeIterator<iterator>(leaf, LeafLowerBound(*leaf, key));
+    }
+
+    const_iterator LowerBound(typename ParamTrait<const Key>::DeclType key) const
+    {
+        Leaf* leaf = FindLeaf(key);
+        return MakeIterator<const_iterator>(leaf, LeafLowerBound(*leaf, key));
+    }
+
+    // The first entry whose key is greater than key.
+    iterator UpperBound(typename ParamTrait<const Key>::DeclType key)
+    {
+        Leaf* leaf = FindLeaf(key);
+        return MakeIterator<iterator>(leaf, LeafUpperBound(*leaf, key));
+    }
+
+    const_iterator UpperBound(typename ParamTrait<const Key>::DeclType key) const
+    {
+        Leaf* leaf = FindLeaf(key);
+        return MakeIterator<const_iterator>(leaf, LeafUpperBound(*leaf, key));
+    }
+
+    // Call callback(key, value) for every entry with a key in [from, to),
+    // in the order of the keys, and return their number. The leaf after
+    // the one scanned is prefetched.
+    template<typename Callback>
+    ::std::size_t Scan(typename ParamTrait<const Key>::DeclType from,
+                       typename ParamTrait<const Key>::DeclType to,
+                       Callback& callback) const
+    {
+        const Compare& compare = GetCompare();
+        if (!compare(from, to))
+        {
+            return 0;
+        }
+
+        const Leaf* leaf = FindLeaf(from);
+        unsigned i = LeafLowerBound(*leaf, from);
+        ::std::size_t count = 0;
+        for (; leaf != NULL; leaf = leaf->GetNext(), i = 0)
+        {
+            PrefetchLeaf(leaf->GetNext());
+            const unsigned key_num = leaf->GetKeyNum();
+            for (; i < key_num; ++i)
+            {
+                if (!compare(leaf->GetKey(i), to))
+                {
+                    return count;
+                }
+                callback(leaf->GetKey(i), leaf->GetValue(i));
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    void Clear()
+    {
+        FreeNodes(m_root);
+        m_first_leaf = m_last_leaf = NewLeaf();
+        m_root = m_first_leaf;
+        m_size = 0;
+    }
+
+    // STL compatible methods
+    iterator begin() { return MakeIterator<iterator>(m_first_leaf, 0); }
+    const_iterator begin() const { return MakeIterator<const_iterator>(m_first_leaf, 0); }
+    iterator end() { return iterator(this, NULL, 0); }
+    const_iterator end() const { return const_iterator(this, NULL, 0); }
+
+    ::std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear() { Clear(); }
+    key_compare key_comp() const { return GetCompare(); }
+    allocator_type get_allocator() const { return allocator_type(GetLeafAllocator()); }
+
+private:
+    typedef ::std::allocator_traits<InnerAllocator> InnerAllocatorTraits;
+    typedef ::std::allocator_traits<LeafAllocator> LeafAllocatorTraits;
+
+    const Compare& GetCompare() const { return m_impl; }
+    LeafAllocator& GetLeafAllocator() { return m_impl; }
+    const LeafAllocator& GetLeafAllocator() const { return m_impl; }
+
+    static bool IsFull(const Node& node)
+    {
+        return node.IsLeaf() ?
+                node.GetKeyNum() == static_cast<unsigned>(Leaf::MAX_KEY_NUM) :
+                node.GetKeyNum() == static_cast<unsigned>(Inner::MAX_KEY_NUM);
+    }
+
+    static unsigned GetMinKeyNum(const Node& node)
+    {
+        return node.IsLeaf() ? Leaf::MAX_KEY_NUM / 2 : Inner::MAX_KEY_NUM / 2;
+    }
+
+    static void PrefetchLeaf(const Leaf* leaf)
+    {
+        if (leaf == NULL)
+        {
+            return;
+        }
+
+        const char* addr = reinterpret_cast<const char*>(leaf);
+        for (::std::size_t offset = 0; offset < sizeof(Leaf); offset += CACHE_LINE_SIZE)
+        {
+            __builtin_prefetch(addr + offset);
+        }
+    }
+
+    unsigned LeafLowerBound(const Leaf& leaf, typename ParamTrait<const Key>::DeclType key) const
+    {
+        return detail::BTreeNodeSearch<Leaf, Compare>::LowerBound(leaf, key, GetCompare());
+    }
+
+    unsigned LeafUpperBound(const Leaf& leaf, typename ParamTrait<const Key>::DeclType key) const
+    {
+        const unsigned i = LeafLowerBound(leaf, key);
+        return i < leaf.GetKeyNum() && !GetCompare()(key, leaf.GetKey(i)) ? i + 1 : i;
+    }
+
+    // the child whose keys may contain key: the keys being unique, the
+    // number of keys not greater than key.
+    unsigned ChildIndex(const Inner& inner, typename ParamTrait<const Key>::DeclType key) const
+    {
+        const unsigned i =
+                detail::BTreeNodeSearch<Inner, Compare>::LowerBound(inner, key, GetCompare());
+        return i < inner.GetKeyNum() && !GetCompare()(key, inner.GetKey(i)) ? i + 1 : i;
+    }
+
+    Leaf* FindLeaf(typename ParamTrait<const Key>::DeclType key) const
+    {
+        const Node* node = m_root;
+        while (!node->IsLeaf())
+        {
+            const Inner* inner = static_cast<const Inner*>(node);
+            node = inner->GetChild(ChildIndex(*inner, key));
+        }
+        return static_cast<Leaf*>(const_cast<Node*>(node));
+    }
+
+    // index may be past the last key of leaf, then it is the first key of
+    // the next leaf, as only the root leaf can be empty.
+    template<typename IteratorType>
+    IteratorType MakeIterator(Leaf* leaf, const unsigned index) const
+    {
+        if (index < leaf->GetKeyNum())
+        {
+            return IteratorType(this, leaf, index);
+        }
+        return IteratorType(this, leaf->GetNext(), 0);
+    }
+
+    /// split the full child at i into two, linked from parent, which is
+    /// not full.
+    void SplitChild(Inner& parent, const unsigned i)
+    {
+        Node* child = parent.GetChild(i);
+        if (child->IsLeaf())
+        {
+            Leaf* leaf = static_cast<Leaf*>(child);
+            Leaf* new_leaf = NewLeaf();
+            leaf->MoveItemsTo(leaf->GetKeyNum() / 2, *new_leaf);
+
+            new_leaf->SetNext(leaf->GetNext());
+            new_leaf->SetPrev(leaf);
+            if (leaf->GetNext() != NULL)
+            {
+                leaf->GetNext()->SetPrev(new_leaf);
+            }
+            else
+            {
+                m_last_leaf = new_leaf;
+            }
+            leaf->SetNext(new_leaf);
+            parent.Insert(i, new_leaf->GetKey(0), new_leaf);
+        }
+        else
+        {
+            Inner* inner = static_cast<Inner*>(child);
+            Inner* new_inner = NewInner();
+            const unsigned middle = inner->GetKeyNum() / 2;
+            new_inner->SetChild(0, inner->GetChild(middle + 1));
+            for (unsigned j = middle + 1; j < inner->GetKeyNum(); ++j)
+            {
+                new_inner->Append(inner->GetKey(j), inner->GetChild(j + 1));
+            }
+            parent.Insert(i, inner->GetKey(middle), new_inner);
+            inner->Truncate(middle);
+        }
+    }
+
+    bool Delete(Node& node, typename ParamTrait<const Key>::DeclType key)
+    {
+        if (node.IsLeaf())
+        {
+            Leaf& leaf = static_cast<Leaf&>(node);
+            const unsigned i = LeafLowerBound(leaf, key);
+            if (i < leaf.GetKeyNum() && !GetCompare()(key, leaf.GetKey(i)))
+            {
+                leaf.Erase(i);
+                return true;
+            }
+            return false;
+        }
+
+        Inner& inner = static_cast<Inner&>(node);
+        const unsigned i = ChildIndex(inner, key);
+        Node* child = inner.GetChild(i);
+        if (!Delete(*child, key))
+        {
+            return false;
+        }
+
+        if (child->GetKeyNum() < GetMinKeyNum(*child))
+        {
+            Rebalance(inner, i);
+        }
+        return true;
+    }
+
+    /// refill the child at i with a key of a sibling, or merge it with a
+    /// sibling if they both have the minimum number of keys.
+    void Rebalance(Inner& parent, const unsigned i)
+    {
+        Node* child = parent.GetChild(i);
+        Node* left = i > 0 ? parent.GetChild(i - 1) : NULL;
+        Node* right = i < parent.GetKeyNum() ? parent.GetChild(i + 1) : NULL;
+        const unsigned min_key_num = GetMinKeyNum(*child);
+
+        if (left != NULL && left->GetKeyNum() > min_key_num)
+        {
+            ShiftFromLeft(parent, i - 1);
+        }
+        else if (right != NULL && right->GetKeyNum() > min_key_num)
+        {
+            ShiftFromRight(parent, i);
+        }
+        else if (left != NULL)
+        {
+            MergeChildren(parent, i - 1);
+        }
+        else
+        {
+            MergeChildren(parent, i);
+        }
+    }
+
+    /// move the last key of the child at i to the child at i + 1.
+    void ShiftFromLeft(Inner& parent, const unsigned i)
+    {
+        if (parent.GetChild(i)->IsLeaf())
+        {
+            Leaf* left = static_cast<Leaf*>(parent.GetChild(i));
+            Leaf* right = static_cast<Leaf*>(parent.GetChild(i + 1));
+            const unsigned last = left->GetKeyNum() - 1;
+            right->Insert(0, left->GetKey(last), left->GetValue(last));
+            left->Erase(last);
+            parent.SetKey(i, right->GetKey(0));
+        }
+        else
+        {
+            Inner* left = static_cast<Inner*>(parent.GetChild(i));
+            Inner* right = static_cast<Inner*>(parent.GetChild(i + 1));
+            const unsigned last = left->GetKeyNum() - 1;
+            right->Prepend(parent.GetKey(i), left->GetChild(last + 1));
+            parent.SetKey(i, left->GetKey(last));
+            left->EraseBack();
+        }
+    }
+
+    /// move the first key of the child at i + 1 to the child at i.
+    void ShiftFromRight(Inner& parent, const unsigned i)
+    {
+        if (parent.GetChild(i)->IsLeaf())
+        {
+            Leaf* left = static_cast<Leaf*>(parent.GetChild(i));
+            Leaf* right = static_cast<Leaf*>(parent.GetChild(i + 1));
+            left->Insert(left->GetKeyNum(), right->GetKey(0), right->GetValue(0));
+            right->Erase(0);
+            parent.SetKey(i, right->GetKey(0));
+        }
+        else
+        {
+            Inner* left = static_cast<Inner*>(parent.GetChild(i));
+            Inner* right = static_cast<Inner*>(parent.GetChild(i + 1));
+            left->Append(parent.GetKey(i), right->GetChild(0));
+            parent.SetKey(i, right->GetKey(0));
+            right->EraseFront();
+        }
+    }
+
+    /// merge the child at i + 1 into the child at i, and free it.
+    void MergeChildren(Inner& parent, const unsigned i)
+    {
+        if (parent.GetChild(i)->IsLeaf())
+        {
+            Leaf* left = static_cast<Leaf*>(parent.GetChild(i));
+            Leaf* right = static_cast<Leaf*>(parent.GetChild(i + 1));
+            right->MoveItemsTo(0, *left);
+
+            left->SetNext(right->GetNext());
+            if (right->GetNext() != NULL)
+            {
+                right->GetNext()->SetPrev(left);
+            }
+            else
+            {
+                m_last_leaf = left;
+            }
+            parent.Erase(i);
+            FreeLeaf(right);
+        }
+        else
+        {
+            Inner* left = static_cast<Inner*>(parent.GetChild(i));
+            Inner* right = static_cast<Inner*>(parent.GetChild(i + 1));
+            left->Append(parent.GetKey(i), right->GetChild(0));
+            for (unsigned j = 0; j < right->GetKeyNum(); ++j)
+            {
+                left->Append(right->GetKey(j), right->GetChild(j + 1));
+            }
+            parent.Erase(i);
+            FreeInner(right);
+        }
+    }
+
+    Inner* NewInner()
+    {
+        InnerAllocator alloc(GetLeafAllocator());
+        Inner* inner = InnerAllocatorTraits::allocate(alloc, 1);
+        (void) new (inner) Inner();
+        return inner;
+    }
+
+    Leaf* NewLeaf()
+    {
+        Leaf* leaf = LeafAllocatorTraits::allocate(GetLeafAllocator(), 1);
+        (void) new (leaf) Leaf();
+        return leaf;
+    }
+
+    void FreeInner(Inner* inner)
+    {
+        InnerAllocator alloc(GetLeafAllocator());
+        inner->~Inner();
+        InnerAllocatorTraits::deallocate(alloc, inner, 1);
+    }
+
+    void FreeLeaf(Leaf* leaf)
+    {
+        leaf->~Leaf();
+        LeafAllocatorTraits::deallocate(GetLeafAllocator(), leaf, 1);
+    }
+
+    void FreeNodes(Node* node)
+    {
+        if (node->IsLeaf())
+        {
+            FreeLeaf(static_cast<Leaf*>(node));
+            return;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        for (unsigned i = 0; i <= inner->GetKeyNum(); ++i)
+        {
+            FreeNodes(inner->GetChild(i));
+        }
+        FreeInner(inner);
+    }
+
+    struct CompareAndLeafAllocator : public LeafAllocator, public Compare
+    {
+        CompareAndLeafAllocator(const LeafAllocator& alloc, const Compare& compare)
+        : LeafAllocator(alloc), Compare(compare)
+        {}
+    };
+
+    CompareAndLeafAllocator m_impl;
+    Node* m_root;
+    Leaf* m_first_leaf;
+    Leaf* m_last_leaf;
+    ::std::size_t m_size;
+
+    BPlusTree(const BPlusTree&);
+    BPlusTree& operator=(const BPlusTree&);
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_BPLUSTREE_H_
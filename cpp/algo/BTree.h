@@ -6,71 +6,345 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
 
+#include "algo/Parallel.h"
 #include "algo/ParamTrait.h"
+#include "algo/PoolAllocator.h"
+#include "algo/TypeTrait.h"
+
+#ifdef __SSE2__
+// simdple passes __m128i and friends as template arguments, which makes
+// g++ warn that their vector attributes are ignored.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+#include "simdple/VectorImpl.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 namespace snippet {
 namespace algo {
 
+// The node layouts of BTree.
+// BTreePairLayout keeps key/value pairs in the nodes. BTreeSplitLayout
+// keeps a packed array of keys in the nodes and the values in an array
+// of their own per node, so that searching a node reads no values and
+// the number of keys per node depends on the size of the keys only.
+struct BTreePairLayout {};
+struct BTreeSplitLayout {};
+
 namespace detail {
 
-template<typename KType, typename VType, unsigned int NodeSize = 512>
-class BTreeNode
+// Keys searched in a node with simdple compares instead of a binary
+// search: integers ordered by std::less, which fit a SSE register.
+// VectorType is the simdple vector of the keys.
+template<typename Key, typename Compare>
+struct BTreeSimdSearch
+{
+    enum { Result = false };
+};
+
+#ifdef __SSE2__
+template<>
+struct BTreeSimdSearch<int, ::std::less<int> >
+{
+    enum { Result = true };
+    typedef ::simdple::VectorImpl<int, 4> VectorType;
+};
+
+#ifdef __SSE4_2__
+template<>
+struct BTreeSimdSearch<long long, ::std::less<long long> >
+{
+    enum { Result = true };
+    typedef ::simdple::VectorImpl<long long, 2> VectorType;
+};
+
+#ifdef __LP64__
+template<>
+struct BTreeSimdSearch<long, ::std::less<long> >
+{
+    enum { Result = true };
+    typedef ::simdple::VectorImpl<long long, 2> VectorType;
+};
+#endif  // __LP64__
+#endif  // __SSE4_2__
+#endif  // __SSE2__
+
+// The search in the keys of a node. A Node has KeyType, KeyDeclType,
+// GetKeyNum() and GetKey(i), and if Node::IS_SPLIT_LAYOUT, GetKeys() to
+// its packed and 16 bytes aligned keys.
+template<typename Node, typename Compare>
+struct BTreeNodeSearch
+{
+    typedef typename Node::KeyType KeyType;
+    typedef typename Node::KeyDeclType KeyDeclType;
+
+    /// the index of the first key not less than key, or GetKeyNum().
+    /// It is searched with simdple compares if BTreeSimdSearch says so,
+    /// by a branchless binary search for the other trivially copyable keys,
+    /// or else by a linear scan.
+    static unsigned LowerBound(const Node& node, KeyDeclType key, const Compare& compare)
+    {
+        return LowerBound(node, key, compare,
+                          BoolType<BTreeSimdSearch<KeyType, Compare>::Result>());
+    }
+
+    static unsigned LowerBound(const Node& node, KeyDeclType key, const Compare& compare,
+                               BoolType<false>)
+    {
+        return ScalarLowerBound(node, key, compare,
+                                BoolType< ::std::is_trivially_copyable<KeyType>::value>());
+    }
+
+    // Every compare depends on the one before, which is cheap for keys
+    // held in the node, but serializes the cache misses of keys pointing
+    // to their data (like std::string), so those are scanned in order.
+    static unsigned ScalarLowerBound(const Node& node, KeyDeclType key,
+                                     const Compare& compare, BoolType<false>)
+    {
+        const unsigned key_num = node.GetKeyNum();
+        unsigned i = 0;
+        while (i < key_num && compare(node.GetKey(i), key))
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    static unsigned ScalarLowerBound(const Node& node, KeyDeclType key,
+                                     const Compare& compare, BoolType<true>)
+    {
+        if (node.GetKeyNum() == 0)
+        {
+            return 0;
+        }
+
+        // the lower bound is in [first, first + n]
+        unsigned first = 0;
+        unsigned n = node.GetKeyNum();
+        while (n > 1)
+        {
+            const unsigned half = n / 2;
+            first = compare(node.GetKey(first + half), key) ? first + half : first;
+            n -= half;
+        }
+        return first + (compare(node.GetKey(first), key) ? 1 : 0);
+    }
+
+    // The keys less than key are a prefix of the node, counted one
+    // vector at a time until a vector of keys is not all less than key.
+    static unsigned LowerBound(const Node& node, KeyDeclType key, const Compare& compare,
+                               BoolType<true>)
+    {
+        typedef typename BTreeSimdSearch<KeyType, Compare>::VectorType VectorType;
+        typedef typename VectorType::ElemType ElemType;
+        enum { ELEM_NUM = VectorType::ElemNum, ALL_LESS_MASK = (1 << VectorType::SIZE) - 1 };
+
+        const unsigned key_num = node.GetKeyNum();
+        const VectorType key_vector = VectorType::Load(static_cast<ElemType>(key));
+        unsigned i = 0;
+        for (; i + ELEM_NUM <= key_num; i += ELEM_NUM)
+        {
+            const VectorType keys =
+                    LoadKeys<VectorType>(node, i, BoolType<Node::IS_SPLIT_LAYOUT>());
+            const int less_mask = key_vector.IsGreater(keys).MoveMask();
+            if (less_mask != ALL_LESS_MASK)
+            {
+                return i + static_cast<unsigned>(__builtin_popcount(less_mask)) /
+                        sizeof(ElemType);
+            }
+        }
+
+        while (i < key_num && compare(node.GetKey(i), key))
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    // the keys from i, which is a multiple of the number of keys per vector
+    template<typename VectorType>
+    static VectorType LoadKeys(const Node& node, const unsigned i, BoolType<true>)
+    {
+        typedef typename VectorType::ElemType ElemType;
+        return VectorType::Load(reinterpret_cast<const ElemType*>(node.GetKeys() + i));
+    }
+
+    template<typename VectorType>
+    static VectorType LoadKeys(const Node& node, const unsigned i, BoolType<false>)
+    {
+        typedef typename VectorType::ElemType ElemType;
+        VectorType keys;
+        for (unsigned j = 0; j < VectorType::ElemNum; ++j)
+        {
+            keys[j] = static_cast<ElemType>(node.GetKey(i + j));
+        }
+        return keys;
+    }
+};
+
+// The number of items of ItemSize bytes fitting in NodeSize bytes with
+// a child pointer each, after the HeaderSize bytes of the other members
+// of the node, rounded down to an odd number, so that a full node splits
+// into two halves and a middle key. NodeSize is then the size of the
+// whole node, e.g. 8 cache lines, unless it is too small for 3 keys.
+template<unsigned int NodeSize, unsigned int ItemSize, unsigned int HeaderSize = 0>
+struct BTreeMaxKeyNum
+{
+    enum { USABLE_SIZE = NodeSize > HeaderSize + sizeof(void*) ?
+                         NodeSize - HeaderSize - sizeof(void*) : 0,
+           FIT_NUM = USABLE_SIZE / (ItemSize + sizeof(void*)),
+           Result = FIT_NUM > 3 ? ((FIT_NUM - 1) | 1) : 3 };
+};
+
+// The members of BTreeNode besides the items and the children: the
+// subtree size, the key counts and the leaf flag padded to a word.
+enum { BTREE_NODE_HEADER_SIZE = sizeof(::std::size_t) + 2 * sizeof(unsigned int) +
+                                sizeof(void*) };
+
+// The keys and values of a node of NodeSize bytes in Layout.
+template<typename KType, typename VType, unsigned int NodeSize, typename Layout>
+class BTreeNodeItems;
+
+template<typename KType, typename VType, unsigned int NodeSize>
+class BTreeNodeItems<KType, VType, NodeSize, BTreePairLayout>
+{
+public:
+    enum { MAX_KEY_NUM = BTreeMaxKeyNum<NodeSize, sizeof(::std::pair<KType, VType>),
+                                        BTREE_NODE_HEADER_SIZE>::Result };
+    enum { IS_SPLIT_LAYOUT = false };
+
+    const KType& GetKey(const unsigned i) const { return m_elements[i].first; }
+    const VType& GetValue(const unsigned i) const { return m_elements[i].second; }
+    VType& GetValue(const unsigned i) { return m_elements[i].second; }
+
+    void SetItem(const unsigned i, typename ParamTrait<const KType>::DeclType key,
+                 const VType& value)
+    {
+        m_elements[i].first = key;
+        m_elements[i].second = value;
+    }
+
+    void CopyItem(const unsigned i, const BTreeNodeItems& other, const unsigned j)
+    {
+        m_elements[i] = other.m_elements[j];
+    }
+
+private:
+    ::std::pair<KType, VType> m_elements[MAX_KEY_NUM];
+};
+
+// The values are an array of GetMaxKeyNum() values given by SetValues(),
+// which the BTree allocates with the node. The keys are 16 bytes aligned
+// for the simdple loads.
+template<typename KType, typename VType, unsigned int NodeSize>
+class BTreeNodeItems<KType, VType, NodeSize, BTreeSplitLayout>
 {
+public:
+    // the values pointer and the padding of the 16 bytes aligned keys
+    enum { MAX_KEY_NUM = BTreeMaxKeyNum<NodeSize, sizeof(KType),
+                                        BTREE_NODE_HEADER_SIZE + sizeof(void*) + 15>::Result };
+    enum { IS_SPLIT_LAYOUT = true };
+
+    BTreeNodeItems() : m_values(NULL) {}
+
+    const KType& GetKey(const unsigned i) const { return m_keys[i]; }
+    const VType& GetValue(const unsigned i) const { return m_values[i]; }
+    VType& GetValue(const unsigned i) { return m_values[i]; }
+
+    void SetItem(const unsigned i, typename ParamTrait<const KType>::DeclType key,
+                 const VType& value)
+    {
+        m_keys[i] = key;
+        m_values[i] = value;
+    }
+
+    void CopyItem(const unsigned i, const BTreeNodeItems& other, const unsigned j)
+    {
+        m_keys[i] = other.m_keys[j];
+        m_values[i] = other.m_values[j];
+    }
+
+    const KType* GetKeys() const { return m_keys; }
+    VType* GetValues() const { return m_values; }
+    void SetValues(VType* values) { m_values = values; }
+
+private:
+    alignas(16) KType m_keys[MAX_KEY_NUM];
+    VType* m_values;
+};
+
+// A node of at most GetMaxKeyNum() keys, which is odd and no more than
+// MAX_KEY_NUM, the number of keys fitting in NodeSize bytes in Layout.
+// The nodes are allocated and freed by the BTree, and the keys are
+// compared with the Compare given to the methods.
+//
+// Every node keeps GetSize(), the number of keys in its subtree, which
+// the methods moving keys between the nodes keep up to date.
+template<typename KType, typename VType, unsigned int NodeSize = 512,
+         typename Layout = BTreePairLayout>
+class BTreeNode : public BTreeNodeItems<KType, VType, NodeSize, Layout>
+{
+    typedef BTreeNodeItems<KType, VType, NodeSize, Layout> Items;
+
 public:
     typedef KType KeyType;
     typedef typename ParamTrait<const KeyType>::DeclType KeyDeclType;
     typedef VType ValueType;
-    typedef std::pair<KeyType, ValueType> Elem;
+    typedef Layout LayoutType;
 
-    static const unsigned int MAX_KEY_NUM =
-            (NodeSize - sizeof(BTreeNode*)) / (sizeof(Elem) + sizeof(BTreeNode*));
+    static const unsigned int MAX_KEY_NUM = Items::MAX_KEY_NUM;
     static const unsigned int CHILDREN_SIZE = MAX_KEY_NUM + 1;
 
-    /// max_key_num should be an odd number
+    using Items::GetKey;
+    using Items::GetValue;
+    using Items::SetItem;
+    using Items::CopyItem;
+
+    /// max_key_num should be an odd number no more than MAX_KEY_NUM
     BTreeNode(const unsigned max_key_num)
-    : m_key_num(0), m_is_leave(true)
+    : m_size(0), m_max_key_num(max_key_num), m_key_num(0), m_is_leave(true)
     {
         memset(m_children, 0, CHILDREN_SIZE * sizeof(m_children[0]));
     }
 
-    ~BTreeNode()
+    void SetIsLeave(const bool is_leave)
     {
-        if (m_key_num > 0)
-        {
-            for (unsigned i = 0; i <= m_key_num; ++i)
-            {
-                delete m_children[i];
-            }
-        }
+        m_is_leave = is_leave;
     }
 
-    void SetIsLeave(const bool is_leave)
+    /// the number of keys in the subtree
+    ::std::size_t GetSize() const
     {
-        m_is_leave = is_leave;
+        return m_size;
     }
 
-    void AddItem(const KeyType key, const ValueType& value)
+    void SetSize(const ::std::size_t size)
     {
-        // TODO: add implementation
+        m_size = size;
     }
 
-    unsigned GetSize() const
+    /// the number of keys in the subtrees of the children [first, last)
+    ::std::size_t GetChildrenSize(const unsigned first, const unsigned last) const
     {
-        unsigned total_key_num = GetKeyNum();
-        if (total_key_num > 0 && !IsLeave())
+        ::std::size_t size = 0;
+        if (!IsLeave())
         {
-            for (unsigned i = 0; i <= GetKeyNum(); ++i)
+            for (unsigned i = first; i < last; ++i)
             {
-                const BTreeNode* child = GetChild(i);
-                if (child)
-                {
-                    total_key_num += child->GetSize();
-                }
+                size += m_children[i]->m_size;
             }
         }
-
-        return total_key_num;
+        return size;
     }
 
     void Dump(const int level) const
@@ -99,7 +373,7 @@ public:
 
     unsigned GetMaxKeyNum() const
     {
-        return MAX_KEY_NUM;
+        return m_max_key_num;
     }
 
     unsigned GetKeyNum() const
@@ -107,13 +381,6 @@ public:
         return m_key_num;
     }
 
-    /// get the key at index i, if i >= m_key_num,
-    /// the result is undefined.
-    inline KeyType GetKey(const unsigned i) const
-    {
-        return m_elements[i].first;
-    }
-
     inline bool IsLeave() const { return m_is_leave; }
 
     /// get the child at index i, if i > m_key_num,
@@ -123,18 +390,17 @@ public:
         return i <= m_key_num ? m_children[i] : NULL;
     }
 
-    void SplitChild(const unsigned i, BTreeNode& child)
+    /// move the upper half of the full child at index i to new_child,
+    /// which is empty, and its middle key up to this node.
+    void SplitChild(const unsigned i, BTreeNode& child, BTreeNode* new_child)
     {
-        const unsigned max_key_num = MAX_KEY_NUM;
-        const unsigned min_key_num = max_key_num / 2;
-        BTreeNode* new_child = new BTreeNode(max_key_num);
+        const unsigned min_key_num = m_max_key_num / 2;
         new_child->SetIsLeave(child.IsLeave());
 
         new_child->SetKeyNum(min_key_num);
         for (unsigned j = 0; j < min_key_num; ++j)
         {
-            const Elem& e = child.m_elements[min_key_num + 1 + j];
-            new_child->SetItem(j, e.first, e.second);
+            new_child->CopyItem(j, child, min_key_num + 1 + j);
         }
 
         if (!child.IsLeave())
@@ -144,6 +410,8 @@ public:
                 new_child->m_children[j] = child.m_children[min_key_num + 1 + j];
             }
         }
+        new_child->m_size = min_key_num + new_child->GetChildrenSize(0, min_key_num + 1);
+        child.m_size -= new_child->m_size + 1;
 
         child.SetKeyNum(min_key_num);
         for (unsigned j = GetKeyNum(); j > i; --j)
@@ -155,68 +423,68 @@ public:
         for (int j = static_cast<int>(GetKeyNum()) - 1;
              j >= static_cast<int>(i); --j)
         {
-            m_elements[j + 1] = m_elements[j];
+            CopyItem(j + 1, *this, j);
         }
-        m_elements[i] = child.m_elements[min_key_num];
+        CopyItem(i, child, min_key_num);
         ++m_key_num;
     }
 
-    void InsertNonfull(const KeyType key, const ValueType& value)
+    /// insert the key, which is not in the subtree, into this node which
+    /// is not full. The full children on the way are split with new nodes
+    /// from tree.NewNode().
+    template<typename Compare, typename Tree>
+    void InsertNonfull(KeyDeclType key, const ValueType& value,
+                       const Compare& compare, Tree& tree)
     {
-        int i = static_cast<int>(GetKeyNum()) - 1;
+        unsigned i = LowerBound(key, compare);
+        ++m_size;
         if (IsLeave())
         {
-            while (i >= 0 && key < GetKey(static_cast<unsigned>(i)))
+            for (unsigned j = m_key_num; j > i; --j)
             {
-                m_elements[i + 1] = m_elements[i];
-                --i;
+                CopyItem(j, *this, j - 1);
             }
-            SetItem(static_cast<unsigned>(i) + 1, key, value);
+            SetItem(i, key, value);
             ++m_key_num;
         }
         else
         {
-            while (i >= 0 && key < GetKey(static_cast<unsigned>(i)))
-            {
-                --i;
-            }
-            ++i;
             BTreeNode* child = m_children[i];
-            if (child->GetKeyNum() == MAX_KEY_NUM)
+            if (child->GetKeyNum() == m_max_key_num)
             {
-                SplitChild(static_cast<unsigned>(i), *child);
-                if (key > GetKey(static_cast<unsigned>(i)))
+                SplitChild(i, *child, tree.NewNode());
+                if (compare(GetKey(i), key))
                 {
                     ++i;
                 }
             }
-            m_children[i]->InsertNonfull(key, value);
+            m_children[i]->InsertNonfull(key, value, compare, tree);
         }
     }
 
-    bool Find(const KeyType key, unsigned* idx) const
+    /// idx is set to the index of the first key not less than key.
+    template<typename Compare>
+    bool Find(KeyDeclType key, unsigned* idx, const Compare& compare) const
     {
-        KeyType cur_key;
-        // TODO: use lower bound here
-        for (unsigned i = 0; i < m_key_num; ++i)
-        {
-            cur_key = GetKey(i);
-            if (key <= cur_key)
-            {
-                *idx = i;
-                return key == cur_key;
-            }
-        }
-        *idx = m_key_num;
-        return false;
+        const unsigned i = LowerBound(key, compare);
+        *idx = i;
+        return i < m_key_num && !compare(key, GetKey(i));
+    }
+
+    /// the index of the first key not less than key, or GetKeyNum(),
+    /// see BTreeNodeSearch.
+    template<typename Compare>
+    unsigned LowerBound(KeyDeclType key, const Compare& compare) const
+    {
+        return BTreeNodeSearch<BTreeNode, Compare>::LowerBound(*this, key, compare);
     }
 
     void GetMaxKeyItem(KeyType* key, ValueType* value) const
     {
         if (IsLeave())
         {
-            *key = m_elements[m_key_num - 1].first;
-            *value = m_elements[m_key_num - 1].second;
+            *key = GetKey(m_key_num - 1);
+            *value = GetValue(m_key_num - 1);
         }
         else
         {
@@ -228,8 +496,8 @@ public:
     {
         if (IsLeave())
         {
-            *key = m_elements[0].first;
-            *value = m_elements[0].second;
+            *key = GetKey(0);
+            *value = GetValue(0);
         }
         else
         {
@@ -237,15 +505,19 @@ public:
         }
     }
 
+    /// delete the key at idx of a leave.
     void Delete(const unsigned idx)
     {
         for (unsigned i = idx + 1; i < m_key_num; ++i)
         {
-            m_elements[i - 1] = m_elements[i];
+            CopyItem(i - 1, *this, i);
         }
         --m_key_num;
+        --m_size;
     }
 
+    /// merge the child at idx + 1 and the key at idx into the child at idx.
+    /// The child at idx + 1 is left empty, to be freed by the caller.
     BTreeNode* MergeChildren(const unsigned idx)
     {
         BTreeNode* first_child = m_children[idx];
@@ -254,11 +526,10 @@ public:
         const unsigned second_old_key_num = second_child->m_key_num;
 
         // merge keys and values
-        first_child->m_elements[first_old_key_num] = m_elements[idx];
+        first_child->CopyItem(first_old_key_num, *this, idx);
         for (unsigned i = 0; i < second_old_key_num; ++i)
         {
-            first_child->m_elements[first_old_key_num + 1 + i] =
-                    second_child->m_elements[i];
+            first_child->CopyItem(first_old_key_num + 1 + i, *second_child, i);
         }
 
         // merge the children
@@ -268,11 +539,12 @@ public:
                                   second_child->m_children[i]);
         }
         first_child->m_key_num += second_old_key_num + 1;
+        first_child->m_size += second_child->m_size + 1;
 
         // move the key backward in the parent.
         for (unsigned i = idx; i < m_key_num - 1; ++i)
         {
-            m_elements[i] = m_elements[i + 1];
+            CopyItem(i, *this, i + 1);
         }
 
         // move the children backward in the parent
@@ -282,9 +554,8 @@ public:
         }
         --m_key_num;
 
-        second_child->SetKeyNum(0); // we have to reset before deleting
-        delete second_child;
-
+        second_child->SetKeyNum(0);
+        second_child->m_size = 0;
         return first_child;
     }
 
@@ -295,15 +566,18 @@ public:
         const unsigned left_key_num = left_child->GetKeyNum();
         const unsigned right_key_num = right_child->GetKeyNum();
 
-        left_child->m_elements[left_key_num] = m_elements[idx];
+        const ::std::size_t moved_size = 1 + right_child->GetChildrenSize(0, 1);
+        left_child->CopyItem(left_key_num, *this, idx);
         left_child->m_children[left_key_num + 1] = right_child->m_children[0];
         ++(left_child->m_key_num);
+        left_child->m_size += moved_size;
+        right_child->m_size -= moved_size;
 
-        m_elements[idx] = right_child->m_elements[0];
+        CopyItem(idx, *right_child, 0);
 
         for (unsigned i = 0; i < right_key_num - 1; ++i)
         {
-            right_child->m_elements[i] = right_child->m_elements[i + 1];
+            right_child->CopyItem(i, *right_child, i + 1);
             right_child->m_children[i] = right_child->m_children[i + 1];
         }
         right_child->m_children[right_key_num - 1] =
@@ -318,24 +592,29 @@ public:
         const unsigned left_key_num = left_child->GetKeyNum();
         const unsigned right_key_num = right_child->GetKeyNum();
 
+        const ::std::size_t moved_size =
+                1 + left_child->GetChildrenSize(left_key_num, left_key_num + 1);
+        left_child->m_size -= moved_size;
+        right_child->m_size += moved_size;
+
         for (unsigned i = right_key_num; i > 0; --i)
         {
-            right_child->m_elements[i] = right_child->m_elements[i - 1];
+            right_child->CopyItem(i, *right_child, i - 1);
             right_child->m_children[i + 1] = right_child->m_children[i];
         }
         right_child->m_children[1] = right_child->m_children[0];
-        right_child->m_elements[0] = m_elements[idx];
+        right_child->CopyItem(0, *this, idx);
         right_child->m_children[0] = left_child->m_children[left_key_num];
         ++(right_child->m_key_num);
 
-        m_elements[idx] = left_child->m_elements[left_key_num - 1];
+        CopyItem(idx, *left_child, left_key_num - 1);
 
         --(left_child->m_key_num);
     }
 
     void SetKeyNum(const unsigned key_num)
     {
-        m_key_num = key_num <= 1024 ? key_num : 1024;
+        m_key_num = key_num <= MAX_KEY_NUM ? key_num : MAX_KEY_NUM;
     }
 
     void SetChild(const unsigned i, BTreeNode* child)
@@ -343,39 +622,72 @@ public:
         m_children[i] = child;
     }
 
-    void SetItem(const unsigned i, const KeyType key, const ValueType& value)
-    {
-        m_elements[i].first = key;
-        m_elements[i].second = value;
-    }
-
 private:
-    Elem m_elements[MAX_KEY_NUM];
     BTreeNode* m_children[CHILDREN_SIZE];
+    ::std::size_t m_size;
+    const unsigned int m_max_key_num;
     unsigned int m_key_num;
     bool m_is_leave;
 };
 
+template<typename KType, typename VType, unsigned int NodeSize, typename Layout>
+const unsigned int BTreeNode<KType, VType, NodeSize, Layout>::MAX_KEY_NUM;
+
+template<typename KType, typename VType, unsigned int NodeSize, typename Layout>
+const unsigned int BTreeNode<KType, VType, NodeSize, Layout>::CHILDREN_SIZE;
+
 }  // namespace detail
 
 
+// An ordered map of Key to Value, with nodes of NodeSize bytes.
+// The keys are unique, and ordered by Compare like in std::map.
+//
+// max_key_num limits the keys per node, it is rounded down to an odd
+// number not less than 3. It is BTreeNode::MAX_KEY_NUM if 0 or too big.
+//
+// Layout is BTreePairLayout or BTreeSplitLayout. The latter fits more
+// keys in a node when the values are big, at the cost of an array of
+// values allocated along with every node.
+//
+// The nodes come from Allocator rebound to BTreeNode. A
+// PoolAllocator<Key, 64> hands out cache line aligned nodes and reuses
+// the freed ones, and the whole tree is dropped at once by the destructor
+// and Clear() when the nodes need no destruction. It is not the default,
+// as it is no faster on a churn of deletes and inserts.
+template<typename Key, typename Value,
+         typename Compare = ::std::less<Key>,
+         unsigned int NodeSize = 512,
+         typename Allocator = ::std::allocator<Key>,
+         typename Layout = BTreePairLayout>
 class BTree
 {
 public:
-    typedef detail::BTreeNode<int, ::std::string> BTreeNode;
-
-    BTree(const unsigned max_key_num)
+    typedef detail::BTreeNode<Key, Value, NodeSize, Layout> BTreeNode;
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Compare key_compare;
+    typedef Allocator allocator_type;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<BTreeNode>
+            NodeAllocator;
+
+    explicit BTree(const unsigned max_key_num = 0,
+                   const Compare& compare = Compare(),
+                   const Allocator& alloc = Allocator())
+    : m_impl(NodeAllocator(alloc), compare)
+    , m_max_key_num(GetMaxKeyNum(max_key_num))
+    , m_root(NewNode())
     {
-        m_root = new BTreeNode(max_key_num);
         m_root->SetIsLeave(true);
     }
 
     ~BTree()
     {
-        delete m_root;
+        FreeAllNodes();
     }
 
-    unsigned GetSize() const
+    // The number of keys, kept by the root like by every node for its
+    // subtree. Same as size().
+    ::std::size_t GetSize() const
     {
         return m_root->GetSize();
     }
@@ -386,73 +698,490 @@ public:
         m_root->Dump(0);
     }
 
-    bool Find(const int key, BTreeNode** out_node, int* out_index) const
+    bool Find(typename ParamTrait<const Key>::DeclType key,
+              BTreeNode** out_node, int* out_index) const
     {
         return Find(*m_root, key, out_node, out_index);
     }
 
-    void Insert(const int key, const std::string& value)
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        BTreeNode* node = NULL;
+        int index = 0;
+        if (Find(*m_root, key, &node, &index))
+        {
+            value = node->GetValue(static_cast<unsigned>(index));
+            return true;
+        }
+        return false;
+    }
+
+    // The number of keys less than key, in O(log n).
+    //
+    // Every level adds the sizes of the children on the left of the path,
+    // or takes the ones on the right off the size of the node, whichever
+    // are fewer.
+    ::std::size_t Rank(typename ParamTrait<const Key>::DeclType key) const
+    {
+        ::std::size_t rank = 0;
+        const BTreeNode* node = m_root;
+        while (true)
+        {
+            const unsigned key_num = node->GetKeyNum();
+            const unsigned i = node->LowerBound(key, GetCompare());
+            const bool is_found = i < key_num && !GetCompare()(key, node->GetKey(i));
+            if (node->IsLeave())
+            {
+                return rank + i;
+            }
+
+            const BTreeNode* child = node->GetChild(i);
+            if (i <= key_num / 2)
+            {
+                rank += i + node->GetChildrenSize(0, i);
+            }
+            else
+            {
+                rank += node->GetSize() - child->GetSize() - (key_num - i) -
+                        node->GetChildrenSize(i + 1, key_num + 1);
+            }
+
+            if (is_found)
+            {
+                return rank + child->GetSize();
+            }
+            node = child;
+        }
+    }
+
+    // Get the key and value of rank k, i.e. with k keys less than it,
+    // in O(log n). Returns false if k is not less than size().
+    bool Select(::std::size_t k, Key* key, Value* value) const
+    {
+        if (k >= GetSize())
+        {
+            return false;
+        }
+
+        const BTreeNode* node = m_root;
+        while (!node->IsLeave())
+        {
+            unsigned i = 0;
+            ::std::size_t child_size = node->GetChild(0)->GetSize();
+            while (k > child_size)
+            {
+                k -= child_size + 1;
+                child_size = node->GetChild(++i)->GetSize();
+            }
+
+            if (k == child_size)
+            {
+                *key = node->GetKey(i);
+                *value = node->GetValue(i);
+                return true;
+            }
+            node = node->GetChild(i);
+        }
+        *key = node->GetKey(static_cast<unsigned>(k));
+        *value = node->GetValue(static_cast<unsigned>(k));
+        return true;
+    }
+
+    // The number of keys in [from, to), in O(log n).
+    ::std::size_t CountRange(typename ParamTrait<const Key>::DeclType from,
+                             typename ParamTrait<const Key>::DeclType to) const
+    {
+        if (!GetCompare()(from, to))
+        {
+            return 0;
+        }
+        return Rank(to) - Rank(from);
+    }
+
+    // Returns false and keeps the old value if key is already present.
+    bool Insert(typename ParamTrait<const Key>::DeclType key, const Value& value)
     {
-        const unsigned max_key_num = m_root->GetMaxKeyNum();
-        if (m_root->GetKeyNum() == max_key_num)
+        if (Find(*m_root, key, NULL, NULL))
+        {
+            return false;
+        }
+
+        if (m_root->GetKeyNum() == m_max_key_num)
         {
             BTreeNode* old_root = m_root;
-            m_root = new BTreeNode(max_key_num);
+            m_root = NewNode();
             m_root->SetIsLeave(false);
             m_root->SetKeyNum(0);
             m_root->SetChild(0, old_root);
-            m_root->SplitChild(0, *old_root);
-            m_root->InsertNonfull(key, value);
-        }
-        else
-        {
-            m_root->InsertNonfull(key, value);
+            m_root->SetSize(old_root->GetSize());
+            m_root->SplitChild(0, *old_root, NewNode());
         }
+        m_root->InsertNonfull(key, value, GetCompare(), *this);
+        return true;
     }
 
-    void Delete(const int key)
+    // Returns false if key is not present.
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
     {
         if (m_root->GetKeyNum() == 0)
         {
-            return;
+            return false;
         }
         else if (m_root->GetKeyNum() == 1 && !m_root->IsLeave())
         {
             BTreeNode* first_child = m_root->GetChild(0);
             BTreeNode* second_child = m_root->GetChild(1);
-            const unsigned min_key_num = m_root->GetMaxKeyNum() / 2;
+            const unsigned min_key_num = m_max_key_num / 2;
 
             if (first_child->GetKeyNum() == min_key_num &&
                 second_child->GetKeyNum() == min_key_num)
             {
                 first_child = m_root->MergeChildren(0);
+                FreeNode(second_child);
                 m_root->SetKeyNum(0);
-                delete m_root;
+                FreeNode(m_root);
                 m_root = first_child;
-                Delete(*m_root, key);
             }
-            else
+        }
+
+        return Delete(*m_root, key);
+    }
+
+    // Call visitor(key, value) for every entry in the order of the keys.
+    template<typename Visitor>
+    void ForEach(Visitor& visitor) const
+    {
+        ForEach(*m_root, visitor);
+    }
+
+    void Clear()
+    {
+        FreeAllNodes();
+        m_root = NewNode();
+        m_root->SetIsLeave(true);
+    }
+
+    // Replace the entries with the key/value pairs in [first, last), which
+    // are sorted by Compare without duplicate keys, in O(n).
+    //
+    // The nodes are built a level at a time from the leaves up, with
+    // fill_factor of GetMaxKeyNum() keys each, but no less than half.
+    // Every node of a level is a run of the items, and the item between
+    // two nodes goes up to the level above. The runs of nodes of a level
+    // are filled on thread_num threads.
+    //
+    // The old entries are only freed once the new tree is complete. If
+    // building it throws, the nodes built so far are freed and the old
+    // entries are kept.
+    template<typename RandomAccessIterator>
+    void BulkLoad(RandomAccessIterator first, RandomAccessIterator last,
+                  const double fill_factor = 1.0, const unsigned thread_num = 1)
+    {
+        const unsigned fill_key_num = GetFillKeyNum(fill_factor);
+        ::std::vector<BTreeNode*> built_nodes;
+        ::std::vector<BTreeNode*> nodes;
+        try
+        {
+            ::std::vector<Item> separators;
+            BuildLevel(first, static_cast< ::std::size_t>(last - first), fill_key_num,
+                       thread_num, &nodes, &separators, &built_nodes);
+            while (nodes.size() > 1)
             {
-                Delete(*m_root, key);
+                ::std::vector<Item> items;
+                items.swap(separators);
+                BuildLevel(items.begin(), items.size(), fill_key_num, thread_num,
+                           &nodes, &separators, &built_nodes);
             }
         }
-        else
+        catch (...)
         {
-            Delete(*m_root, key);
+            // one by one, as the levels may be partly linked
+            for (::std::size_t i = 0; i < built_nodes.size(); ++i)
+            {
+                FreeNode(built_nodes[i]);
+            }
+            throw;
         }
+
+        FreeAllNodes();
+        m_root = nodes[0];
+    }
+
+    unsigned GetMaxKeyNum() const { return m_max_key_num; }
+
+    NodeAllocator& GetNodeAllocator() { return m_impl; }
+    const NodeAllocator& GetNodeAllocator() const { return m_impl; }
+
+    // STL compatible methods
+    ::std::size_t size() const { return GetSize(); }
+    bool empty() const { return GetSize() == 0; }
+    void clear() { Clear(); }
+    key_compare key_comp() const { return GetCompare(); }
+    allocator_type get_allocator() const { return allocator_type(GetNodeAllocator()); }
+
+    // for BTreeNode::InsertNonfull
+    BTreeNode* NewNode()
+    {
+        BTreeNode* node = NodeAllocatorTraits::allocate(GetNodeAllocator(), 1);
+        (void) new (node) BTreeNode(m_max_key_num);
+        NewValues(node, BoolType<BTreeNode::IS_SPLIT_LAYOUT>());
+        return node;
     }
 
 private:
-    bool Find(BTreeNode& node, const int key,
-              BTreeNode** out_node, int* out_index) const
+    typedef ::std::allocator_traits<NodeAllocator> NodeAllocatorTraits;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Value>
+            ValueAllocator;
+    typedef ::std::allocator_traits<ValueAllocator> ValueAllocatorTraits;
+    typedef BoolType<IsTriviallyDestructible<Key>::Result &&
+                     IsTriviallyDestructible<Value>::Result &&
+                     !BTreeNode::IS_SPLIT_LAYOUT> IsTrivialNode;
+    typedef BoolType<IsBulkReleaseAllocator<NodeAllocator>::Result> IsBulkRelease;
+
+    static unsigned GetMaxKeyNum(const unsigned max_key_num)
+    {
+        if (max_key_num == 0 || max_key_num >= BTreeNode::MAX_KEY_NUM)
+        {
+            return BTreeNode::MAX_KEY_NUM;
+        }
+        return max_key_num > 3 ? ((max_key_num - 1) | 1) : 3;
+    }
+
+    const Compare& GetCompare() const { return m_impl; }
+
+    typedef ::std::pair<Key, Value> Item;
+
+    unsigned GetFillKeyNum(const double fill_factor) const
+    {
+        const unsigned min_key_num = m_max_key_num / 2;
+        const unsigned fill_key_num = static_cast<unsigned>(fill_factor * m_max_key_num);
+        if (fill_key_num < min_key_num)
+        {
+            return min_key_num;
+        }
+        return fill_key_num < m_max_key_num ? fill_key_num : m_max_key_num;
+    }
+
+    // The nodes of a level of item_num items, fill_key_num keys per node
+    // if the nodes can have at least half and at most all of
+    // m_max_key_num keys, as in any level but the root.
+    ::std::size_t GetLevelNodeNum(const ::std::size_t item_num,
+                                  const unsigned fill_key_num) const
+    {
+        if (item_num <= m_max_key_num)
+        {
+            return 1;
+        }
+
+        const ::std::size_t min_key_num = m_max_key_num / 2;
+        const ::std::size_t node_num = (item_num + 1 + fill_key_num) / (fill_key_num + 1);
+        const ::std::size_t max_node_num = (item_num + 1) / (min_key_num + 1);
+        const ::std::size_t min_node_num =
+                (item_num + 1 + m_max_key_num) / (m_max_key_num + 1);
+        return ::std::max(min_node_num, ::std::min(max_node_num, node_num));
+    }
+
+    // Build the nodes of a level out of item_num items, linking the nodes
+    // of the level below, which are replaced by the new ones. Every new
+    // node is also added to built_nodes, to be freed if building throws.
+    template<typename ItemIterator>
+    void BuildLevel(ItemIterator items, const ::std::size_t item_num,
+                    const unsigned fill_key_num, const unsigned thread_num,
+                    ::std::vector<BTreeNode*>* nodes, ::std::vector<Item>* separators,
+                    ::std::vector<BTreeNode*>* built_nodes)
+    {
+        ::std::vector<BTreeNode*> level_nodes(GetLevelNodeNum(item_num, fill_key_num));
+        built_nodes->reserve(built_nodes->size() + level_nodes.size());
+        for (::std::size_t i = 0; i < level_nodes.size(); ++i)
+        {
+            level_nodes[i] = NewNode();
+            built_nodes->push_back(level_nodes[i]);
+            level_nodes[i]->SetIsLeave(nodes->empty());
+        }
+        separators->resize(level_nodes.size() - 1);
+
+        BuildLevelTask<ItemIterator> task(items, item_num, *nodes, level_nodes, *separators,
+                                          thread_num);
+        RunInParallel(task.thread_num, task);
+        nodes->swap(level_nodes);
+    }
+
+    template<typename ItemIterator>
+    struct BuildLevelTask
+    {
+        BuildLevelTask(ItemIterator i, const ::std::size_t num,
+                       const ::std::vector<BTreeNode*>& c, ::std::vector<BTreeNode*>& n,
+                       ::std::vector<Item>& s, const unsigned t)
+        : items(i), item_num(num), children(c), nodes(n), separators(s)
+        , thread_num(t == 0 ? 1 : (t < n.size() ? t : static_cast<unsigned>(n.size())))
+        {}
+
+        void operator()(const unsigned thread_index)
+        {
+            const ::std::size_t node_num = nodes.size();
+            const ::std::size_t key_num = item_num - (node_num - 1);
+            ::std::size_t first_node = 0;
+            ::std::size_t last_node = 0;
+            GetPartition(node_num, thread_num, thread_index, &first_node, &last_node);
+            for (::std::size_t j = first_node; j < last_node; ++j)
+            {
+                // the keys of node j, after the separators of the nodes before
+                ::std::size_t first = 0;
+                ::std::size_t last = 0;
+                GetPartition(key_num, static_cast<unsigned>(node_num),
+                             static_cast<unsigned>(j), &first, &last);
+                first += j;
+                last += j;
+
+                BTreeNode* node = nodes[j];
+                for (::std::size_t i = first; i < last; ++i)
+                {
+                    node->SetItem(static_cast<unsigned>(i - first),
+                                  items[i].first, items[i].second);
+                }
+                node->SetKeyNum(static_cast<unsigned>(last - first));
+                if (!children.empty())
+                {
+                    for (::std::size_t i = first; i <= last; ++i)
+                    {
+                        node->SetChild(static_cast<unsigned>(i - first), children[i]);
+                    }
+                }
+                node->SetSize(node->GetKeyNum() +
+                              node->GetChildrenSize(0, node->GetKeyNum() + 1));
+
+                if (j + 1 < node_num)
+                {
+                    separators[j] = Item(items[last].first, items[last].second);
+                }
+            }
+        }
+
+        ItemIterator items;
+        const ::std::size_t item_num;
+        const ::std::vector<BTreeNode*>& children;
+        ::std::vector<BTreeNode*>& nodes;
+        ::std::vector<Item>& separators;
+        const unsigned thread_num;
+    };
+
+    void FreeNode(BTreeNode* node)
+    {
+        FreeValues(node, BoolType<BTreeNode::IS_SPLIT_LAYOUT>());
+        node->~BTreeNode();
+        NodeAllocatorTraits::deallocate(GetNodeAllocator(), node, 1);
+    }
+
+    // the values of a node in BTreeSplitLayout
+    void NewValues(BTreeNode* node, BoolType<true>)
+    {
+        ValueAllocator alloc(GetNodeAllocator());
+        Value* values = ValueAllocatorTraits::allocate(alloc, m_max_key_num);
+        for (unsigned i = 0; i < m_max_key_num; ++i)
+        {
+            ValueAllocatorTraits::construct(alloc, values + i);
+        }
+        node->SetValues(values);
+    }
+
+    void NewValues(BTreeNode*, BoolType<false>) {}
+
+    void FreeValues(BTreeNode* node, BoolType<true>)
+    {
+        ValueAllocator alloc(GetNodeAllocator());
+        Value* values = node->GetValues();
+        for (unsigned i = 0; i < m_max_key_num; ++i)
+        {
+            ValueAllocatorTraits::destroy(alloc, values + i);
+        }
+        ValueAllocatorTraits::deallocate(alloc, values, m_max_key_num);
+    }
+
+    void FreeValues(BTreeNode*, BoolType<false>) {}
+
+    void FreeAllNodes()
+    {
+        FreeAllNodes(IsTrivialNode(), IsBulkRelease());
+    }
+
+    // Nothing to walk: the allocator frees every node at once, unless
+    // other allocators share its pool.
+    void FreeAllNodes(BoolType<true>, BoolType<true>)
+    {
+        if (GetNodeAllocator().IsPoolShared())
+        {
+            FreeNodes(m_root);
+            return;
+        }
+        GetNodeAllocator().Release();
+    }
+
+    void FreeAllNodes(BoolType<false>, BoolType<true>)
+    {
+        if (GetNodeAllocator().IsPoolShared())
+        {
+            FreeNodes(m_root);
+            return;
+        }
+        DestroyNodes(m_root);
+        GetNodeAllocator().Release();
+    }
+
+    template<typename IsTrivial>
+    void FreeAllNodes(IsTrivial, BoolType<false>)
+    {
+        FreeNodes(m_root);
+    }
+
+    void FreeNodes(BTreeNode* node)
+    {
+        if (!node->IsLeave())
+        {
+            for (unsigned i = 0; i <= node->GetKeyNum(); ++i)
+            {
+                FreeNodes(node->GetChild(i));
+            }
+        }
+        FreeNode(node);
+    }
+
+    // Like FreeNodes(), but leaves the memory of the nodes to Release().
+    void DestroyNodes(BTreeNode* node)
+    {
+        if (!node->IsLeave())
+        {
+            for (unsigned i = 0; i <= node->GetKeyNum(); ++i)
+            {
+                DestroyNodes(node->GetChild(i));
+            }
+        }
+        FreeValues(node, BoolType<BTreeNode::IS_SPLIT_LAYOUT>());
+        node->~BTreeNode();
+    }
+
+    template<typename Visitor>
+    static void ForEach(const BTreeNode& node, Visitor& visitor)
     {
         const unsigned key_num = node.GetKeyNum();
-        unsigned i = 0;
-        while (i < key_num && key > node.GetKey(i))
+        for (unsigned i = 0; i < key_num; ++i)
         {
-            ++i;
+            if (!node.IsLeave())
+            {
+                ForEach(*node.GetChild(i), visitor);
+            }
+            visitor(node.GetKey(i), node.GetValue(i));
         }
-        if (i < key_num && key == node.GetKey(i))
+        if (!node.IsLeave() && key_num > 0)
+        {
+            ForEach(*node.GetChild(key_num), visitor);
+        }
+    }
+
+    bool Find(BTreeNode& node, typename ParamTrait<const Key>::DeclType key,
+              BTreeNode** out_node, int* out_index) const
+    {
+        unsigned i = 0;
+        if (node.Find(key, &i, GetCompare()))
         {
             if (out_node)
             {
@@ -473,51 +1202,54 @@ private:
         }
     }
 
-    void Delete(BTreeNode& node, const int key)
+    bool Delete(BTreeNode& node, typename ParamTrait<const Key>::DeclType key)
     {
         unsigned key_idx;
-        bool is_key_found = node.Find(key, &key_idx);
+        bool is_key_found = node.Find(key, &key_idx, GetCompare());
         if (node.IsLeave()) // case 1
         {
             if (is_key_found)
             {
                 node.Delete(key_idx);
             }
-            return;
+            return is_key_found;
         }
         else if (is_key_found && !node.IsLeave()) // case 2
         {
-            const unsigned min_key_num = node.GetMaxKeyNum() / 2;
+            const unsigned min_key_num = m_max_key_num / 2;
             BTreeNode* cur_child = node.GetChild(key_idx);
             if (cur_child->GetKeyNum() > min_key_num) // case 2a
             {
-                int prev_key = 0;
-                std::string prev_value;
+                Key prev_key = Key();
+                Value prev_value = Value();
                 cur_child->GetMaxKeyItem(&prev_key, &prev_value);
                 Delete(*cur_child, prev_key);
                 node.SetItem(key_idx, prev_key, prev_value);
-                return;
+                node.SetSize(node.GetSize() - 1);
+                return true;
             }
 
             BTreeNode* next_child = node.GetChild(key_idx + 1);
             if (next_child->GetKeyNum() > min_key_num) // case 2b
             {
-                int next_key = 0;
-                std::string next_value;
+                Key next_key = Key();
+                Value next_value = Value();
                 next_child->GetMinKeyItem(&next_key, &next_value);
                 Delete(*next_child, next_key);
                 node.SetItem(key_idx, next_key, next_value);
-                return;
+                node.SetSize(node.GetSize() - 1);
+                return true;
             }
 
             // case 2c
             (void) node.MergeChildren(key_idx);
-            Delete(*cur_child, key);
+            FreeNode(next_child);
+            return DeleteInChild(node, *cur_child, key);
         }
         else // case 3
         {
             BTreeNode* child = node.GetChild(key_idx);
-            const unsigned min_key_num = node.GetMaxKeyNum() / 2;
+            const unsigned min_key_num = m_max_key_num / 2;
             if (child->GetKeyNum() <= min_key_num)
             {
                 BTreeNode* prev_child = NULL;
@@ -543,16 +1275,40 @@ private:
                 }
                 else // case 3b
                 {
-                    child = node.MergeChildren(prev_child != NULL ?
-                                                 key_idx - 1: key_idx);
+                    const unsigned merge_idx = prev_child != NULL ? key_idx - 1 : key_idx;
+                    BTreeNode* merged_child = node.GetChild(merge_idx + 1);
+                    child = node.MergeChildren(merge_idx);
+                    FreeNode(merged_child);
                 }
             }
-            Delete(*child, key);
+            return DeleteInChild(node, *child, key);
         }
     }
 
-private:
+    bool DeleteInChild(BTreeNode& node, BTreeNode& child,
+                       typename ParamTrait<const Key>::DeclType key)
+    {
+        if (Delete(child, key))
+        {
+            node.SetSize(node.GetSize() - 1);
+            return true;
+        }
+        return false;
+    }
+
+    struct CompareAndNodeAllocator : public NodeAllocator, public Compare
+    {
+        CompareAndNodeAllocator(const NodeAllocator& alloc, const Compare& compare)
+        : NodeAllocator(alloc), Compare(compare)
+        {}
+    };
+
+    CompareAndNodeAllocator m_impl;
+    const unsigned m_max_key_num;
     BTreeNode* m_root;
+
+    BTree(const BTree&);
+    BTree& operator=(const BTree&);
 };
 
 } // algo
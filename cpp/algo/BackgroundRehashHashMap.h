@@ -0,0 +1,457 @@
+#ifndef ALGO_BACKGROUNDREHASHHASHMAP_H_
+#define ALGO_BACKGROUNDREHASHHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// The nodes are immutable except for the link, which readers follow
+// while a writer changes it.
+template<typename Key, typename Value>
+struct ConcurrentHashMapNode
+{
+    ConcurrentHashMapNode(typename ParamTrait<const Key>::DeclType k,
+                          typename ParamTrait<const Value>::DeclType v,
+                          ConcurrentHashMapNode* n, std::size_t h)
+    : key(k), value(v), cached_hash(h), next(n)
+    {}
+
+    const Key key;
+    const Value value;
+    const std::size_t cached_hash;
+    ::std::atomic<ConcurrentHashMapNode*> next;
+};
+
+// Grace periods for memory read by lock free readers. A reader registers
+// in the counter of the current epoch parity. After unpublishing some
+// memory, a writer flips the epoch and waits for the counters of the old
+// parity to drain; every reader that could still see the memory entered
+// before the flip, so the memory can be freed afterwards.
+//
+// Each parity has READER_STRIPE_NUM counters on their own cache lines,
+// and a thread always registers in the same one, so readers on different
+// threads mostly do not write to the same cache line. Writers, which are
+// rare, pay for it by checking every stripe. The counters are aligned by
+// hand in a separate buffer, so that the maps holding a ReaderEpoch do not
+// need an over-aligned operator new before C++17.
+class ReaderEpoch
+{
+public:
+    enum { READER_STRIPE_NUM = 16, CACHE_LINE_SIZE = 64 };
+
+    ReaderEpoch()
+    : m_buffer(new char[sizeof(ReaderCount) * 2 * READER_STRIPE_NUM + CACHE_LINE_SIZE - 1])
+    , m_readers(NULL), m_epoch(0)
+    {
+        const ::std::uintptr_t address = reinterpret_cast< ::std::uintptr_t>(m_buffer);
+        m_readers = reinterpret_cast<ReaderCount*>(
+                (address + CACHE_LINE_SIZE - 1) & ~static_cast< ::std::uintptr_t>(CACHE_LINE_SIZE - 1));
+        for (unsigned int i = 0; i < 2 * READER_STRIPE_NUM; ++i)
+        {
+            (void) new (m_readers + i) ReaderCount;
+            m_readers[i].count = 0;
+        }
+    }
+
+    ~ReaderEpoch()
+    {
+        delete [] m_buffer;
+    }
+
+    // Returns the slot to pass to LeaveRead.
+    unsigned int EnterRead()
+    {
+        const unsigned int stripe = GetStripe();
+        for (;;)
+        {
+            const unsigned int epoch = m_epoch.load();
+            const unsigned int slot = (epoch & 1) * READER_STRIPE_NUM + stripe;
+            m_readers[slot].count.fetch_add(1);
+            // a flip in between may not wait for us, so register again
+            if (m_epoch.load() == epoch)
+            {
+                return slot;
+            }
+            m_readers[slot].count.fetch_sub(1);
+        }
+    }
+
+    void LeaveRead(const unsigned int slot)
+    {
+        m_readers[slot].count.fetch_sub(1, ::std::memory_order_release);
+    }
+
+    // Wait until no reader can see the memory unpublished before the call.
+    void WaitForReaders()
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_flip_mutex);
+        const unsigned int first = (m_epoch.fetch_add(1) & 1) * READER_STRIPE_NUM;
+        for (unsigned int i = first; i < first + READER_STRIPE_NUM; ++i)
+        {
+            while (m_readers[i].count.load() != 0)
+            {
+                ::std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) ReaderCount
+    {
+        ::std::atomic< ::std::size_t> count;
+    };
+
+    // The stripe a thread got on its first read, handed out round robin.
+    static unsigned int GetStripe()
+    {
+        static ::std::atomic<unsigned int> next_stripe(0);
+        thread_local const unsigned int stripe =
+                next_stripe.fetch_add(1, ::std::memory_order_relaxed) % READER_STRIPE_NUM;
+        return stripe;
+    }
+
+    ReaderEpoch(const ReaderEpoch&);
+    ReaderEpoch& operator=(const ReaderEpoch&);
+
+    char* m_buffer;
+    ReaderCount* m_readers;  // the stripes of parity p at [p * READER_STRIPE_NUM]
+    ::std::atomic<unsigned int> m_epoch;
+    ::std::mutex m_flip_mutex;
+};
+
+}  // namespace detail
+
+
+// A hash map for read-mostly tables where the lookups must never wait:
+// Find takes no lock and never rehashes. Writers are serialized by a
+// mutex. When an Insert crosses the IsRehash threshold, the new bucket
+// array is built by a background thread from the live table while the
+// lookups keep using the old one. Writes during the rebuild are applied
+// to the old table and recorded in a delta log, which is replayed on the
+// new table before it is published with an atomic pointer swap. The old
+// table is freed once no reader can see it anymore.
+//
+// Values are immutable once inserted; delete and insert again to update.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy>
+class BackgroundRehashHashMap
+{
+public:
+    typedef detail::ConcurrentHashMapNode<Key, Value> Node;
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef KeyEqual key_equal;
+    typedef HashPolicy hash_policy;
+    typedef RehashPolicy rehash_policy;
+
+    // retired nodes are freed in batches of this size
+    enum { RECLAIM_BATCH_SIZE = 64 };
+
+    explicit BackgroundRehashHashMap(std::size_t size_hint = 0,
+                                     const KeyEqual& key_equal = KeyEqual(),
+                                     const HashPolicy& hash_policy = HashPolicy(),
+                                     const RehashPolicy& rehash_policy = RehashPolicy())
+    : m_key_equal(key_equal), m_hash_policy(hash_policy)
+    , m_rehash_policy(rehash_policy)
+    , m_table(NewTable(rehash_policy.NextBucketCount(size_hint)))
+    , m_node_count(0), m_is_rehashing(false)
+    {}
+
+    ~BackgroundRehashHashMap()
+    {
+        WaitForRehash();
+        Table* table = m_table.load();
+        FreeNodes(table);
+        FreeTable(table);
+        FreeRetiredNodes(m_retired_nodes);
+    }
+
+    // Lock free.
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        const std::size_t hash_code = m_hash_policy.DoHash(key);
+        const unsigned int slot = m_epoch.EnterRead();
+        const Table* table = m_table.load(::std::memory_order_acquire);
+        const Node* node = FindInBucket(table->buckets[hash_code % table->bucket_count], key);
+        if (node != NULL)
+        {
+            value = node->value;
+        }
+        m_epoch.LeaveRead(slot);
+        return node != NULL;
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        const std::size_t hash_code = m_hash_policy.DoHash(key);
+        ::std::lock_guard< ::std::mutex> lock(m_write_mutex);
+        Table* table = m_table.load();
+        ::std::atomic<Node*>& bucket = table->buckets[hash_code % table->bucket_count];
+        if (FindInBucket(bucket, key) != NULL)
+        {
+            return false;
+        }
+
+        Node* node = new Node(key, value, bucket.load(::std::memory_order_relaxed), hash_code);
+        bucket.store(node, ::std::memory_order_release);
+        const std::size_t node_count = m_node_count.load() + 1;
+        m_node_count.store(node_count);
+
+        if (m_is_rehashing)
+        {
+            m_delta_log.push_back(DeltaOp(node, false));
+        }
+        else if (m_rehash_policy.IsRehash(table->bucket_count, node_count))
+        {
+            StartRehash(m_rehash_policy.BucketCountForElements(node_count));
+        }
+        return true;
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t hash_code = m_hash_policy.DoHash(key);
+        ::std::lock_guard< ::std::mutex> lock(m_write_mutex);
+        Table* table = m_table.load();
+        ::std::atomic<Node*>* prev = &table->buckets[hash_code % table->bucket_count];
+        for (Node* node = prev->load(); node != NULL; node = prev->load())
+        {
+            if (m_key_equal.Equal(node->key, key))
+            {
+                prev->store(node->next.load(), ::std::memory_order_release);
+                m_node_count.store(m_node_count.load() - 1);
+                // readers may still be on the node
+                m_retired_nodes.push_back(node);
+                if (m_is_rehashing)
+                {
+                    m_delta_log.push_back(DeltaOp(node, true));
+                }
+                else if (m_retired_nodes.size() >= RECLAIM_BATCH_SIZE)
+                {
+                    m_epoch.WaitForReaders();
+                    FreeRetiredNodes(m_retired_nodes);
+                }
+                return true;
+            }
+            prev = &node->next;
+        }
+        return false;
+    }
+
+    // Wait for the running background rehash, if any, to be published.
+    void WaitForRehash()
+    {
+        ::std::thread builder;
+        {
+            ::std::lock_guard< ::std::mutex> lock(m_write_mutex);
+            builder.swap(m_builder);
+        }
+        if (builder.joinable())
+        {
+            builder.join();
+        }
+    }
+
+    bool IsRehashing() const
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_write_mutex);
+        return m_is_rehashing;
+    }
+
+    std::size_t GetBucketCount() const { return m_table.load()->bucket_count; }
+
+    std::size_t size() const { return m_node_count.load(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Table
+    {
+        ::std::atomic<Node*>* buckets;
+        std::size_t bucket_count;
+    };
+
+    struct DeltaOp
+    {
+        DeltaOp(const Node* n, const bool d) : node(n), is_delete(d) {}
+
+        const Node* node;  // kept alive until the new table is published
+        bool is_delete;
+    };
+
+    static Table* NewTable(const std::size_t bucket_count)
+    {
+        Table* table = new Table;
+        table->buckets = new ::std::atomic<Node*>[bucket_count];
+        table->bucket_count = bucket_count;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            table->buckets[i].store(NULL, ::std::memory_order_relaxed);
+        }
+        return table;
+    }
+
+    static void FreeTable(Table* table)
+    {
+        delete [] table->buckets;
+        delete table;
+    }
+
+    static void FreeNodes(Table* table)
+    {
+        for (std::size_t i = 0; i < table->bucket_count; ++i)
+        {
+            Node* next = NULL;
+            for (Node* node = table->buckets[i].load(); node != NULL; node = next)
+            {
+                next = node->next.load();
+                delete node;
+            }
+        }
+    }
+
+    static void FreeRetiredNodes(::std::vector<Node*>& nodes)
+    {
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            delete nodes[i];
+        }
+        nodes.clear();
+    }
+
+    Node* FindInBucket(const ::std::atomic<Node*>& bucket,
+                       typename ParamTrait<const Key>::DeclType key) const
+    {
+        for (Node* node = bucket.load(::std::memory_order_acquire); node != NULL;
+             node = node->next.load(::std::memory_order_acquire))
+        {
+            if (m_key_equal.Equal(key, node->key))
+            {
+                return node;
+            }
+        }
+        return NULL;
+    }
+
+    // Called with m_write_mutex held.
+    void StartRehash(const std::size_t new_bucket_count)
+    {
+        // The previous builder has published its table already and is at
+        // most freeing the old one, which does not need m_write_mutex.
+        if (m_builder.joinable())
+        {
+            m_builder.join();
+        }
+        m_is_rehashing = true;
+        m_builder = ::std::thread(&BackgroundRehashHashMap::Rehash, this, new_bucket_count);
+    }
+
+    // Runs on the builder thread. While m_is_rehashing is set, no node
+    // reachable from the old table is freed, so it is walked without
+    // entering the epoch.
+    void Rehash(const std::size_t new_bucket_count)
+    {
+        Table* old_table = m_table.load();
+        Table* new_table = NewTable(new_bucket_count);
+        for (std::size_t i = 0; i < old_table->bucket_count; ++i)
+        {
+            for (const Node* node = old_table->buckets[i].load(::std::memory_order_acquire);
+                 node != NULL; node = node->next.load(::std::memory_order_acquire))
+            {
+                InsertPrivate(new_table, node);
+            }
+        }
+
+        ::std::vector<Node*> garbage;
+        {
+            ::std::lock_guard< ::std::mutex> lock(m_write_mutex);
+            // The copy may or may not have seen each logged write, and
+            // replaying them in order makes the new table exact.
+            for (std::size_t i = 0; i < m_delta_log.size(); ++i)
+            {
+                const DeltaOp& op = m_delta_log[i];
+                if (op.is_delete)
+                {
+                    DeletePrivate(new_table, op.node);
+                }
+                else if (FindInBucket(new_table->buckets[op.node->cached_hash % new_bucket_count],
+                                      op.node->key) == NULL)
+                {
+                    InsertPrivate(new_table, op.node);
+                }
+            }
+            m_delta_log.clear();
+
+            m_table.store(new_table, ::std::memory_order_release);
+            m_is_rehashing = false;
+            garbage.swap(m_retired_nodes);
+        }
+
+        m_epoch.WaitForReaders();
+        FreeNodes(old_table);
+        FreeTable(old_table);
+        FreeRetiredNodes(garbage);
+    }
+
+    // Add a copy of node to a table that readers cannot see yet.
+    static void InsertPrivate(Table* table, const Node* node)
+    {
+        ::std::atomic<Node*>& bucket = table->buckets[node->cached_hash % table->bucket_count];
+        bucket.store(new Node(node->key, node->value, bucket.load(::std::memory_order_relaxed),
+                              node->cached_hash),
+                     ::std::memory_order_relaxed);
+    }
+
+    void DeletePrivate(Table* table, const Node* deleted)
+    {
+        ::std::atomic<Node*>* prev =
+                &table->buckets[deleted->cached_hash % table->bucket_count];
+        for (Node* node = prev->load(); node != NULL; node = prev->load())
+        {
+            if (m_key_equal.Equal(node->key, deleted->key))
+            {
+                prev->store(node->next.load());
+                delete node;
+                return;
+            }
+            prev = &node->next;
+        }
+    }
+
+    BackgroundRehashHashMap(const BackgroundRehashHashMap&);
+    BackgroundRehashHashMap& operator=(const BackgroundRehashHashMap&);
+
+    KeyEqual m_key_equal;
+    HashPolicy m_hash_policy;
+    RehashPolicy m_rehash_policy;
+
+    ::std::atomic<Table*> m_table;
+    ::std::atomic<std::size_t> m_node_count;
+    mutable detail::ReaderEpoch m_epoch;
+
+    // the following are guarded by m_write_mutex
+    mutable ::std::mutex m_write_mutex;
+    bool m_is_rehashing;
+    ::std::vector<DeltaOp> m_delta_log;
+    ::std::vector<Node*> m_retired_nodes;
+    ::std::thread m_builder;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_BACKGROUNDREHASHHASHMAP_H_
@@ -0,0 +1,508 @@
+#ifndef ALGO_COMPACTHASHMAP_H_
+#define ALGO_COMPACTHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+#include "algo/TypeTrait.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <stdint.h>
+#include <type_traits>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+template<typename Key, typename Value>
+struct CompactHashMapNode
+{
+    CompactHashMapNode(typename ParamTrait<const Key>::DeclType k,
+                       typename ParamTrait<const Value>::DeclType v,
+                       uint32_t n, uint32_t h)
+    : key(k), value(v), next(n), cached_hash(h)
+    {}
+
+    const Key key;
+    Value value;
+    uint32_t next;
+    uint32_t cached_hash;
+};
+
+}  // namespace detail
+
+// HashMap variant keeping all the nodes in one growable array, chained
+// by 32 bit indices, with only the low 32 bits of the hash cached.
+// For <int, int> a node takes 16 bytes instead of a 24 bytes heap block,
+// and copying the map is one memcpy when Key and Value are trivially
+// copyable.
+//
+// The node array is kept dense: Delete moves the last node into the hole,
+// so unlike HashMap it invalidates the iterators. At most 2^32 - 1 entries.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy,
+         typename Allocator = ::std::allocator<Key> >
+class CompactHashMap
+{
+public:
+    typedef detail::CompactHashMapNode<Key, Value> Node;
+    typedef uint32_t IndexType;
+
+    enum { NIL_INDEX = 0xffffffffu };
+
+    class ConstIterator;
+
+    class Iterator
+    {
+        friend bool operator== (const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs.m_node == rhs.m_node;
+        }
+
+        friend bool operator!= (const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs.m_node != rhs.m_node;
+        }
+
+    public:
+        explicit Iterator(Node* node)
+        : m_node(node)
+        {}
+
+        Iterator& operator++()
+        {
+            ++m_node;
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return m_node->key;
+        }
+
+        Value& GetValue()
+        {
+            return m_node->value;
+        }
+
+    private:
+        friend class ConstIterator;
+
+        Node* m_node;
+    };
+
+    class ConstIterator
+    {
+        friend bool operator== (const ConstIterator& lhs, const ConstIterator& rhs)
+        {
+            return lhs.m_node == rhs.m_node;
+        }
+
+        friend bool operator!= (const ConstIterator& lhs, const ConstIterator& rhs)
+        {
+            return lhs.m_node != rhs.m_node;
+        }
+
+    public:
+        explicit ConstIterator(const Node* node)
+        : m_node(node)
+        {}
+
+        // We can convert a Iterator to ConstIterator
+        ConstIterator(const Iterator& it)
+        : m_node(it.m_node)
+        {}
+
+        ConstIterator& operator++()
+        {
+            ++m_node;
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return m_node->key;
+        }
+
+        typename ParamTrait<const Value>::DeclType GetValue() const
+        {
+            return m_node->value;
+        }
+
+    private:
+        const Node* m_node;
+    };
+
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Node>
+            NodeAllocator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<IndexType>
+            BucketAllocator;
+
+    typedef KeyEqual key_equal;
+    typedef HashPolicy hash_policy;
+    typedef RehashPolicy rehash_policy;
+
+    CompactHashMap(std::size_t size_hint = 0,
+                   const KeyEqual& key_equal = KeyEqual(),
+                   const HashPolicy& hash_policy = HashPolicy(),
+                   const RehashPolicy& rehash_policy = RehashPolicy(),
+                   const NodeAllocator& node_alloc = NodeAllocator(),
+                   const BucketAllocator& bucket_alloc = BucketAllocator())
+    : m_hash_impl(node_alloc, key_equal, hash_policy)
+    , m_rehash_impl(bucket_alloc, rehash_policy)
+    , m_bucket_count(rehash_policy.NextBucketCount(size_hint))
+    , m_buckets(NewBuckets(m_bucket_count))
+    , m_nodes(NULL)
+    , m_node_count(0)
+    , m_node_capacity(0)
+    {
+        if (size_hint > 0)
+        {
+            Reserve(size_hint);
+        }
+    }
+
+    // The copy is sized to fit exactly.
+    CompactHashMap(const CompactHashMap& m)
+    : m_hash_impl(m.m_hash_impl)
+    , m_rehash_impl(m.m_rehash_impl)
+    , m_bucket_count(m.m_bucket_count)
+    , m_buckets(m_rehash_impl.allocate(m.m_bucket_count))
+    , m_nodes(m.m_node_count > 0 ? m_hash_impl.allocate(m.m_node_count) : NULL)
+    , m_node_count(0)
+    , m_node_capacity(m.m_node_count)
+    {
+        ::memcpy(m_buckets, m.m_buckets, m_bucket_count * sizeof(IndexType));
+        CopyNodes(m_nodes, m.m_nodes, m.m_node_count, IsTrivialNode());
+        m_node_count = m.m_node_count;
+    }
+
+    // Do NOT derive from this class
+    ~CompactHashMap()
+    {
+        DestroyNodes(m_nodes, m_node_count, IsTrivialNode());
+        if (m_nodes != NULL)
+        {
+            m_hash_impl.deallocate(m_nodes, m_node_capacity);
+        }
+        m_rehash_impl.deallocate(m_buckets, m_bucket_count);
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        const IndexType hash_code = HashCode(key);
+        if (FindIndex(key, hash_code) != NIL_INDEX)
+        {
+            return false;
+        }
+
+        (void) AddNode(key, value, hash_code);
+        return true;
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        const IndexType index = FindIndex(key, HashCode(key));
+        if (index != NIL_INDEX)
+        {
+            value = m_nodes[index].value;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    {
+        const IndexType index = FindIndex(key, HashCode(key));
+        return index != NIL_INDEX ? iterator(m_nodes + index) : end();
+    }
+
+    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    {
+        const IndexType index = FindIndex(key, HashCode(key));
+        return index != NIL_INDEX ? const_iterator(m_nodes + index) : end();
+    }
+
+    Value& FindAndInsertIfNotPresent(typename ParamTrait<const Key>::DeclType key)
+    {
+        const IndexType hash_code = HashCode(key);
+        const IndexType index = FindIndex(key, hash_code);
+        if (index != NIL_INDEX)
+        {
+            return m_nodes[index].value;
+        }
+
+        return AddNode(key, Value(), hash_code)->value;
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        const IndexType hash_code = HashCode(key);
+        IndexType* prev_index = m_buckets + hash_code % m_bucket_count;
+        for (IndexType index = *prev_index; index != NIL_INDEX; index = *prev_index)
+        {
+            Node* node = m_nodes + index;
+            if (node->cached_hash == hash_code && m_hash_impl.Equal(node->key, key))
+            {
+                *prev_index = node->next;
+                RemoveNode(index);
+                return true;
+            }
+            prev_index = &(node->next);
+        }
+
+        return false;
+    }
+
+    // Keeps the memory of the node array.
+    void Clear()
+    {
+        DestroyNodes(m_nodes, m_node_count, IsTrivialNode());
+        m_node_count = 0;
+        ResetBuckets(m_buckets, m_bucket_count);
+    }
+
+    // Make room for node_num entries without growing the node array.
+    void Reserve(std::size_t node_num)
+    {
+        if (node_num > m_node_capacity)
+        {
+            ReallocateNodes(node_num);
+        }
+    }
+
+    // if hint is 0, then try to rehash to fit the current node_count;
+    // returns the new bucket_count
+    ::std::size_t Rehash(std::size_t size_hint = 0)
+    {
+        if (size_hint == 0)
+        {
+            size_hint = m_rehash_impl.rehash_policy.BucketCountForElements(m_node_count);
+        }
+        else
+        {
+            size_hint = m_rehash_impl.rehash_policy.NextBucketCount(size_hint);
+        }
+
+        if (size_hint != m_bucket_count)
+        {
+            RehashImpl(size_hint);
+        }
+        return m_bucket_count;
+    }
+
+    ::std::size_t GetBucketCount() const { return m_bucket_count; }
+
+    // Bytes held by the node and bucket arrays.
+    ::std::size_t GetMemoryUsage() const
+    {
+        return m_node_capacity * sizeof(Node) + m_bucket_count * sizeof(IndexType);
+    }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_node_count; }
+    bool empty() const { return m_node_count == 0; }
+    void clear() { Clear(); }
+
+    Value& operator[] (typename ParamTrait<const Key>::DeclType key)
+    {
+        return FindAndInsertIfNotPresent(key);
+    }
+
+    iterator begin() { return iterator(m_nodes); }
+    const_iterator begin() const { return const_iterator(m_nodes); }
+    iterator end() { return iterator(m_nodes + m_node_count); }
+    const_iterator end() const { return const_iterator(m_nodes + m_node_count); }
+
+private:
+    typedef BoolType< ::std::is_trivially_copyable<Node>::value> IsTrivialNode;
+
+    IndexType HashCode(typename ParamTrait<const Key>::DeclType key) const
+    {
+        return static_cast<IndexType>(m_hash_impl.hash_policy.DoHash(key));
+    }
+
+    static void ResetBuckets(IndexType* buckets, const std::size_t bucket_count)
+    {
+        ::memset(buckets, 0xff, bucket_count * sizeof(IndexType));
+    }
+
+    IndexType* NewBuckets(const std::size_t bucket_count)
+    {
+        IndexType* buckets = m_rehash_impl.allocate(bucket_count);
+        ResetBuckets(buckets, bucket_count);
+        return buckets;
+    }
+
+    IndexType FindIndex(typename ParamTrait<const Key>::DeclType key,
+                        const IndexType hash_code) const
+    {
+        for (IndexType index = m_buckets[hash_code % m_bucket_count];
+             index != NIL_INDEX; index = m_nodes[index].next)
+        {
+            const Node& node = m_nodes[index];
+            if (node.cached_hash == hash_code && m_hash_impl.Equal(key, node.key))
+            {
+                return index;
+            }
+        }
+        return NIL_INDEX;
+    }
+
+    // key must not be in the map.
+    Node* AddNode(typename ParamTrait<const Key>::DeclType key,
+                  typename ParamTrait<const Value>::DeclType value,
+                  const IndexType hash_code)
+    {
+        if (m_node_count == m_node_capacity)
+        {
+            if (m_node_capacity == NIL_INDEX)
+            {
+                throw ::std::length_error("CompactHashMap is full");
+            }
+            const std::size_t capacity = m_node_capacity < 8 ? 8 : m_node_capacity * 2;
+            ReallocateNodes(capacity < NIL_INDEX ? capacity
+                                                 : static_cast<std::size_t>(NIL_INDEX));
+        }
+
+        if (m_rehash_impl.rehash_policy.IsRehash(m_bucket_count, m_node_count + 1))
+        {
+            RehashImpl(m_rehash_impl.rehash_policy.BucketCountForElements(m_node_count + 1));
+        }
+
+        IndexType* bucket = m_buckets + hash_code % m_bucket_count;
+        Node* node = new (m_nodes + m_node_count) Node(key, value, *bucket, hash_code);
+        *bucket = static_cast<IndexType>(m_node_count);
+        ++m_node_count;
+        return node;
+    }
+
+    // The node at index must have been unlinked.
+    void RemoveNode(const IndexType index)
+    {
+        const IndexType last_index = static_cast<IndexType>(m_node_count - 1);
+        m_nodes[index].~Node();
+        if (index != last_index)
+        {
+            // move the last node into the hole and relink it
+            Node* last = m_nodes + last_index;
+            IndexType* prev_index = m_buckets + last->cached_hash % m_bucket_count;
+            while (*prev_index != last_index)
+            {
+                prev_index = &(m_nodes[*prev_index].next);
+            }
+            *prev_index = index;
+            CopyNodes(m_nodes + index, last, 1, IsTrivialNode());
+            DestroyNodes(last, 1, IsTrivialNode());
+        }
+        --m_node_count;
+    }
+
+    void ReallocateNodes(const std::size_t capacity)
+    {
+        Node* nodes = m_hash_impl.allocate(capacity);
+        CopyNodes(nodes, m_nodes, m_node_count, IsTrivialNode());
+        DestroyNodes(m_nodes, m_node_count, IsTrivialNode());
+        if (m_nodes != NULL)
+        {
+            m_hash_impl.deallocate(m_nodes, m_node_capacity);
+        }
+        m_nodes = nodes;
+        m_node_capacity = capacity;
+    }
+
+    // The nodes are relinked in array order, so no node is visited twice.
+    void RehashImpl(std::size_t new_bucket_count)
+    {
+        IndexType* new_buckets = NewBuckets(new_bucket_count);
+        for (std::size_t i = 0; i < m_node_count; ++i)
+        {
+            IndexType* bucket = new_buckets + m_nodes[i].cached_hash % new_bucket_count;
+            m_nodes[i].next = *bucket;
+            *bucket = static_cast<IndexType>(i);
+        }
+
+        m_rehash_impl.deallocate(m_buckets, m_bucket_count);
+        m_buckets = new_buckets;
+        m_bucket_count = new_bucket_count;
+    }
+
+    static void CopyNodes(Node* dest, const Node* src, const std::size_t n, BoolType<true>)
+    {
+        if (n > 0)
+        {
+            ::memcpy(static_cast<void*>(dest), src, n * sizeof(Node));
+        }
+    }
+
+    static void CopyNodes(Node* dest, const Node* src, const std::size_t n, BoolType<false>)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            (void) new (dest + i) Node(src[i]);
+        }
+    }
+
+    static void DestroyNodes(Node*, const std::size_t, BoolType<true>)
+    {}
+
+    static void DestroyNodes(Node* nodes, const std::size_t n, BoolType<false>)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            nodes[i].~Node();
+        }
+    }
+
+    CompactHashMap& operator=(const CompactHashMap&);
+
+    struct HashPolicyAndNodeAllocator : public NodeAllocator, public KeyEqual
+    {
+        HashPolicyAndNodeAllocator(const NodeAllocator& alloc,
+                                   const KeyEqual& key_equal,
+                                   const HashPolicy& policy)
+        : NodeAllocator(alloc), KeyEqual(key_equal), hash_policy(policy)
+        {}
+
+        HashPolicy hash_policy;
+    };
+
+    HashPolicyAndNodeAllocator m_hash_impl;
+
+    struct RehashPolicyAndBucketAllocator : public BucketAllocator
+    {
+        RehashPolicyAndBucketAllocator(const BucketAllocator& alloc,
+                                       const RehashPolicy& policy)
+        : BucketAllocator(alloc), rehash_policy(policy)
+        {}
+
+        RehashPolicy rehash_policy;
+    };
+
+    RehashPolicyAndBucketAllocator m_rehash_impl;
+
+    ::std::size_t m_bucket_count;
+    IndexType* m_buckets;
+    Node* m_nodes;
+    ::std::size_t m_node_count;
+    ::std::size_t m_node_capacity;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_COMPACTHASHMAP_H_
@@ -0,0 +1,783 @@
+#ifndef ALGO_CONCURRENTBTREE_H_
+#define ALGO_CONCURRENTBTREE_H_
+
+#include "algo/BTree.h"
+#include "algo/ParamTrait.h"
+#include "algo/PoolAllocator.h"
+#include "algo/TypeTrait.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// The BTreeNode of a ConcurrentBTreeNode gets what is left of NodeSize
+// after the version and the free list link, so that the whole node takes
+// NodeSize bytes.
+template<unsigned int NodeSize>
+struct ConcurrentBTreeBaseNodeSize
+{
+    enum { EXTRA_SIZE = sizeof(uint64_t) + sizeof(void*),
+           Result = NodeSize > EXTRA_SIZE ? NodeSize - EXTRA_SIZE : 0 };
+};
+
+// A BTreeNode with the version lock of optimistic lock coupling.
+//
+// The version counts the changes of the node, with two flag bits:
+// LOCKED_BIT while a writer changes the node and OBSOLETE_BIT once it is
+// unlinked from the tree. A reader remembers the version before reading
+// the node and checks it is unchanged afterwards, otherwise what it read
+// may be torn and it has to retry. A writer locks the node by setting
+// LOCKED_BIT on the version it has read, so the lock fails if the node
+// has changed in between.
+template<typename KType, typename VType, unsigned int NodeSize>
+class ConcurrentBTreeNode
+    : public BTreeNode<KType, VType, ConcurrentBTreeBaseNodeSize<NodeSize>::Result>
+{
+    typedef BTreeNode<KType, VType, ConcurrentBTreeBaseNodeSize<NodeSize>::Result> Base;
+
+public:
+    enum { OBSOLETE_BIT = 1, LOCKED_BIT = 2, VERSION_STEP = 4 };
+
+    explicit ConcurrentBTreeNode(const unsigned max_key_num)
+    : Base(max_key_num), m_version(0), m_next_free(NULL)
+    {}
+
+    // Make a node unlinked from the tree a new one. Only the BTreeNode is
+    // constructed again, as the version may still be read by the threads
+    // which went down to the node before, and goes on from where it was.
+    void Reuse(const unsigned max_key_num)
+    {
+        Base* base = this;
+        base->~Base();
+        new (base) Base(max_key_num);
+        m_next_free = NULL;
+        m_version.store((GetVersion() | (VERSION_STEP - 1)) + 1, ::std::memory_order_release);
+    }
+
+    uint64_t GetVersion() const
+    {
+        return m_version.load(::std::memory_order_acquire);
+    }
+
+    // Returns false if the node is locked or obsolete.
+    bool ReadLock(uint64_t* version) const
+    {
+        *version = GetVersion();
+        return (*version & (LOCKED_BIT | OBSOLETE_BIT)) == 0;
+    }
+
+    // Whether what was read since ReadLock() returned version is valid.
+    bool Validate(const uint64_t version) const
+    {
+        ::std::atomic_thread_fence(::std::memory_order_acquire);
+        return m_version.load(::std::memory_order_relaxed) == version;
+    }
+
+    // Lock the node if it is still at version.
+    bool Upgrade(uint64_t version)
+    {
+        return m_version.compare_exchange_strong(version, version + LOCKED_BIT);
+    }
+
+    // Wait for the writer holding the node, if any, and lock it.
+    void Lock()
+    {
+        while (true)
+        {
+            uint64_t version = GetVersion();
+            if ((version & LOCKED_BIT) == 0 && Upgrade(version))
+            {
+                return;
+            }
+            ::std::this_thread::yield();
+        }
+    }
+
+    void Unlock()
+    {
+        m_version.fetch_add(LOCKED_BIT, ::std::memory_order_release);
+    }
+
+    void UnlockObsolete()
+    {
+        m_version.fetch_add(LOCKED_BIT + OBSOLETE_BIT, ::std::memory_order_release);
+    }
+
+    ConcurrentBTreeNode* GetNextFree() const { return m_next_free; }
+    void SetNextFree(ConcurrentBTreeNode* node) { m_next_free = node; }
+
+private:
+    ::std::atomic<uint64_t> m_version;
+    ConcurrentBTreeNode* m_next_free;
+};
+
+}  // namespace detail
+
+
+// An ordered map of Key to Value shared by many threads, with the nodes
+// of BTree and optimistic lock coupling:
+//
+// - Find() takes no lock. It reads the nodes on the way down optimistically
+//   and retries from the root if any of them changes under it.
+// - Insert(), Update() and Delete() go down the same way and only lock the
+//   nodes they change: the node of the key, or a node with the children it
+//   splits, merges or moves a key between. Like BTree, full children are
+//   split and children with the minimum keys are filled up on the way down,
+//   so the changes never go up the tree.
+// - Insert() retries from the root after a split. Delete() goes on from
+//   the first node it has to change with the nodes locked one level at a
+//   time, as the deletes in two neighbour children could otherwise keep
+//   moving the same key back and forth.
+//
+// Key and Value must be trivially copyable, as the readers may copy them
+// while a writer changes them, before finding out they have to retry.
+//
+// A node unlinked by a merge may still be read by the threads which went
+// down to it before. Such nodes are only reused as nodes of the same tree,
+// with a greater version than ever before, and freed with the tree. The
+// allocator is used under a mutex, which only the splits and merges take.
+//
+// The subtree sizes of BTreeNode are not kept up to date, so there is no
+// Rank() or Select(). size() is a counter of its own.
+template<typename Key, typename Value,
+         typename Compare = ::std::less<Key>,
+         unsigned int NodeSize = 512,
+         typename Allocator = ::std::allocator<Key> >
+class ConcurrentBTree
+{
+    static_assert(::std::is_trivially_copyable<Key>::value &&
+                  ::std::is_trivially_copyable<Value>::value,
+                  "ConcurrentBTree needs trivially copyable keys and values");
+
+public:
+    typedef detail::ConcurrentBTreeNode<Key, Value, NodeSize> Node;
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Compare key_compare;
+    typedef Allocator allocator_type;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Node>
+            NodeAllocator;
+
+    // max_key_num is rounded like in BTree.
+    explicit ConcurrentBTree(const unsigned max_key_num = 0,
+                             const Compare& compare = Compare(),
+                             const Allocator& alloc = Allocator())
+    : m_impl(NodeAllocator(alloc), compare)
+    , m_max_key_num(GetMaxKeyNum(max_key_num))
+    , m_free_nodes(NULL)
+    , m_size(0)
+    {
+        m_root.store(NewNode());
+    }
+
+    // Not thread safe, like ForEach().
+    ~ConcurrentBTree()
+    {
+        FreeAllNodes(IsTrivialNode(), IsBulkRelease());
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        bool is_found = false;
+        for (unsigned restart_num = 0; !TryFind(key, &value, &is_found); ++restart_num)
+        {
+            Backoff(restart_num);
+        }
+        return is_found;
+    }
+
+    // Returns false and keeps the old value if key is already present.
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        bool is_inserted = false;
+        for (unsigned restart_num = 0; !TryInsert(key, value, &is_inserted); ++restart_num)
+        {
+            Backoff(restart_num);
+        }
+        return is_inserted;
+    }
+
+    // Returns false if key is not present.
+    bool Update(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        bool is_updated = false;
+        for (unsigned restart_num = 0; !TryUpdate(key, value, &is_updated); ++restart_num)
+        {
+            Backoff(restart_num);
+        }
+        return is_updated;
+    }
+
+    // Returns false if key is not present.
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        bool is_deleted = false;
+        for (unsigned restart_num = 0; !TryDelete(key, &is_deleted); ++restart_num)
+        {
+            Backoff(restart_num);
+        }
+        return is_deleted;
+    }
+
+    // Call visitor(key, value) for every entry in the order of the keys.
+    // Not thread safe: there must be no writer at the same time.
+    template<typename Visitor>
+    void ForEach(Visitor& visitor) const
+    {
+        ForEach(*m_root.load(), visitor);
+    }
+
+    unsigned GetMaxKeyNum() const { return m_max_key_num; }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_size.load(::std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+    key_compare key_comp() const { return GetCompare(); }
+    allocator_type get_allocator() const
+    {
+        return allocator_type(static_cast<const NodeAllocator&>(m_impl));
+    }
+
+    // for BTreeNode::InsertNonfull
+    Node* NewNode()
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_node_mutex);
+        Node* node = m_free_nodes;
+        if (node != NULL)
+        {
+            m_free_nodes = node->GetNextFree();
+            node->Reuse(m_max_key_num);
+            return node;
+        }
+
+        node = NodeAllocatorTraits::allocate(m_impl, 1);
+        return new (node) Node(m_max_key_num);
+    }
+
+private:
+    typedef ::std::allocator_traits<NodeAllocator> NodeAllocatorTraits;
+    typedef BoolType<IsTriviallyDestructible<Key>::Result &&
+                     IsTriviallyDestructible<Value>::Result> IsTrivialNode;
+    typedef BoolType<IsBulkReleaseAllocator<NodeAllocator>::Result> IsBulkRelease;
+
+    static unsigned GetMaxKeyNum(const unsigned max_key_num)
+    {
+        if (max_key_num == 0 || max_key_num >= Node::MAX_KEY_NUM)
+        {
+            return Node::MAX_KEY_NUM;
+        }
+        return max_key_num > 3 ? ((max_key_num - 1) | 1) : 3;
+    }
+
+    const Compare& GetCompare() const { return m_impl; }
+
+    static void Backoff(const unsigned restart_num)
+    {
+        // the first retry is often after a split or merge of our own
+        if (restart_num > 0)
+        {
+            ::std::this_thread::yield();
+        }
+    }
+
+    static Node* GetChild(const Node* node, const unsigned i)
+    {
+        return static_cast<Node*>(node->GetChild(i));
+    }
+
+    bool IsKeyAt(const Node* node, const unsigned i,
+                 typename ParamTrait<const Key>::DeclType key) const
+    {
+        return i < node->GetKeyNum() && !GetCompare()(key, node->GetKey(i));
+    }
+
+    // The root and its version, or false if it is locked or replaced.
+    bool ReadLockRoot(Node** root, uint64_t* version) const
+    {
+        *root = m_root.load(::std::memory_order_acquire);
+        return (*root)->ReadLock(version) && *root == m_root.load(::std::memory_order_acquire);
+    }
+
+    // The child i of node and its version. The node is checked before the
+    // child is read, so that the child is a node, and after the version of
+    // the child is read, so that the child is still the one of the node.
+    static bool ReadLockChild(const Node* node, const uint64_t version, const unsigned i,
+                              Node** child, uint64_t* child_version)
+    {
+        *child = GetChild(node, i);
+        return node->Validate(version) && (*child)->ReadLock(child_version) &&
+               node->Validate(version);
+    }
+
+    // Lock the nodes which are still at their versions, or none of them.
+    static bool Upgrade(Node* first, const uint64_t first_version,
+                        Node* second, const uint64_t second_version)
+    {
+        if (!first->Upgrade(first_version))
+        {
+            return false;
+        }
+        if (!second->Upgrade(second_version))
+        {
+            first->Unlock();
+            return false;
+        }
+        return true;
+    }
+
+    // The Try methods return false if they have to restart from the root.
+
+    bool TryFind(typename ParamTrait<const Key>::DeclType key,
+                 Value* value, bool* is_found) const
+    {
+        Node* node = NULL;
+        uint64_t version = 0;
+        if (!ReadLockRoot(&node, &version))
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            const unsigned i = node->LowerBound(key, GetCompare());
+            if (IsKeyAt(node, i, key))
+            {
+                *value = node->GetValue(i);
+                *is_found = true;
+                return node->Validate(version);
+            }
+            else if (node->IsLeave())
+            {
+                *is_found = false;
+                return node->Validate(version);
+            }
+
+            Node* child = NULL;
+            uint64_t child_version = 0;
+            if (!ReadLockChild(node, version, i, &child, &child_version))
+            {
+                return false;
+            }
+            node = child;
+            version = child_version;
+        }
+    }
+
+    bool TryUpdate(typename ParamTrait<const Key>::DeclType key,
+                   typename ParamTrait<const Value>::DeclType value, bool* is_updated)
+    {
+        Node* node = NULL;
+        uint64_t version = 0;
+        if (!ReadLockRoot(&node, &version))
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            const unsigned i = node->LowerBound(key, GetCompare());
+            if (IsKeyAt(node, i, key))
+            {
+                if (!node->Upgrade(version))
+                {
+                    return false;
+                }
+                node->GetValue(i) = value;
+                node->Unlock();
+                *is_updated = true;
+                return true;
+            }
+            else if (node->IsLeave())
+            {
+                *is_updated = false;
+                return node->Validate(version);
+            }
+
+            Node* child = NULL;
+            uint64_t child_version = 0;
+            if (!ReadLockChild(node, version, i, &child, &child_version))
+            {
+                return false;
+            }
+            node = child;
+            version = child_version;
+        }
+    }
+
+    bool TryInsert(typename ParamTrait<const Key>::DeclType key,
+                   typename ParamTrait<const Value>::DeclType value, bool* is_inserted)
+    {
+        Node* node = NULL;
+        uint64_t version = 0;
+        if (!ReadLockRoot(&node, &version))
+        {
+            return false;
+        }
+
+        if (node->GetKeyNum() == m_max_key_num)
+        {
+            // the new root is not seen by anyone before m_root is set
+            if (node->Upgrade(version))
+            {
+                Node* root = NewNode();
+                root->SetIsLeave(false);
+                root->SetChild(0, node);
+                root->SplitChild(0, *node, NewNode());
+                m_root.store(root, ::std::memory_order_release);
+                node->Unlock();
+            }
+            return false;
+        }
+
+        while (true)
+        {
+            const unsigned i = node->LowerBound(key, GetCompare());
+            if (IsKeyAt(node, i, key))
+            {
+                *is_inserted = false;
+                return node->Validate(version);
+            }
+            else if (node->IsLeave())
+            {
+                if (!node->Upgrade(version))
+                {
+                    return false;
+                }
+                node->InsertNonfull(key, value, GetCompare(), *this);
+                node->Unlock();
+                m_size.fetch_add(1, ::std::memory_order_relaxed);
+                *is_inserted = true;
+                return true;
+            }
+
+            Node* child = NULL;
+            uint64_t child_version = 0;
+            if (!ReadLockChild(node, version, i, &child, &child_version))
+            {
+                return false;
+            }
+
+            if (child->GetKeyNum() == m_max_key_num)
+            {
+                if (Upgrade(node, version, child, child_version))
+                {
+                    node->SplitChild(i, *child, NewNode());
+                    child->Unlock();
+                    node->Unlock();
+                }
+                return false;
+            }
+            node = child;
+            version = child_version;
+        }
+    }
+
+    bool TryDelete(typename ParamTrait<const Key>::DeclType key, bool* is_deleted)
+    {
+        Node* node = NULL;
+        uint64_t version = 0;
+        if (!ReadLockRoot(&node, &version))
+        {
+            return false;
+        }
+
+        // Go down optimistically as long as nothing but the leaf changes.
+        // From the first node to change on, the children are locked before
+        // they are changed, and kept locked until the next level is done,
+        // so that two deletes can not keep taking a key back from each other.
+        const unsigned min_key_num = m_max_key_num / 2;
+        while (true)
+        {
+            const unsigned i = node->LowerBound(key, GetCompare());
+            const bool is_found = IsKeyAt(node, i, key);
+            if (node->IsLeave() && !is_found)
+            {
+                *is_deleted = false;
+                return node->Validate(version);
+            }
+
+            if (!is_found)
+            {
+                Node* child = NULL;
+                uint64_t child_version = 0;
+                if (!ReadLockChild(node, version, i, &child, &child_version))
+                {
+                    return false;
+                }
+                if (child->GetKeyNum() > min_key_num)
+                {
+                    node = child;
+                    version = child_version;
+                    continue;
+                }
+            }
+
+            if (!node->Upgrade(version))
+            {
+                return false;
+            }
+            *is_deleted = DeleteLocked(node, key);
+            if (*is_deleted)
+            {
+                m_size.fetch_sub(1, ::std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+
+    // Delete key from the subtree of node like BTree::Delete, where node is
+    // locked and has keys to spare, or is the root. Everything is unlocked
+    // when it returns.
+    bool DeleteLocked(Node* node, typename ParamTrait<const Key>::DeclType key)
+    {
+        const unsigned min_key_num = m_max_key_num / 2;
+        while (true)
+        {
+            const unsigned i = node->LowerBound(key, GetCompare());
+            const bool is_found = IsKeyAt(node, i, key);
+            if (node->IsLeave())
+            {
+                if (is_found)
+                {
+                    node->Delete(i);
+                }
+                node->Unlock();
+                return is_found;
+            }
+            else if (!is_found)
+            {
+                node = LockChild(node, i);
+                continue;
+            }
+
+            // replace the key with the largest one before it, or the
+            // smallest one after it, taken from a child with keys to spare
+            Node* child = GetChild(node, i);
+            Node* next_child = GetChild(node, i + 1);
+            child->Lock();
+            next_child->Lock();
+            const bool is_from_prev = child->GetKeyNum() > min_key_num;
+            if (is_from_prev || next_child->GetKeyNum() > min_key_num)
+            {
+                (is_from_prev ? next_child : child)->Unlock();
+                Key new_key = Key();
+                Value new_value = Value();
+                PopItem(is_from_prev ? child : next_child, is_from_prev, &new_key, &new_value);
+                node->SetItem(i, new_key, new_value);
+                node->Unlock();
+                return true;
+            }
+
+            // the key goes down to the merged child
+            node->MergeChildren(i);
+            RetireNode(next_child);
+            UnlockParent(node, child);
+            node = child;
+        }
+    }
+
+    // Lock the child idx of node and fill it up to more than the minimum
+    // keys from a neighbour, or merge it with one, like BTree::Delete.
+    // node is locked and has keys to spare, or is the root, and is unlocked
+    // when the child is ready.
+    Node* LockChild(Node* node, const unsigned idx)
+    {
+        const unsigned min_key_num = m_max_key_num / 2;
+        Node* child = GetChild(node, idx);
+        child->Lock();
+        if (child->GetKeyNum() > min_key_num)
+        {
+            node->Unlock();
+            return child;
+        }
+
+        Node* prev_child = NULL;
+        if (idx > 0)
+        {
+            prev_child = GetChild(node, idx - 1);
+            prev_child->Lock();
+            if (prev_child->GetKeyNum() > min_key_num)
+            {
+                node->RightShiftKey(idx - 1);
+                prev_child->Unlock();
+                node->Unlock();
+                return child;
+            }
+        }
+
+        Node* next_child = NULL;
+        if (idx < node->GetKeyNum())
+        {
+            next_child = GetChild(node, idx + 1);
+            next_child->Lock();
+            if (next_child->GetKeyNum() > min_key_num)
+            {
+                node->LeftShiftKey(idx);
+                next_child->Unlock();
+                if (prev_child != NULL)
+                {
+                    prev_child->Unlock();
+                }
+                node->Unlock();
+                return child;
+            }
+        }
+
+        if (prev_child != NULL)
+        {
+            if (next_child != NULL)
+            {
+                next_child->Unlock();
+            }
+            node->MergeChildren(idx - 1);
+            RetireNode(child);
+            child = prev_child;
+        }
+        else
+        {
+            node->MergeChildren(idx);
+            RetireNode(next_child);
+        }
+        UnlockParent(node, child);
+        return child;
+    }
+
+    // Unlock node after a merge of its children into child. The root goes
+    // down a level when it loses its last key.
+    void UnlockParent(Node* node, Node* child)
+    {
+        if (node->GetKeyNum() == 0)
+        {
+            m_root.store(child, ::std::memory_order_release);
+            RetireNode(node);
+        }
+        else
+        {
+            node->Unlock();
+        }
+    }
+
+    // Remove the largest item of the subtree of node if is_max, or else the
+    // smallest, where node is locked and has keys to spare.
+    void PopItem(Node* node, const bool is_max, Key* key, Value* value)
+    {
+        while (!node->IsLeave())
+        {
+            node = LockChild(node, is_max ? node->GetKeyNum() : 0);
+        }
+
+        const unsigned i = is_max ? node->GetKeyNum() - 1 : 0;
+        *key = node->GetKey(i);
+        *value = node->GetValue(i);
+        node->Delete(i);
+        node->Unlock();
+    }
+
+    // Unlock a node unlinked from the tree, to be reused by NewNode().
+    void RetireNode(Node* node)
+    {
+        node->UnlockObsolete();
+        ::std::lock_guard< ::std::mutex> lock(m_node_mutex);
+        node->SetNextFree(m_free_nodes);
+        m_free_nodes = node;
+    }
+
+    void FreeNode(Node* node)
+    {
+        node->~Node();
+        NodeAllocatorTraits::deallocate(m_impl, node, 1);
+    }
+
+    // Nothing to walk: the allocator frees every node at once, unless
+    // other allocators share its pool.
+    void FreeAllNodes(BoolType<true>, BoolType<true>)
+    {
+        if (m_impl.IsPoolShared())
+        {
+            FreeAllNodes(BoolType<true>(), BoolType<false>());
+            return;
+        }
+        m_impl.Release();
+    }
+
+    template<typename IsTrivial, typename IsBulk>
+    void FreeAllNodes(IsTrivial, IsBulk)
+    {
+        FreeNodes(m_root.load());
+        while (m_free_nodes != NULL)
+        {
+            Node* next = m_free_nodes->GetNextFree();
+            FreeNode(m_free_nodes);
+            m_free_nodes = next;
+        }
+    }
+
+    void FreeNodes(Node* node)
+    {
+        if (!node->IsLeave())
+        {
+            for (unsigned i = 0; i <= node->GetKeyNum(); ++i)
+            {
+                FreeNodes(GetChild(node, i));
+            }
+        }
+        FreeNode(node);
+    }
+
+    template<typename Visitor>
+    static void ForEach(const Node& node, Visitor& visitor)
+    {
+        const unsigned key_num = node.GetKeyNum();
+        for (unsigned i = 0; i < key_num; ++i)
+        {
+            if (!node.IsLeave())
+            {
+                ForEach(*GetChild(&node, i), visitor);
+            }
+            visitor(node.GetKey(i), node.GetValue(i));
+        }
+        if (!node.IsLeave() && key_num > 0)
+        {
+            ForEach(*GetChild(&node, key_num), visitor);
+        }
+    }
+
+    struct CompareAndNodeAllocator : public NodeAllocator, public Compare
+    {
+        CompareAndNodeAllocator(const NodeAllocator& alloc, const Compare& compare)
+        : NodeAllocator(alloc), Compare(compare)
+        {}
+    };
+
+    CompareAndNodeAllocator m_impl;
+    const unsigned m_max_key_num;
+    ::std::atomic<Node*> m_root;
+
+    // guards the allocator and the free list
+    ::std::mutex m_node_mutex;
+    Node* m_free_nodes;
+
+    ::std::atomic< ::std::size_t> m_size;
+
+    ConcurrentBTree(const ConcurrentBTree&);
+    ConcurrentBTree& operator=(const ConcurrentBTree&);
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_CONCURRENTBTREE_H_
@@ -0,0 +1,137 @@
+#ifndef ALGO_COUNTINGHASHMAP_H_
+#define ALGO_COUNTINGHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+#include <mutex>
+
+namespace snippet {
+namespace algo {
+
+// Counts keys from many threads without taking a lock per increment:
+// every thread counts in the private HashMap of its own LocalCounter,
+// which is merged into the shared table under the lock once it holds
+// max_local_keys keys, on Flush(), or when it is destroyed.
+//
+// Get() only sees the flushed counts, so it lags behind by what the
+// LocalCounters have not flushed yet.
+template<typename Key, typename Count = long long,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key> >
+class CountingHashMap
+{
+public:
+    typedef HashMap<Key, Count, KeyEqual, HashPolicy> MapType;
+
+    // Used by a single thread.
+    class LocalCounter
+    {
+    public:
+        explicit LocalCounter(CountingHashMap& counting_map)
+        : m_counting_map(counting_map)
+        {}
+
+        ~LocalCounter()
+        {
+            Flush();
+        }
+
+        void Add(typename ParamTrait<const Key>::DeclType key, const Count delta = 1)
+        {
+            m_local_map[key] += delta;
+            if (m_local_map.size() >= m_counting_map.m_max_local_keys)
+            {
+                Flush();
+            }
+        }
+
+        void Flush()
+        {
+            if (!m_local_map.empty())
+            {
+                m_counting_map.Merge(m_local_map);
+            }
+        }
+
+    private:
+        LocalCounter(const LocalCounter&);
+        LocalCounter& operator=(const LocalCounter&);
+
+        CountingHashMap& m_counting_map;
+        MapType m_local_map;
+    };
+
+    explicit CountingHashMap(std::size_t max_local_keys = 4096)
+    : m_max_local_keys(max_local_keys > 0 ? max_local_keys : 1)
+    {}
+
+    // Count delta directly in the shared table.
+    void Add(typename ParamTrait<const Key>::DeclType key, const Count delta = 1)
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        m_shared_map[key] += delta;
+    }
+
+    // The flushed count of key, 0 if not present.
+    Count Get(typename ParamTrait<const Key>::DeclType key) const
+    {
+        Count count = Count();
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        (void) m_shared_map.Find(key, count);
+        return count;
+    }
+
+    // Copy of the flushed counts.
+    void GetSnapshot(MapType* snapshot) const
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        snapshot->Clear();
+        for (typename MapType::const_iterator it = m_shared_map.begin();
+             it != m_shared_map.end(); ++it)
+        {
+            (*snapshot)[it.GetKey()] += it.GetValue();
+        }
+    }
+
+    ::std::size_t size() const
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        return m_shared_map.size();
+    }
+
+    void Clear()
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        m_shared_map.Clear();
+    }
+
+private:
+    struct AddCount
+    {
+        void operator()(Count& count, const Count& other_count) const
+        {
+            count += other_count;
+        }
+    };
+
+    // Relinks the nodes of local_map, leaving it empty.
+    void Merge(MapType& local_map)
+    {
+        ::std::lock_guard< ::std::mutex> lock(m_mutex);
+        m_shared_map.Merge(local_map, AddCount());
+    }
+
+    CountingHashMap(const CountingHashMap&);
+    CountingHashMap& operator=(const CountingHashMap&);
+
+    const ::std::size_t m_max_local_keys;
+    mutable ::std::mutex m_mutex;
+    MapType m_shared_map;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_COUNTINGHASHMAP_H_
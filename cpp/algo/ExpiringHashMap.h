@@ -0,0 +1,184 @@
+#ifndef ALGO_EXPIRINGHASHMAP_H_
+#define ALGO_EXPIRINGHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/IntrusiveList.h"
+#include "algo/TimerWheel.h"
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace snippet {
+namespace algo {
+
+// A HashMap whose entries carry a deadline. Every entry is linked into a
+// TimerWheel, so Tick(now) removes the due entries in O(expired) instead
+// of sweeping the whole map. Between two ticks, Find hides the entries
+// that are already stale.
+//
+// Time is in ticks of whatever unit the user picks (e.g. milliseconds).
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key> >
+class ExpiringHashMap
+{
+public:
+    typedef uint64_t TimeType;
+
+private:
+    struct Entry
+    {
+        Entry() : key(), value(), deadline(0) {}
+
+        Key key;  // needed to delete the map node when the entry expires
+        Value value;
+        uint64_t deadline;
+        ListNode list_node;
+    };
+
+    typedef HashMap<Key, Entry, KeyEqual, HashPolicy> Map;
+    typedef TimerWheel<Entry> Wheel;
+
+    struct ExpireCallback
+    {
+        explicit ExpireCallback(Map& m) : map(m) {}
+
+        void operator()(Entry* entry)
+        {
+            map.Delete(entry->key);
+        }
+
+        Map& map;
+    };
+
+public:
+    typedef Key KeyType;
+    typedef Value ValueType;
+
+    explicit ExpiringHashMap(TimeType now = 0, ::std::size_t size_hint = 0)
+    : m_map(size_hint), m_wheel(now)
+    {}
+
+    // Returns false if a live entry with the same key exists.
+    // A stale entry with the same key is replaced. Like in Find, the
+    // entries whose deadline is not later than now are stale, even if
+    // Tick has not removed them yet.
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value,
+                TimeType deadline, TimeType now)
+    {
+        const ::std::size_t old_size = m_map.size();
+        Entry& entry = m_map.FindAndInsertIfNotPresent(key);
+        if (m_map.size() == old_size)
+        {
+            if (entry.deadline > now)
+            {
+                return false;
+            }
+
+            entry.value = value;
+            m_wheel.Reschedule(&entry, deadline);
+            return true;
+        }
+
+        entry.key = key;
+        entry.value = value;
+        entry.deadline = deadline;
+        m_wheel.Add(&entry);
+        return true;
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value,
+                TimeType deadline)
+    {
+        return Insert(key, value, deadline, GetCurrentTime());
+    }
+
+    // Move the deadline of a live entry, e.g. when a session is used.
+    bool Touch(typename ParamTrait<const Key>::DeclType key, TimeType deadline,
+               TimeType now)
+    {
+        typename Map::iterator it = m_map.Find(key);
+        if (it == m_map.end() || it.GetValue().deadline <= now)
+        {
+            return false;
+        }
+
+        m_wheel.Reschedule(&it.GetValue(), deadline);
+        return true;
+    }
+
+    bool Touch(typename ParamTrait<const Key>::DeclType key, TimeType deadline)
+    {
+        return Touch(key, deadline, GetCurrentTime());
+    }
+
+    // Entries whose deadline is not later than now are not found,
+    // even if Tick has not removed them yet.
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value,
+              TimeType now) const
+    {
+        typename Map::const_iterator it = m_map.Find(key);
+        if (it == m_map.end() || it.GetValue().deadline <= now)
+        {
+            return false;
+        }
+
+        value = it.GetValue().value;
+        return true;
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        return Find(key, value, GetCurrentTime());
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        typename Map::iterator it = m_map.Find(key);
+        if (it == m_map.end())
+        {
+            return false;
+        }
+
+        m_wheel.Remove(&it.GetValue());
+        return m_map.Delete(key);
+    }
+
+    // Remove all the entries whose deadline is not later than now.
+    // Returns the number of removed entries.
+    ::std::size_t Tick(TimeType now)
+    {
+        ExpireCallback callback(m_map);
+        return m_wheel.Advance(now, callback);
+    }
+
+    void Clear()
+    {
+        for (typename Map::iterator it = m_map.begin(); it != m_map.end(); ++it)
+        {
+            m_wheel.Remove(&it.GetValue());
+        }
+        m_map.Clear();
+    }
+
+    TimeType GetCurrentTime() const { return m_wheel.GetCurrentTime(); }
+
+    // Includes the stale entries that are not ticked out yet.
+    ::std::size_t size() const { return m_map.size(); }
+    bool empty() const { return m_map.empty(); }
+
+private:
+    // The wheel links the entries in place, so they must not be copied.
+    ExpiringHashMap(const ExpiringHashMap&);
+    ExpiringHashMap& operator=(const ExpiringHashMap&);
+
+    Map m_map;
+    Wheel m_wheel;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_EXPIRINGHASHMAP_H_
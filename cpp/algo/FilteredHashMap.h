@@ -0,0 +1,193 @@
+#ifndef ALGO_FILTEREDHASHMAP_H_
+#define ALGO_FILTEREDHASHMAP_H_
+
+#include "algo/BlockedBloomFilter.h"
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace snippet {
+namespace algo {
+
+// HashMap fronted by a BlockedBloomFilter of the key hashes, for miss
+// heavy workloads: most lookups of absent keys stop at the filter
+// instead of walking a bucket chain.
+//
+// The filter is rebuilt whenever the map rehashes, and after as many
+// deletes as there are entries, since deleted keys cannot be removed
+// from a Bloom filter.
+//
+// It only pays off while the filter is much smaller than the buckets it
+// saves: with 80% misses (BM_HashMapMissHeavyFind) it is about 2x faster
+// than HashMap at 32K entries and 1.6x at 256K. From 2M entries on, where
+// the 4MB filter is bigger than L2 and both the filter and the buckets
+// are served from L3, it is no faster, and 0.8-0.95x in some runs.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy,
+         typename Allocator = ::std::allocator<Key> >
+class FilteredHashMap
+{
+public:
+    typedef HashMap<Key, Value, KeyEqual, HashPolicy, RehashPolicy, Allocator> MapType;
+    typedef typename MapType::iterator iterator;
+    typedef typename MapType::const_iterator const_iterator;
+    typedef Key KeyType;
+    typedef Value ValueType;
+
+    typedef KeyEqual key_equal;
+    typedef HashPolicy hash_policy;
+    typedef RehashPolicy rehash_policy;
+
+    FilteredHashMap(std::size_t size_hint = 0,
+                    unsigned int bits_per_key = 10,
+                    const KeyEqual& key_equal = KeyEqual(),
+                    const HashPolicy& hash_policy = HashPolicy(),
+                    const RehashPolicy& rehash_policy = RehashPolicy())
+    : m_map(size_hint, key_equal, hash_policy, rehash_policy)
+    , m_hash_policy(hash_policy)
+    , m_filter(0, bits_per_key)
+    , m_filter_bucket_count(0)
+    , m_deleted_num(0)
+    {
+        RebuildFilter();
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        if (!m_map.Insert(key, value))
+        {
+            return false;
+        }
+
+        m_filter.Add(m_hash_policy.DoHash(key));
+        SyncFilter();
+        return true;
+    }
+
+    // The key is hashed once, for both the filter and the map.
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        const ::std::size_t hash_code = m_hash_policy.DoHash(key);
+        return m_filter.MayContain(hash_code) && m_map.FindWithHash(key, hash_code, value);
+    }
+
+    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    {
+        const ::std::size_t hash_code = m_hash_policy.DoHash(key);
+        return m_filter.MayContain(hash_code) ?
+                m_map.FindWithHash(key, hash_code) : m_map.end();
+    }
+
+    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    {
+        const ::std::size_t hash_code = m_hash_policy.DoHash(key);
+        return m_filter.MayContain(hash_code) ?
+                m_map.FindWithHash(key, hash_code) : m_map.end();
+    }
+
+    Value& FindAndInsertIfNotPresent(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t node_count = m_map.size();
+        Value& value = m_map.FindAndInsertIfNotPresent(key);
+        if (m_map.size() != node_count)
+        {
+            m_filter.Add(m_hash_policy.DoHash(key));
+            SyncFilter();
+        }
+        return value;
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        if (!m_map.Delete(key))
+        {
+            return false;
+        }
+
+        if (++m_deleted_num > m_map.size())
+        {
+            RebuildFilter();
+        }
+        else
+        {
+            SyncFilter();
+        }
+        return true;
+    }
+
+    void Clear()
+    {
+        m_map.Clear();
+        RebuildFilter();
+    }
+
+    ::std::size_t Rehash(std::size_t size_hint = 0)
+    {
+        m_map.Rehash(size_hint);
+        RebuildFilter();
+        return m_map.GetBucketCount();
+    }
+
+    ::std::size_t GetBucketCount() const { return m_map.GetBucketCount(); }
+    const BlockedBloomFilter& GetFilter() const { return m_filter; }
+    const MapType& GetMap() const { return m_map; }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_map.size(); }
+    bool empty() const { return m_map.empty(); }
+    void clear() { Clear(); }
+
+    Value& operator[] (typename ParamTrait<const Key>::DeclType key)
+    {
+        return FindAndInsertIfNotPresent(key);
+    }
+
+    iterator begin() { return m_map.begin(); }
+    const_iterator begin() const { return m_map.begin(); }
+    iterator end() { return m_map.end(); }
+    const_iterator end() const { return m_map.end(); }
+
+private:
+    // Rebuild the filter if the map has rehashed or outgrown it.
+    void SyncFilter()
+    {
+        if (m_map.GetBucketCount() != m_filter_bucket_count ||
+            m_map.size() > m_filter.GetCapacity())
+        {
+            RebuildFilter();
+        }
+    }
+
+    // Sized for the current entries only, as the smaller the filter the
+    // more of it stays in cache; its capacity is rounded up to a power of
+    // 2 blocks, so growing it is amortized like the map rehash. The hash
+    // codes come from the nodes, which cache them by default.
+    void RebuildFilter()
+    {
+        const std::size_t bucket_count = m_map.GetBucketCount();
+        m_filter.Reset(m_map.size());
+        const MapType& map = m_map;
+        for (const_iterator it = map.begin(); it != map.end(); ++it)
+        {
+            m_filter.Add(map.GetHashCode(it));
+        }
+        m_filter_bucket_count = bucket_count;
+        m_deleted_num = 0;
+    }
+
+    MapType m_map;
+    HashPolicy m_hash_policy;
+    BlockedBloomFilter m_filter;
+    ::std::size_t m_filter_bucket_count;
+    ::std::size_t m_deleted_num;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_FILTEREDHASHMAP_H_
@@ -0,0 +1,203 @@
+#ifndef ALGO_GROUPBYAGGREGATOR_H_
+#define ALGO_GROUPBYAGGREGATOR_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+
+namespace snippet {
+namespace algo {
+
+// A reducer defines the StateType kept per group and the InputType added
+// to it, with
+//   void Init(StateType& state, const InputType& input) for the first input,
+//   void Reduce(StateType& state, const InputType& input) for the others,
+//   void Combine(StateType& state, const StateType& other) to merge states.
+
+template<typename T>
+struct SumReducer
+{
+    typedef T StateType;
+    typedef T InputType;
+
+    void Init(T& state, const T& input) const { state = input; }
+    void Reduce(T& state, const T& input) const { state += input; }
+    void Combine(T& state, const T& other) const { state += other; }
+};
+
+template<typename T>
+struct CountReducer
+{
+    typedef ::std::size_t StateType;
+    typedef T InputType;
+
+    void Init(::std::size_t& state, const T&) const { state = 1; }
+    void Reduce(::std::size_t& state, const T&) const { ++state; }
+    void Combine(::std::size_t& state, const ::std::size_t& other) const { state += other; }
+};
+
+template<typename T>
+struct MinReducer
+{
+    typedef T StateType;
+    typedef T InputType;
+
+    void Init(T& state, const T& input) const { state = input; }
+    void Reduce(T& state, const T& input) const
+    {
+        if (input < state)
+        {
+            state = input;
+        }
+    }
+
+    void Combine(T& state, const T& other) const { Reduce(state, other); }
+};
+
+template<typename T>
+struct MaxReducer
+{
+    typedef T StateType;
+    typedef T InputType;
+
+    void Init(T& state, const T& input) const { state = input; }
+    void Reduce(T& state, const T& input) const
+    {
+        if (state < input)
+        {
+            state = input;
+        }
+    }
+
+    void Combine(T& state, const T& other) const { Reduce(state, other); }
+};
+
+template<typename T>
+struct AvgState
+{
+    AvgState() : sum(), count(0) {}
+
+    double GetAverage() const
+    {
+        return count > 0 ? static_cast<double>(sum) / count : 0.0;
+    }
+
+    T sum;
+    ::std::size_t count;
+};
+
+template<typename T>
+struct AvgReducer
+{
+    typedef AvgState<T> StateType;
+    typedef T InputType;
+
+    void Init(StateType& state, const T& input) const
+    {
+        state.sum = input;
+        state.count = 1;
+    }
+
+    void Reduce(StateType& state, const T& input) const
+    {
+        state.sum += input;
+        ++state.count;
+    }
+
+    void Combine(StateType& state, const StateType& other) const
+    {
+        state.sum += other.sum;
+        state.count += other.count;
+    }
+};
+
+// Hash group-by: keeps one Reducer::StateType per distinct key.
+// Aggregators filled by different threads can be combined with Merge(),
+// which relinks the nodes of the other one.
+template<typename Key, typename Reducer,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key> >
+class GroupByAggregator
+{
+public:
+    typedef typename Reducer::StateType StateType;
+    typedef typename Reducer::InputType InputType;
+    typedef HashMap<Key, StateType, KeyEqual, HashPolicy> MapType;
+    typedef typename MapType::iterator iterator;
+    typedef typename MapType::const_iterator const_iterator;
+
+    explicit GroupByAggregator(::std::size_t group_num_hint = 0,
+                               const Reducer& reducer = Reducer())
+    : m_reducer(reducer)
+    , m_map(group_num_hint)
+    {}
+
+    void Add(typename ParamTrait<const Key>::DeclType key, const InputType& input)
+    {
+        // a single lookup for a known group
+        const ::std::size_t group_num = m_map.size();
+        StateType& state = m_map.FindAndInsertIfNotPresent(key);
+        if (m_map.size() != group_num)
+        {
+            m_reducer.Init(state, input);
+        }
+        else
+        {
+            m_reducer.Reduce(state, input);
+        }
+    }
+
+    void Add(const Key* keys, const InputType* inputs, const ::std::size_t n)
+    {
+        for (::std::size_t i = 0; i < n; ++i)
+        {
+            Add(keys[i], inputs[i]);
+        }
+    }
+
+    // Combine the groups of other into this one, leaving other empty.
+    void Merge(GroupByAggregator& other)
+    {
+        m_map.Merge(other.m_map, CombineState(m_reducer));
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, StateType& state) const
+    {
+        return m_map.Find(key, state);
+    }
+
+    void Clear() { m_map.Clear(); }
+
+    const MapType& GetMap() const { return m_map; }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_map.size(); }
+    bool empty() const { return m_map.empty(); }
+
+    iterator begin() { return m_map.begin(); }
+    const_iterator begin() const { return m_map.begin(); }
+    iterator end() { return m_map.end(); }
+    const_iterator end() const { return m_map.end(); }
+
+private:
+    struct CombineState
+    {
+        explicit CombineState(const Reducer& r) : reducer(r) {}
+
+        void operator()(StateType& state, const StateType& other) const
+        {
+            reducer.Combine(state, other);
+        }
+
+        const Reducer& reducer;
+    };
+
+    Reducer m_reducer;
+    MapType m_map;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_GROUPBYAGGREGATOR_H_
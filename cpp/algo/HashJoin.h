@@ -0,0 +1,256 @@
+#ifndef ALGO_HASHJOIN_H_
+#define ALGO_HASHJOIN_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// Maps the index in a partition of probe keys back to the probe input.
+template<typename Callback>
+struct HashJoinProbeCallback
+{
+    HashJoinProbeCallback(const ::std::size_t* i, Callback& cb)
+    : indices(i), callback(cb)
+    {}
+
+    template<typename Value>
+    void operator()(const ::std::size_t i, const Value& value)
+    {
+        callback(indices[i], value);
+    }
+
+    const ::std::size_t* indices;
+    Callback& callback;
+};
+
+}  // namespace detail
+
+// Build side of an equi-join, radix partitioned by the key hash into
+// HashMaps small enough to stay in the L2 cache.
+//
+// Add() the build tuples, which are buffered by partition, then Build()
+// the HashMap of every partition in turn. Probe() batches of probe keys:
+// every batch is scattered by partition, and each partition is probed
+// with HashMap::FindBatch, which prefetches the buckets. The build keys
+// are unique, as the primary key side of a primary key / foreign key join.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key> >
+class HashJoinTable
+{
+public:
+    typedef HashMap<Key, Value, KeyEqual, HashPolicy> MapType;
+    typedef Key KeyType;
+    typedef Value ValueType;
+
+    enum { DEFAULT_CACHE_SIZE = 1024 * 1024, MAX_RADIX_BITS = 12,
+           MIN_PROBE_KEYS_PER_PARTITION = 64 };
+
+    // build_size_hint is the number of build tuples expected,
+    // cache_size the bytes a partition should fit in.
+    explicit HashJoinTable(::std::size_t build_size_hint = 0,
+                           ::std::size_t cache_size = DEFAULT_CACHE_SIZE,
+                           const HashPolicy& hash_policy = HashPolicy())
+    : m_hash_policy(hash_policy)
+    , m_radix_bits(GetRadixBits(build_size_hint, cache_size))
+    , m_partitions(static_cast< ::std::size_t>(1) << m_radix_bits,
+                   MapType(build_size_hint >> m_radix_bits, KeyEqual(), hash_policy))
+    , m_build_buffers(m_partitions.size())
+    , m_size(0)
+    , m_is_built(true)
+    {}
+
+    // The tuple is appended to the buffer of its partition, and inserted
+    // by Build(). The first of the tuples of the same key is kept.
+    void Add(typename ParamTrait<const Key>::DeclType key,
+             typename ParamTrait<const Value>::DeclType value)
+    {
+        m_build_buffers[GetPartitionIndex(m_hash_policy.DoHash(key))].push_back(
+                ::std::make_pair(key, value));
+        m_is_built = false;
+    }
+
+    // Insert the added tuples partition by partition, so that only the
+    // HashMap of one partition is written at a time.
+    void Build()
+    {
+        for (::std::size_t p = 0; p < m_partitions.size(); ++p)
+        {
+            BuildBuffer& buffer = m_build_buffers[p];
+            MapType& partition = m_partitions[p];
+            for (typename BuildBuffer::const_iterator it = buffer.begin();
+                 it != buffer.end(); ++it)
+            {
+                if (partition.Insert(it->first, it->second))
+                {
+                    ++m_size;
+                }
+            }
+            BuildBuffer().swap(buffer);
+        }
+        m_is_built = true;
+    }
+
+    // Only sees the tuples added before the last Build().
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        return m_partitions[GetPartitionIndex(m_hash_policy.DoHash(key))].Find(key, value);
+    }
+
+    // Call callback(i, value) for every keys[i] matching a build tuple.
+    // The matches are reported partition by partition, not in the order of
+    // keys. Batches of less than MIN_PROBE_KEYS_PER_PARTITION keys per
+    // partition are looked up one by one instead. Returns the number of matches.
+    template<typename Callback>
+    ::std::size_t Probe(const Key* keys, const ::std::size_t n, Callback& callback)
+    {
+        if (!m_is_built)
+        {
+            Build();
+        }
+
+        CountingCallback<Callback> counting_callback(callback);
+        const ::std::size_t partition_num = m_partitions.size();
+        if (partition_num == 1)
+        {
+            m_partitions[0].FindBatch(keys, n, counting_callback);
+            return counting_callback.count;
+        }
+
+        // too few keys per partition to pay for the scattering
+        if (n < partition_num * MIN_PROBE_KEYS_PER_PARTITION)
+        {
+            Value value = Value();
+            for (::std::size_t i = 0; i < n; ++i)
+            {
+                if (Find(keys[i], value))
+                {
+                    counting_callback(i, value);
+                }
+            }
+            return counting_callback.count;
+        }
+
+        // counting sort of the keys by partition
+        m_partition_ends.assign(partition_num + 1, 0);
+        m_probe_partitions.resize(n);
+        for (::std::size_t i = 0; i < n; ++i)
+        {
+            m_probe_partitions[i] = GetPartitionIndex(m_hash_policy.DoHash(keys[i]));
+            ++m_partition_ends[m_probe_partitions[i] + 1];
+        }
+        for (::std::size_t i = 1; i <= partition_num; ++i)
+        {
+            m_partition_ends[i] += m_partition_ends[i - 1];
+        }
+
+        m_probe_keys.resize(n);
+        m_probe_indices.resize(n);
+        m_partition_offsets.assign(m_partition_ends.begin(), m_partition_ends.end() - 1);
+        for (::std::size_t i = 0; i < n; ++i)
+        {
+            const ::std::size_t pos = m_partition_offsets[m_probe_partitions[i]]++;
+            m_probe_keys[pos] = keys[i];
+            m_probe_indices[pos] = i;
+        }
+
+        for (::std::size_t p = 0; p < partition_num; ++p)
+        {
+            const ::std::size_t first = m_partition_ends[p];
+            const ::std::size_t last = m_partition_ends[p + 1];
+            if (first == last)
+            {
+                continue;
+            }
+
+            detail::HashJoinProbeCallback<CountingCallback<Callback> >
+                    probe_callback(&m_probe_indices[first], counting_callback);
+            m_partitions[p].FindBatch(&m_probe_keys[first], last - first, probe_callback);
+        }
+        return counting_callback.count;
+    }
+
+    void Clear()
+    {
+        for (::std::size_t i = 0; i < m_partitions.size(); ++i)
+        {
+            m_partitions[i].Clear();
+            BuildBuffer().swap(m_build_buffers[i]);
+        }
+        m_size = 0;
+        m_is_built = true;
+    }
+
+    ::std::size_t GetPartitionNum() const { return m_partitions.size(); }
+    const MapType& GetPartition(const ::std::size_t i) const { return m_partitions[i]; }
+
+    ::std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    template<typename Callback>
+    struct CountingCallback
+    {
+        explicit CountingCallback(Callback& cb)
+        : callback(cb), count(0)
+        {}
+
+        void operator()(const ::std::size_t i, const Value& value)
+        {
+            callback(i, value);
+            ++count;
+        }
+
+        Callback& callback;
+        ::std::size_t count;
+    };
+
+    // Enough partitions for every one to hold its nodes and buckets in
+    // cache_size bytes.
+    static unsigned int GetRadixBits(const ::std::size_t build_size_hint,
+                                     const ::std::size_t cache_size)
+    {
+        const ::std::size_t entry_bytes = sizeof(typename MapType::Node) + sizeof(void*);
+        unsigned int radix_bits = 0;
+        while (radix_bits < MAX_RADIX_BITS &&
+               (build_size_hint >> radix_bits) * entry_bytes > cache_size)
+        {
+            ++radix_bits;
+        }
+        return radix_bits;
+    }
+
+    ::std::size_t GetPartitionIndex(const ::std::size_t hash_code) const
+    {
+        return GetRadixPartition(hash_code, m_radix_bits);
+    }
+
+    typedef ::std::vector< ::std::pair<Key, Value> > BuildBuffer;
+
+    HashPolicy m_hash_policy;
+    const unsigned int m_radix_bits;
+    ::std::vector<MapType> m_partitions;
+    ::std::vector<BuildBuffer> m_build_buffers;
+    ::std::size_t m_size;  // of the built tuples
+    bool m_is_built;
+
+    // buffers of Probe(), kept to not reallocate them for every batch
+    ::std::vector< ::std::size_t> m_probe_partitions;
+    ::std::vector< ::std::size_t> m_partition_ends;
+    ::std::vector< ::std::size_t> m_partition_offsets;
+    ::std::vector<Key> m_probe_keys;
+    ::std::vector< ::std::size_t> m_probe_indices;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_HASHJOIN_H_
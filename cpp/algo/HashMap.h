@@ -2,12 +2,20 @@
 #define ALGO_HASHMAP_H_
 
 #include "algo/ParamTrait.h"
+#include "algo/Partition.h"
+#include "algo/TypeTrait.h"
 
 #include <string>
 #include <cstring>
 #include <iostream>
 #include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 namespace snippet {
 namespace algo {
@@ -127,37 +135,36 @@ struct HashDouble<T, 8>
 
 }  // namespace detail
 
-std::size_t Hash(std::size_t key)
+inline std::size_t Hash(std::size_t key)
 {
     return key;
 }
 
-std::size_t Hash(unsigned int key)
+inline std::size_t Hash(unsigned int key)
 {
     return static_cast<std::size_t>(key);
 }
 
-std::size_t Hash(int key)
+inline std::size_t Hash(int key)
 {
     return static_cast<std::size_t>(key);
 }
 
-std::size_t Hash(float key)
+inline std::size_t Hash(float key)
 {
     return detail::HashDouble<float, sizeof(float)>::Hash(&key);
 }
 
-std::size_t Hash(double key)
+inline std::size_t Hash(double key)
 {
     return detail::HashDouble<double, sizeof(double)>::Hash(&key);
 }
 
 // This hashing implementation is used by Python
-std::size_t Hash(const ::std::string& str)
+inline std::size_t Hash(const char* str, const ::std::size_t str_size)
 {
-    const unsigned char* p = reinterpret_cast<const unsigned char*>(str.c_str());
-    std::size_t result = (*p) << 7;
-    const ::std::size_t str_size = str.size();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+    std::size_t result = str_size > 0 ? (*p) << 7 : 0;
     for (::std::size_t i = 0; i < str_size; ++i)
     {
         result = (1000003 * result) ^ *p++;
@@ -166,6 +173,26 @@ std::size_t Hash(const ::std::string& str)
     return result;
 }
 
+inline std::size_t Hash(const ::std::string& str)
+{
+    return Hash(str.data(), str.size());
+}
+
+// The partition of hash_code among 2^radix_bits partitions: the top bits
+// of its Fibonacci hash, which do not follow the bucket index in a
+// HashMap, the hash code modulo a prime.
+inline std::size_t GetRadixPartition(const std::size_t hash_code,
+                                     const unsigned int radix_bits)
+{
+    if (radix_bits == 0)
+    {
+        return 0;
+    }
+    return static_cast<std::size_t>(
+            (static_cast<unsigned long long>(hash_code) * 0x9e3779b97f4a7c15ULL) >>
+            (64 - radix_bits));
+}
+
 
 template<typename Key>
 struct DefaultHashMapHashPolicy
@@ -207,8 +234,26 @@ public:
         return pos == last? *(last - 1) : *pos;
     }
 
+    // Number of threads to rehash or copy node_count nodes with.
+    // Everything runs on the calling thread here, see
+    // ParallelHashMapRehashPolicy in ParallelHashMap.h for more.
+    unsigned int GetThreadNum(::std::size_t) const
+    {
+        return 1;
+    }
+
+    // Call task(i) for every i in [0, thread_num).
+    template<typename Task>
+    void RunInParallel(const unsigned int thread_num, Task& task) const
+    {
+        for (unsigned int i = 0; i < thread_num; ++i)
+        {
+            task(i);
+        }
+    }
+
 private:
-    const unsigned int m_load_factor;
+    unsigned int m_load_factor;
 };
 
 
@@ -223,6 +268,105 @@ struct DefaultKeyEqual
 };
 
 
+namespace detail {
+
+// Rehash in two parallel passes without any locking. First every thread
+// walks its share of the old buckets and sorts the nodes into one list
+// per destination partition, i.e. per thread. Then every thread links the
+// lists sent to it into its own range of the new buckets.
+// NodeHasher provides the hash code of a node, cached or not.
+template<typename Node, typename HashPolicy, typename NodeHasher>
+class ParallelRehashTask
+{
+public:
+    ParallelRehashTask(Node** old_buckets, ::std::size_t old_bucket_count,
+                       Node** new_buckets, ::std::size_t new_bucket_count,
+                       const HashPolicy& hash_policy, const unsigned int thread_num)
+    : m_old_buckets(old_buckets), m_old_bucket_count(old_bucket_count)
+    , m_new_buckets(new_buckets), m_new_bucket_count(new_bucket_count)
+    , m_hash_policy(hash_policy), m_thread_num(thread_num)
+    , m_lists(thread_num * thread_num, static_cast<Node*>(NULL))
+    , m_is_distributing(true)
+    {}
+
+    template<typename Runner>
+    void Run(const Runner& runner)
+    {
+        runner.RunInParallel(m_thread_num, *this);
+        m_is_distributing = false;
+        runner.RunInParallel(m_thread_num, *this);
+    }
+
+    void operator()(const unsigned int thread_index)
+    {
+        if (m_is_distributing)
+        {
+            Distribute(thread_index);
+        }
+        else
+        {
+            Collect(thread_index);
+        }
+    }
+
+private:
+    void Distribute(const unsigned int thread_index)
+    {
+        // local lists, so that the threads do not share cache lines
+        ::std::vector<Node*> lists(m_thread_num, static_cast<Node*>(NULL));
+        ::std::size_t first = 0;
+        ::std::size_t last = 0;
+        GetPartition(m_old_bucket_count, m_thread_num, thread_index, &first, &last);
+
+        Node* next_node = NULL;
+        for (::std::size_t i = first; i < last; ++i)
+        {
+            for (Node* node = m_old_buckets[i]; node != NULL; node = next_node)
+            {
+                const ::std::size_t bucket_index =
+                        NodeHasher::GetNodeHash(node, m_hash_policy) % m_new_bucket_count;
+                const unsigned int part =
+                        GetPartitionIndex(m_new_bucket_count, m_thread_num, bucket_index);
+                next_node = node->next;
+                node->next = lists[part];
+                lists[part] = node;
+            }
+        }
+
+        ::std::copy(lists.begin(), lists.end(),
+                    m_lists.begin() + thread_index * m_thread_num);
+    }
+
+    void Collect(const unsigned int part)
+    {
+        Node* next_node = NULL;
+        for (unsigned int i = 0; i < m_thread_num; ++i)
+        {
+            for (Node* node = m_lists[i * m_thread_num + part];
+                 node != NULL; node = next_node)
+            {
+                const ::std::size_t bucket_index =
+                        NodeHasher::GetNodeHash(node, m_hash_policy) % m_new_bucket_count;
+                next_node = node->next;
+                node->next = m_new_buckets[bucket_index];
+                m_new_buckets[bucket_index] = node;
+            }
+        }
+    }
+
+    Node** m_old_buckets;
+    const ::std::size_t m_old_bucket_count;
+    Node** m_new_buckets;
+    const ::std::size_t m_new_bucket_count;
+    const HashPolicy& m_hash_policy;
+    const unsigned int m_thread_num;
+    ::std::vector<Node*> m_lists;  // list of thread i for part j at [i * m_thread_num + j]
+    bool m_is_distributing;
+};
+
+}  // namespace detail
+
+
 template<typename Key, typename Value, typename HashPolicy,
          bool IsCacheHash>
 class RehashBase;
@@ -251,6 +395,23 @@ public:
             }
         }
     }
+
+    template<typename Runner>
+    static void DoParallelRehash(Node** old_buckets, ::std::size_t old_bucket_count,
+                                 Node** new_buckets, ::std::size_t new_bucket_count,
+                                 const HashPolicy& hash_policy,
+                                 const unsigned int thread_num, const Runner& runner)
+    {
+        detail::ParallelRehashTask<Node, HashPolicy, RehashBase>
+                task(old_buckets, old_bucket_count, new_buckets, new_bucket_count,
+                     hash_policy, thread_num);
+        task.Run(runner);
+    }
+
+    static ::std::size_t GetNodeHash(const Node* node, const HashPolicy&)
+    {
+        return node->cached_hash;
+    }
 };
 
 template<typename Key, typename Value, typename HashPolicy>
@@ -277,6 +438,24 @@ public:
             }
         }
     }
+
+    // The hash codes are not cached, so every node is hashed twice.
+    template<typename Runner>
+    static void DoParallelRehash(Node** old_buckets, ::std::size_t old_bucket_count,
+                                 Node** new_buckets, ::std::size_t new_bucket_count,
+                                 const HashPolicy& hash_policy,
+                                 const unsigned int thread_num, const Runner& runner)
+    {
+        detail::ParallelRehashTask<Node, HashPolicy, RehashBase>
+                task(old_buckets, old_bucket_count, new_buckets, new_bucket_count,
+                     hash_policy, thread_num);
+        task.Run(runner);
+    }
+
+    static ::std::size_t GetNodeHash(const Node* node, const HashPolicy& hash_policy)
+    {
+        return hash_policy.DoHash(node->key);
+    }
 };
 
 
@@ -295,6 +474,8 @@ public:
 private:
     class IteratorBase
     {
+        friend class HashMap;
+
         friend bool operator== (const IteratorBase& lhs, const IteratorBase& rhs)
         {
             return lhs.IsEqual(rhs);
@@ -405,8 +586,11 @@ public:
     typedef Value ValueType;
     typedef Iterator iterator;
     typedef ConstIterator const_iterator;
-    typedef typename Allocator::template rebind<Node>::other NodeAllocator;
-    typedef typename Allocator::template rebind<Node*>::other BucketAllocator;
+    typedef Allocator allocator_type;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Node>
+            NodeAllocator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Node*>
+            BucketAllocator;
 
     typedef KeyEqual key_equal;
     typedef HashPolicy hash_policy;
@@ -422,11 +606,22 @@ public:
     : m_hash_impl(node_alloc, key_equal, hash_policy)
     , m_rehash_impl(bucket_alloc, rehash_policy)
     , m_bucket_count(rehash_policy.NextBucketCount(size_hint))
-    , m_buckets(m_rehash_impl.allocate(m_bucket_count + 1))
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
     , m_node_count(0)
     {
-        memset(m_buckets, 0, sizeof(Node*) * m_bucket_count);
-        m_buckets[m_bucket_count] = reinterpret_cast<Node*>(0x0123);
+        InitBuckets();
+    }
+
+    // The nodes and the buckets are allocated from alloc, e.g. a
+    // std::pmr::polymorphic_allocator, see pmr::HashMap below.
+    HashMap(std::size_t size_hint, const Allocator& alloc)
+    : m_hash_impl(NodeAllocator(alloc), KeyEqual(), HashPolicy())
+    , m_rehash_impl(BucketAllocator(alloc), RehashPolicy())
+    , m_bucket_count(m_rehash_impl.rehash_policy.NextBucketCount(size_hint))
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
+    , m_node_count(0)
+    {
+        InitBuckets();
     }
 
     // For copy std::map/unordered_map
@@ -440,11 +635,10 @@ public:
     : m_hash_impl(node_alloc, key_equal, hash_policy)
     , m_rehash_impl(bucket_alloc, rehash_policy)
     , m_bucket_count(m_rehash_impl.rehash_policy.BucketCountForElements(c.size()))
-    , m_buckets(m_rehash_impl.allocate(m_bucket_count + 1))
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
     , m_node_count(0)
     {
-        memset(m_buckets, 0, sizeof(Node*) * m_bucket_count);
-        m_buckets[m_bucket_count] = reinterpret_cast<Node*>(0x0123);
+        InitBuckets();
         for (typename Container::const_iterator it = c.begin();
              it != c.end(); ++it)
         {
@@ -452,43 +646,121 @@ public:
         }
     }
 
+    // Like the standard containers, the copy gets its allocators from
+    // select_on_container_copy_construction().
     HashMap(const HashMap& m)
+    : m_hash_impl(NodeAllocatorTraits::select_on_container_copy_construction(
+                          m.GetNodeAllocator()),
+                  m.m_hash_impl, m.m_hash_impl.hash_policy)
+    , m_rehash_impl(BucketAllocatorTraits::select_on_container_copy_construction(
+                            m.GetBucketAllocator()),
+                    m.m_rehash_impl.rehash_policy)
+    , m_bucket_count(m.m_bucket_count)
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
+    , m_node_count(0)
+    {
+        CopyNodes(m);
+    }
+
+    HashMap(const HashMap& m, const Allocator& alloc)
+    : m_hash_impl(NodeAllocator(alloc), m.m_hash_impl, m.m_hash_impl.hash_policy)
+    , m_rehash_impl(BucketAllocator(alloc), m.m_rehash_impl.rehash_policy)
+    , m_bucket_count(m.m_bucket_count)
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
+    , m_node_count(0)
+    {
+        CopyNodes(m);
+    }
+
+    // The nodes of m are taken over if the copied allocators compare equal
+    // to the ones of m, as the copies of a PoolAllocator do, or else moved
+    // one by one. m is left empty.
+    //
+    // Unlike the standard containers, it is not noexcept: it always
+    // allocates a fresh bucket array for this map. So std::vector<HashMap>
+    // copies instead of moving its elements when it grows.
+    HashMap(HashMap&& m)
     : m_hash_impl(m.m_hash_impl)
     , m_rehash_impl(m.m_rehash_impl)
-    , m_bucket_count(m.m_bucket_count)
-    , m_buckets(m_rehash_impl.allocate(m.m_bucket_count + 1))
+    , m_bucket_count(m_rehash_impl.rehash_policy.NextBucketCount(0))
+    , m_buckets(AllocateBuckets(m_bucket_count + 1))
     , m_node_count(0)
     {
-        for (::std::size_t i = 0; i < m_bucket_count; ++i)
-        {
-            if (m.m_buckets[i] == NULL)
-            {
-                m_buckets[i] = NULL;
-            }
-            else
-            {
-                Node* node = m.m_buckets[i];
-                Node** prev_node = m_buckets + i;
-                while (node != NULL)
-                {
-                    Node* new_node = m_hash_impl.allocate(1);
-                    (void) new (new_node) Node(*node);
-                    new_node->next = NULL;
-                    *prev_node = new_node;
-                    prev_node = &(new_node->next);
-                    node = node->next;
-                    ++m_node_count;
-                }
-            }
-        }
-        m_buckets[m_bucket_count] = reinterpret_cast<Node*>(0x0123);
+        InitBuckets();
+        MoveNodes(m);
     }
 
     // Do NOT derive from this class
     ~HashMap()
     {
         Clear();
-        m_rehash_impl.deallocate(m_buckets, m_bucket_count + 1);
+        DeallocateBuckets(m_buckets, m_bucket_count + 1);
+    }
+
+    // The allocators are replaced by the ones of m only if they
+    // propagate on copy assignment.
+    HashMap& operator=(const HashMap& m)
+    {
+        if (&m != this)
+        {
+            Clear();
+            DeallocateBuckets(m_buckets, m_bucket_count + 1);
+            AssignAllocators(m, BoolType<NodeAllocatorTraits::
+                                         propagate_on_container_copy_assignment::value>());
+            AssignPolicies(m);
+            m_bucket_count = m.m_bucket_count;
+            m_buckets = AllocateBuckets(m_bucket_count + 1);
+            CopyNodes(m);
+        }
+        return *this;
+    }
+
+    // The allocators are replaced by the ones of m only if they propagate
+    // on move assignment, then the nodes are moved like by HashMap(HashMap&&).
+    HashMap& operator=(HashMap&& m)
+    {
+        if (&m != this)
+        {
+            Clear();
+            DeallocateBuckets(m_buckets, m_bucket_count + 1);
+            AssignAllocators(m, BoolType<NodeAllocatorTraits::
+                                         propagate_on_container_move_assignment::value>());
+            AssignPolicies(m);
+            m_bucket_count = m_rehash_impl.rehash_policy.NextBucketCount(0);
+            m_buckets = AllocateBuckets(m_bucket_count + 1);
+            InitBuckets();
+            MoveNodes(m);
+        }
+        return *this;
+    }
+
+    // The allocators are swapped only if they propagate on swap. If they do
+    // not and are not equal, which is undefined for std::unordered_map,
+    // the entries are moved one by one through a temporary map.
+    void Swap(HashMap& other)
+    {
+        if (&other == this)
+        {
+            return;
+        }
+
+        typedef BoolType<NodeAllocatorTraits::propagate_on_container_swap::value> IsPropagate;
+        if (IsPropagate::Result || IsSameAllocator(other))
+        {
+            SwapAllocators(other, IsPropagate());
+            ::std::swap(static_cast<KeyEqual&>(m_hash_impl),
+                        static_cast<KeyEqual&>(other.m_hash_impl));
+            ::std::swap(m_hash_impl.hash_policy, other.m_hash_impl.hash_policy);
+            ::std::swap(m_rehash_impl.rehash_policy, other.m_rehash_impl.rehash_policy);
+            SwapNodes(other);
+            return;
+        }
+
+        HashMap tmp(::std::move(*this));
+        AssignPolicies(other);
+        MergeImpl(other, static_cast<KeepValue*>(NULL));
+        other.AssignPolicies(tmp);
+        other.MergeImpl(tmp, static_cast<KeepValue*>(NULL));
     }
 
     bool Insert(typename ParamTrait<const Key>::DeclType key,
@@ -510,7 +782,7 @@ public:
         }
 
         Node** bucket = m_buckets + bucket_index;
-        Node* new_node = m_hash_impl.allocate(1);
+        Node* new_node = AllocateNode();
         (void) new (new_node) Node(key, value, *bucket, hash_code);
         *bucket = new_node;
         ++m_node_count;
@@ -519,7 +791,24 @@ public:
 
     bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
     {
-        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        return FindWithHash(key, m_hash_impl.hash_policy.DoHash(key), value);
+    }
+
+    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    {
+        return FindWithHash(key, m_hash_impl.hash_policy.DoHash(key));
+    }
+
+    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    {
+        return FindWithHash(key, m_hash_impl.hash_policy.DoHash(key));
+    }
+
+    // Find with the hash code of key given by the caller, who has already
+    // computed it with the hash policy of this map, e.g. for a filter.
+    bool FindWithHash(typename ParamTrait<const Key>::DeclType key,
+                      const ::std::size_t hash_code, Value& value) const
+    {
         const ::std::size_t bucket_index = hash_code % m_bucket_count;
         if (Node* node = FindInBucket(m_buckets + bucket_index, key))
         {
@@ -532,9 +821,9 @@ public:
         }
     }
 
-    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    iterator FindWithHash(typename ParamTrait<const Key>::DeclType key,
+                          const ::std::size_t hash_code)
     {
-        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
         const ::std::size_t bucket_index = hash_code % m_bucket_count;
         if (Node* node = FindInBucket(m_buckets + bucket_index, key))
         {
@@ -546,9 +835,9 @@ public:
         }
     }
 
-    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    const_iterator FindWithHash(typename ParamTrait<const Key>::DeclType key,
+                                const ::std::size_t hash_code) const
     {
-        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
         const ::std::size_t bucket_index = hash_code % m_bucket_count;
         if (Node* node = FindInBucket(m_buckets + bucket_index, key))
         {
@@ -560,6 +849,43 @@ public:
         }
     }
 
+    // Look up keys[0, n) and call callback(i, value) for every keys[i]
+    // found. The lookups are software pipelined: the bucket of keys[i +
+    // 2 * FIND_PREFETCH_DISTANCE] and the first node of keys[i +
+    // FIND_PREFETCH_DISTANCE] are prefetched while keys[i] is searched,
+    // so that their cache misses overlap.
+    template<typename Callback>
+    void FindBatch(const Key* keys, const ::std::size_t n, Callback& callback) const
+    {
+        const ::std::size_t distance = FIND_PREFETCH_DISTANCE;
+        Node** buckets[2 * FIND_PREFETCH_DISTANCE];
+        for (::std::size_t i = 0; i < n + 2 * distance; ++i)
+        {
+            // the slot of keys[i - 2 * distance] is reused by keys[i]
+            Node**& bucket = buckets[i % (2 * distance)];
+            if (i >= 2 * distance)
+            {
+                const ::std::size_t j = i - 2 * distance;
+                if (Node* node = FindInBucket(bucket, keys[j]))
+                {
+                    callback(j, node->value);
+                }
+            }
+
+            if (i >= distance && i - distance < n)
+            {
+                __builtin_prefetch(*buckets[(i - distance) % (2 * distance)]);
+            }
+
+            if (i < n)
+            {
+                const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(keys[i]);
+                bucket = m_buckets + hash_code % m_bucket_count;
+                __builtin_prefetch(bucket);
+            }
+        }
+    }
+
     Value& FindAndInsertIfNotPresent(typename ParamTrait<const Key>::DeclType key)
     {
         const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
@@ -578,7 +904,7 @@ public:
         }
 
         Node** bucket = m_buckets + bucket_index;
-        Node* new_node = m_hash_impl.allocate(1);
+        Node* new_node = AllocateNode();
         (void) new (new_node) Node(key, *bucket, hash_code);
         *bucket = new_node;
         ++m_node_count;
@@ -596,8 +922,8 @@ public:
             if (m_hash_impl.Equal(cur_node->key, key))
             {
                 *prev_node = cur_node->next;
-                cur_node->~Node();
-                m_hash_impl.deallocate(cur_node, 1);
+                DestroyNode(cur_node, IsTrivialNode());
+                DeallocateNode(cur_node);
                 --m_node_count;
 
                 // Try to rehash
@@ -619,23 +945,63 @@ public:
         return false;
     }
 
-    void Clear()
+    // Delete the entry of it and return the iterator to the next one.
+    // No rehash is done, so the other iterators stay valid and the map
+    // can be swept in a single loop.
+    iterator Erase(const_iterator it)
     {
-        Node* node = NULL;
-        Node* next = NULL;
-        for (std::size_t i = 0; i < m_bucket_count; ++i)
+        Node** bucket = it.m_current_bucket;
+        Node* node = it.m_current_node;
+        Node** prev_node = bucket;
+        while (*prev_node != node)
+        {
+            prev_node = &((*prev_node)->next);
+        }
+
+        Node* next = node->next;
+        *prev_node = next;
+        DeleteNode(node);
+        return iterator(bucket, next);
+    }
+
+    // Delete the entries for which pred(key, value) is true, in one scan
+    // of the buckets without hashing any key. The erased nodes are freed
+    // after the scan, all at once if the allocator can release them in bulk.
+    // Returns the number of erased entries.
+    template<typename Predicate>
+    ::std::size_t EraseIf(Predicate pred)
+    {
+        Node* erased_nodes = NULL;
+        ::std::size_t erased_count = 0;
+        for (::std::size_t i = 0; i < m_bucket_count; ++i)
         {
-            node = m_buckets[i];
-            while (node != NULL)
+            Node** prev_node = m_buckets + i;
+            for (Node* node = *prev_node; node != NULL; node = *prev_node)
             {
-                next = node->next;
-                node->~Node();
-                m_hash_impl.deallocate(node, 1);
-                node = next;
+                if (pred(node->key, node->value))
+                {
+                    *prev_node = node->next;
+                    node->next = erased_nodes;
+                    erased_nodes = node;
+                    ++erased_count;
+                }
+                else
+                {
+                    prev_node = &(node->next);
+                }
             }
-            m_buckets[i] = NULL;
         }
 
+        m_node_count -= erased_count;
+        FreeNodes(erased_nodes, IsTrivialNode(), IsBulkRelease());
+        return erased_count;
+    }
+
+    void Clear()
+    {
+        DestroyNodes(IsTrivialNode(), IsBulkRelease());
+        memset(m_buckets, 0, sizeof(Node*) * m_bucket_count);
+
         m_node_count = 0;
         if (m_rehash_impl.rehash_policy.IsRehash(m_bucket_count, m_node_count))
         {
@@ -665,8 +1031,117 @@ public:
         return m_bucket_count;
     }
 
+    // Move the entries of other whose keys are not in this map into it.
+    // Like std::unordered_map::merge, the other entries stay in other.
+    // Nodes are relinked, not copied, when the node allocators are equal,
+    // and the cached hash codes are reused.
+    void Merge(HashMap& other)
+    {
+        MergeImpl(other, static_cast<KeepValue*>(NULL));
+    }
+
+    // Move all the entries of other into this map, leaving other empty.
+    // combiner(value, other_value) updates the value of a key in both maps.
+    template<typename Combiner>
+    void Merge(HashMap& other, Combiner combiner)
+    {
+        MergeImpl(other, &combiner);
+    }
+
+    // Keep only the entries whose keys are also in other.
+    // The lookups are done by iterating the smaller map.
+    void Intersect(const HashMap& other)
+    {
+        if (&other == this)
+        {
+            return;
+        }
+
+        if (m_node_count <= other.m_node_count)
+        {
+            EraseNodes(other, false);
+            return;
+        }
+
+        // pick out the nodes to keep, then drop all the others at once
+        Node* kept_nodes = NULL;
+        ::std::size_t kept_count = 0;
+        for (::std::size_t i = 0; i < other.m_bucket_count; ++i)
+        {
+            for (Node* node = other.m_buckets[i]; node != NULL; node = node->next)
+            {
+                const ::std::size_t hash_code =
+                        this->GetNodeHash(node, m_hash_impl.hash_policy);
+                Node** prev_node = FindPrevInBucket(m_buckets + hash_code % m_bucket_count,
+                                                    node->key);
+                if (prev_node != NULL)
+                {
+                    Node* kept_node = *prev_node;
+                    *prev_node = kept_node->next;
+                    kept_node->next = kept_nodes;
+                    kept_nodes = kept_node;
+                    ++kept_count;
+                }
+            }
+        }
+
+        // not Clear(), which may release the kept nodes with the others
+        DestroyNodes(IsTrivialNode(), BoolType<false>());
+        memset(m_buckets, 0, sizeof(Node*) * m_bucket_count);
+        Node* next = NULL;
+        for (Node* node = kept_nodes; node != NULL; node = next)
+        {
+            next = node->next;
+            Node** bucket = m_buckets +
+                    this->GetNodeHash(node, m_hash_impl.hash_policy) % m_bucket_count;
+            node->next = *bucket;
+            *bucket = node;
+        }
+        m_node_count = kept_count;
+    }
+
+    // Remove the entries whose keys are in other.
+    // The lookups are done by iterating the smaller map.
+    void Difference(const HashMap& other)
+    {
+        if (&other == this)
+        {
+            Clear();
+            return;
+        }
+
+        if (m_node_count <= other.m_node_count)
+        {
+            EraseNodes(other, true);
+            return;
+        }
+
+        for (::std::size_t i = 0; i < other.m_bucket_count; ++i)
+        {
+            for (Node* node = other.m_buckets[i]; node != NULL; node = node->next)
+            {
+                const ::std::size_t hash_code =
+                        this->GetNodeHash(node, m_hash_impl.hash_policy);
+                Node** prev_node = FindPrevInBucket(m_buckets + hash_code % m_bucket_count,
+                                                    node->key);
+                if (prev_node != NULL)
+                {
+                    Node* erased_node = *prev_node;
+                    *prev_node = erased_node->next;
+                    DeleteNode(erased_node);
+                }
+            }
+        }
+    }
+
     ::std::size_t GetBucketCount() const { return m_bucket_count; }
 
+    // The hash code of the key of it, cached in the node if IsCacheHash.
+    ::std::size_t GetHashCode(const_iterator it) const
+    {
+        return this->GetNodeHash(it.m_current_node, m_hash_impl.hash_policy);
+    }
+
     void PrintDebugString() const
     {
         for (::std::size_t i = 0; i < size(); ++i)
@@ -680,6 +1155,8 @@ public:
         }
     }
 
+    allocator_type get_allocator() const { return allocator_type(GetNodeAllocator()); }
+
     NodeAllocator& GetNodeAllocator() { return m_hash_impl; }
     const NodeAllocator& GetNodeAllocator() const { return m_hash_impl; }
     BucketAllocator& GetBucketAllocator() { return m_rehash_impl; }
@@ -715,6 +1192,395 @@ public:
     }
 
 private:
+    typedef BoolType<IsTriviallyDestructible<Key>::Result &&
+                     IsTriviallyDestructible<Value>::Result> IsTrivialNode;
+    typedef BoolType<IsBulkReleaseAllocator<NodeAllocator>::Result> IsBulkRelease;
+    typedef ::std::allocator_traits<NodeAllocator> NodeAllocatorTraits;
+    typedef ::std::allocator_traits<BucketAllocator> BucketAllocatorTraits;
+
+    enum { FIND_PREFETCH_DISTANCE = 16 };
+
+    Node* AllocateNode()
+    {
+        return NodeAllocatorTraits::allocate(GetNodeAllocator(), 1);
+    }
+
+    void DeallocateNode(Node* node)
+    {
+        NodeAllocatorTraits::deallocate(GetNodeAllocator(), node, 1);
+    }
+
+    Node** AllocateBuckets(const ::std::size_t n)
+    {
+        return BucketAllocatorTraits::allocate(GetBucketAllocator(), n);
+    }
+
+    void DeallocateBuckets(Node** buckets, const ::std::size_t n)
+    {
+        BucketAllocatorTraits::deallocate(GetBucketAllocator(), buckets, n);
+    }
+
+    void InitBuckets()
+    {
+        memset(m_buckets, 0, sizeof(Node*) * m_bucket_count);
+        m_buckets[m_bucket_count] = reinterpret_cast<Node*>(0x0123);
+    }
+
+    bool IsSameAllocator(const HashMap& other) const
+    {
+        return (NodeAllocatorTraits::is_always_equal::value ||
+                GetNodeAllocator() == other.GetNodeAllocator()) &&
+               (BucketAllocatorTraits::is_always_equal::value ||
+                GetBucketAllocator() == other.GetBucketAllocator());
+    }
+
+    // Called on an empty map with no buckets allocated.
+    void AssignAllocators(const HashMap& m, BoolType<true>)
+    {
+        GetNodeAllocator() = m.GetNodeAllocator();
+        GetBucketAllocator() = m.GetBucketAllocator();
+    }
+
+    void AssignAllocators(const HashMap&, BoolType<false>) {}
+
+    void AssignPolicies(const HashMap& m)
+    {
+        static_cast<KeyEqual&>(m_hash_impl) = m.m_hash_impl;
+        m_hash_impl.hash_policy = m.m_hash_impl.hash_policy;
+        m_rehash_impl.rehash_policy = m.m_rehash_impl.rehash_policy;
+    }
+
+    void SwapAllocators(HashMap& other, BoolType<true>)
+    {
+        using ::std::swap;
+        swap(GetNodeAllocator(), other.GetNodeAllocator());
+        swap(GetBucketAllocator(), other.GetBucketAllocator());
+    }
+
+    void SwapAllocators(HashMap&, BoolType<false>) {}
+
+    void SwapNodes(HashMap& other)
+    {
+        ::std::swap(m_bucket_count, other.m_bucket_count);
+        ::std::swap(m_buckets, other.m_buckets);
+        ::std::swap(m_node_count, other.m_node_count);
+    }
+
+    // Copy the nodes of m into the allocated but not initialized buckets,
+    // as many as the ones of m.
+    void CopyNodes(const HashMap& m)
+    {
+        // a bulk allocator gives all the nodes in one block
+        Node* nodes = AllocateNodeBlock(m.m_node_count, IsBulkRelease());
+        const unsigned int thread_num =
+                m_rehash_impl.rehash_policy.GetThreadNum(m.m_node_count);
+        if (thread_num > 1)
+        {
+            CopyTask task(*this, m, thread_num, nodes);
+            if (nodes != NULL)
+            {
+                task.is_counting = true;
+                m_rehash_impl.rehash_policy.RunInParallel(thread_num, task);
+                task.is_counting = false;
+                for (unsigned int i = 0; i < thread_num; ++i)
+                {
+                    task.node_offsets[i + 1] += task.node_offsets[i];
+                }
+            }
+            m_rehash_impl.rehash_policy.RunInParallel(thread_num, task);
+            m_node_count = m.m_node_count;
+        }
+        else
+        {
+            m_node_count = CopyBuckets(m, 0, m_bucket_count, nodes);
+        }
+        m_buckets[m_bucket_count] = reinterpret_cast<Node*>(0x0123);
+    }
+
+    // Move all the nodes of m into this empty map.
+    void MoveNodes(HashMap& m)
+    {
+        if (IsSameAllocator(m))
+        {
+            SwapNodes(m);
+        }
+        else
+        {
+            MergeImpl(m, static_cast<KeepValue*>(NULL));
+        }
+    }
+
+    static void DestroyNode(Node*, BoolType<true>) {}
+    static void DestroyNode(Node* node, BoolType<false>) { node->~Node(); }
+
+    // Nothing to walk: the allocator frees every node at once, unless
+    // other allocators share its pool.
+    void DestroyNodes(BoolType<true>, BoolType<true>)
+    {
+        if (m_hash_impl.IsPoolShared())
+        {
+            DestroyNodes(BoolType<true>(), BoolType<false>());
+            return;
+        }
+        m_hash_impl.Release();
+    }
+
+    void DestroyNodes(BoolType<false>, BoolType<true>)
+    {
+        if (m_hash_impl.IsPoolShared())
+        {
+            DestroyNodes(BoolType<false>(), BoolType<false>());
+            return;
+        }
+        for (std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            for (Node* node = m_buckets[i]; node != NULL; node = node->next)
+            {
+                node->~Node();
+            }
+        }
+        m_hash_impl.Release();
+    }
+
+    template<typename IsTrivial>
+    void DestroyNodes(IsTrivial, BoolType<false>)
+    {
+        Node* next = NULL;
+        for (std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            for (Node* node = m_buckets[i]; node != NULL; node = next)
+            {
+                next = node->next;
+                DestroyNode(node, IsTrivial());
+                DeallocateNode(node);
+            }
+        }
+    }
+
+    // Free a list of nodes already unlinked from the buckets.
+    template<typename IsTrivial>
+    void FreeNodes(Node* nodes, IsTrivial, BoolType<false>)
+    {
+        Node* next = NULL;
+        for (Node* node = nodes; node != NULL; node = next)
+        {
+            next = node->next;
+            DestroyNode(node, IsTrivial());
+            DeallocateNode(node);
+        }
+    }
+
+    template<typename IsTrivial>
+    void FreeNodes(Node* nodes, IsTrivial, BoolType<true>)
+    {
+        if (m_node_count > 0 || m_hash_impl.IsPoolShared())
+        {
+            FreeNodes(nodes, IsTrivial(), BoolType<false>());
+            return;
+        }
+
+        for (Node* node = nodes; node != NULL; node = node->next)
+        {
+            DestroyNode(node, IsTrivial());
+        }
+        m_hash_impl.Release();
+    }
+
+    Node* AllocateNodeBlock(const ::std::size_t node_num, BoolType<true>)
+    {
+        return m_hash_impl.AllocateBlock(node_num);
+    }
+
+    Node* AllocateNodeBlock(const ::std::size_t, BoolType<false>)
+    {
+        return NULL;
+    }
+
+    void DeleteNode(Node* node)
+    {
+        DestroyNode(node, IsTrivialNode());
+        DeallocateNode(node);
+        --m_node_count;
+    }
+
+    // The Merge without a combiner.
+    struct KeepValue
+    {
+        void operator()(Value&, const Value&) {}
+    };
+
+    // Combiner is NULL to leave the common keys in other.
+    template<typename Combiner>
+    void MergeImpl(HashMap& other, Combiner* combiner)
+    {
+        if (&other == this)
+        {
+            return;
+        }
+
+        if (m_rehash_impl.rehash_policy.IsRehash(m_bucket_count,
+                                                 m_node_count + other.m_node_count))
+        {
+            RehashImpl(m_rehash_impl.rehash_policy.BucketCountForElements(
+                    m_node_count + other.m_node_count));
+        }
+
+        const bool is_same_allocator = (GetNodeAllocator() == other.GetNodeAllocator());
+        for (::std::size_t i = 0; i < other.m_bucket_count; ++i)
+        {
+            Node** prev_node = other.m_buckets + i;
+            for (Node* node = *prev_node; node != NULL; node = *prev_node)
+            {
+                const ::std::size_t hash_code =
+                        this->GetNodeHash(node, m_hash_impl.hash_policy);
+                Node** bucket = m_buckets + hash_code % m_bucket_count;
+                if (Node* same_node = FindInBucket(bucket, node->key))
+                {
+                    if (combiner == NULL)
+                    {
+                        prev_node = &(node->next);
+                    }
+                    else
+                    {
+                        (*combiner)(same_node->value, node->value);
+                        *prev_node = node->next;
+                        other.DeleteNode(node);
+                    }
+                    continue;
+                }
+
+                *prev_node = node->next;
+                --other.m_node_count;
+                if (!is_same_allocator)
+                {
+                    Node* new_node = AllocateNode();
+                    (void) new (new_node) Node(*node);
+                    other.DestroyNode(node, IsTrivialNode());
+                    other.DeallocateNode(node);
+                    node = new_node;
+                }
+                node->next = *bucket;
+                *bucket = node;
+                ++m_node_count;
+            }
+        }
+    }
+
+    // Erase the nodes whose keys are (or are not, if is_found is false) in other.
+    void EraseNodes(const HashMap& other, const bool is_found)
+    {
+        for (::std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            Node** prev_node = m_buckets + i;
+            for (Node* node = *prev_node; node != NULL; node = *prev_node)
+            {
+                const ::std::size_t hash_code =
+                        this->GetNodeHash(node, m_hash_impl.hash_policy);
+                if ((other.FindInBucket(other.m_buckets + hash_code % other.m_bucket_count,
+                                        node->key) != NULL) == is_found)
+                {
+                    *prev_node = node->next;
+                    DeleteNode(node);
+                }
+                else
+                {
+                    prev_node = &(node->next);
+                }
+            }
+        }
+    }
+
+    // The link pointing to the node of key, or NULL if not found.
+    Node** FindPrevInBucket(Node** bucket, typename ParamTrait<const Key>::DeclType key) const
+    {
+        for (Node** prev_node = bucket; *prev_node != NULL; prev_node = &((*prev_node)->next))
+        {
+            if (m_hash_impl.Equal(key, (*prev_node)->key))
+            {
+                return prev_node;
+            }
+        }
+        return NULL;
+    }
+
+    ::std::size_t CountNodes(const ::std::size_t first, const ::std::size_t last) const
+    {
+        ::std::size_t node_count = 0;
+        for (::std::size_t i = first; i < last; ++i)
+        {
+            for (Node* node = m_buckets[i]; node != NULL; node = node->next)
+            {
+                ++node_count;
+            }
+        }
+        return node_count;
+    }
+
+    // Copy the buckets [first, last) of m, returns the number of nodes copied.
+    // The new nodes are taken in order from nodes if it is not NULL.
+    ::std::size_t CopyBuckets(const HashMap& m, const ::std::size_t first,
+                              const ::std::size_t last, Node* nodes)
+    {
+        ::std::size_t node_count = 0;
+        for (::std::size_t i = first; i < last; ++i)
+        {
+            if (m.m_buckets[i] == NULL)
+            {
+                m_buckets[i] = NULL;
+            }
+            else
+            {
+                Node* node = m.m_buckets[i];
+                Node** prev_node = m_buckets + i;
+                while (node != NULL)
+                {
+                    Node* new_node =
+                            nodes != NULL ? nodes + node_count : AllocateNode();
+                    (void) new (new_node) Node(*node);
+                    new_node->next = NULL;
+                    *prev_node = new_node;
+                    prev_node = &(new_node->next);
+                    node = node->next;
+                    ++node_count;
+                }
+            }
+        }
+        return node_count;
+    }
+
+    // Every thread copies its own range of buckets. When the nodes come
+    // from one block, a counting run first finds where each range starts.
+    struct CopyTask
+    {
+        CopyTask(HashMap& d, const HashMap& s, const unsigned int n, Node* ns)
+        : dst(d), src(s), thread_num(n), nodes(ns), is_counting(false)
+        , node_offsets(n + 1, 0)
+        {}
+
+        void operator()(const unsigned int thread_index)
+        {
+            ::std::size_t first = 0;
+            ::std::size_t last = 0;
+            GetPartition(src.m_bucket_count, thread_num, thread_index, &first, &last);
+            if (is_counting)
+            {
+                node_offsets[thread_index + 1] = src.CountNodes(first, last);
+            }
+            else
+            {
+                (void) dst.CopyBuckets(src, first, last,
+                                       nodes != NULL ? nodes + node_offsets[thread_index] : NULL);
+            }
+        }
+
+        HashMap& dst;
+        const HashMap& src;
+        const unsigned int thread_num;
+        Node* const nodes;
+        bool is_counting;
+        ::std::vector< ::std::size_t> node_offsets;
+    };
+
     Node* FindInBucket(Node** bucket, typename ParamTrait<const Key>::DeclType key) const
     {
         for (Node* node = *bucket; node != NULL; node = node->next)
@@ -729,14 +1595,25 @@ private:
 
     void RehashImpl(std::size_t new_bucket_count)
     {
-        Node** new_buckets = m_rehash_impl.allocate(new_bucket_count + 1);
+        Node** new_buckets = AllocateBuckets(new_bucket_count + 1);
         memset(new_buckets, 0, sizeof(Node*) * new_bucket_count);
         new_buckets[new_bucket_count] = reinterpret_cast<Node*>(0x0123);
 
-        this->DoRehash(m_buckets, m_bucket_count, new_buckets, new_bucket_count,
-                       m_hash_impl.hash_policy);
+        const unsigned int thread_num =
+                m_rehash_impl.rehash_policy.GetThreadNum(m_node_count);
+        if (thread_num > 1)
+        {
+            this->DoParallelRehash(m_buckets, m_bucket_count, new_buckets, new_bucket_count,
+                                   m_hash_impl.hash_policy, thread_num,
+                                   m_rehash_impl.rehash_policy);
+        }
+        else
+        {
+            this->DoRehash(m_buckets, m_bucket_count, new_buckets, new_bucket_count,
+                           m_hash_impl.hash_policy);
+        }
 
-        m_rehash_impl.deallocate(m_buckets, m_bucket_count + 1);
+        DeallocateBuckets(m_buckets, m_bucket_count + 1);
         m_buckets = new_buckets;
         m_bucket_count = new_bucket_count;
     }
@@ -772,6 +1649,35 @@ private:
     ::std::size_t m_node_count;
 };
 
+template<typename Key, typename Value, typename KeyEqual, typename HashPolicy,
+         typename RehashPolicy, typename Allocator, bool IsCacheHash>
+inline void swap(HashMap<Key, Value, KeyEqual, HashPolicy, RehashPolicy, Allocator,
+                         IsCacheHash>& lhs,
+                 HashMap<Key, Value, KeyEqual, HashPolicy, RehashPolicy, Allocator,
+                         IsCacheHash>& rhs)
+{
+    lhs.Swap(rhs);
+}
+
+
+#if __cplusplus >= 201703L
+namespace pmr {
+
+// HashMap allocating its nodes and buckets from a std::pmr::memory_resource,
+// e.g. a std::pmr::monotonic_buffer_resource per request:
+//   pmr::HashMap<int, int> hash_map(0, &resource);
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy,
+         bool IsCacheHash = true>
+using HashMap = ::snippet::algo::HashMap<Key, Value, KeyEqual, HashPolicy, RehashPolicy,
+                                         ::std::pmr::polymorphic_allocator<Key>,
+                                         IsCacheHash>;
+
+}  // namespace pmr
+#endif
+
 }  // namespace algo
 }  // namespace snippet
 
@@ -0,0 +1,202 @@
+#ifndef ALGO_HUGEPAGEALLOCATOR_H_
+#define ALGO_HUGEPAGEALLOCATOR_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace snippet {
+namespace algo {
+
+// Where the pages of a large allocation should live on a NUMA box.
+enum NumaPolicy
+{
+    NUMA_DEFAULT,     // first touch, i.e. the node of the touching thread
+    NUMA_INTERLEAVE,  // round robin over all the nodes
+    NUMA_BIND         // only on the given node
+};
+
+namespace detail {
+
+enum { HUGE_PAGE_SIZE = 2 * 1024 * 1024 };
+
+// Same values as in <numaif.h>, which needs libnuma to be installed.
+enum { MPOL_BIND_MODE = 2, MPOL_INTERLEAVE_MODE = 3 };
+
+// The node mask passed to mbind is a single unsigned long.
+enum { MAX_NUMA_NODES = sizeof(unsigned long) * 8 };
+
+inline ::std::size_t RoundUpToHugePage(::std::size_t bytes)
+{
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~static_cast< ::std::size_t>(HUGE_PAGE_SIZE - 1);
+}
+
+// Map bytes (a multiple of HUGE_PAGE_SIZE) with 2MB pages.
+// Explicit hugetlbfs pages are used when the system has reserved some,
+// otherwise it falls back to normal pages marked for transparent huge pages.
+inline void* MapHugePages(::std::size_t bytes, NumaPolicy policy, int numa_node)
+{
+    void* addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    addr = ::mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (addr == MAP_FAILED)
+    {
+        addr = ::mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+        {
+            throw ::std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        (void) ::madvise(addr, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+#ifdef SYS_mbind
+    // The policy must be set before the pages are touched. A kernel without
+    // NUMA support is not an error, and interleaving is only a hint, but a
+    // NUMA_BIND that the kernel refuses (e.g. the node does not exist)
+    // is reported instead of silently giving memory on another node.
+    if (policy != NUMA_DEFAULT)
+    {
+        unsigned long node_mask = 0;
+        int mode = MPOL_BIND_MODE;
+        if (policy == NUMA_INTERLEAVE)
+        {
+            node_mask = ~0ul;  // the kernel drops the nodes not allowed
+            mode = MPOL_INTERLEAVE_MODE;
+        }
+        else
+        {
+            node_mask = 1ul << numa_node;
+        }
+        if (::syscall(SYS_mbind, addr, bytes, mode, &node_mask,
+                      sizeof(node_mask) * 8, 0) != 0 &&
+            errno != ENOSYS && policy == NUMA_BIND)
+        {
+            const int error = errno;
+            (void) ::munmap(addr, bytes);
+            throw ::std::system_error(error, ::std::system_category(),
+                                      "HugePageAllocator: mbind failed");
+        }
+    }
+#else
+    (void) policy;
+    (void) numa_node;
+#endif
+
+    return addr;
+}
+
+}  // namespace detail
+
+// Allocator backing large arrays (e.g. the HashMap bucket array) with
+// 2MB pages to cut the TLB misses of random accesses, optionally
+// interleaving or binding them to NUMA nodes. Allocations smaller than
+// the threshold, like single HashMap nodes, go to malloc as usual.
+//
+// Pass it as the Allocator of HashMap; the policy is carried by the
+// allocator instances given to the HashMap constructor. The constructor
+// throws std::invalid_argument for a node outside [0, MAX_NUMA_NODES),
+// and allocate throws std::system_error when the kernel refuses NUMA_BIND.
+template<typename T>
+class HugePageAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef ::std::size_t size_type;
+    typedef ::std::ptrdiff_t difference_type;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef HugePageAllocator<Other> other;
+    };
+
+    explicit HugePageAllocator(NumaPolicy policy = NUMA_DEFAULT, int numa_node = 0,
+                               ::std::size_t threshold = detail::HUGE_PAGE_SIZE)
+    : m_policy(policy), m_numa_node(numa_node), m_threshold(threshold)
+    {
+        if (numa_node < 0 || numa_node >= detail::MAX_NUMA_NODES)
+        {
+            throw ::std::invalid_argument("HugePageAllocator: bad NUMA node");
+        }
+    }
+
+    template<typename Other>
+    HugePageAllocator(const HugePageAllocator<Other>& other)
+    : m_policy(other.GetNumaPolicy()), m_numa_node(other.GetNumaNode())
+    , m_threshold(other.GetThreshold())
+    {}
+
+    T* allocate(::std::size_t n, const void* = 0)
+    {
+        const ::std::size_t bytes = n * sizeof(T);
+        if (bytes < m_threshold)
+        {
+            void* p = ::malloc(bytes);
+            if (p == NULL)
+            {
+                throw ::std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        return static_cast<T*>(detail::MapHugePages(detail::RoundUpToHugePage(bytes),
+                                                    m_policy, m_numa_node));
+    }
+
+    void deallocate(T* p, ::std::size_t n)
+    {
+        const ::std::size_t bytes = n * sizeof(T);
+        if (bytes < m_threshold)
+        {
+            ::free(p);
+        }
+        else
+        {
+            (void) ::munmap(p, detail::RoundUpToHugePage(bytes));
+        }
+    }
+
+    NumaPolicy GetNumaPolicy() const { return m_policy; }
+    int GetNumaNode() const { return m_numa_node; }
+    ::std::size_t GetThreshold() const { return m_threshold; }
+
+private:
+    NumaPolicy m_policy;
+    int m_numa_node;
+    ::std::size_t m_threshold;
+};
+
+// The memory is released by size, not by policy, so any two instances
+// can free each other's memory as long as the thresholds agree.
+template<typename T, typename U>
+inline bool operator==(const HugePageAllocator<T>& lhs, const HugePageAllocator<U>& rhs)
+{
+    return lhs.GetThreshold() == rhs.GetThreshold();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const HugePageAllocator<T>& lhs, const HugePageAllocator<U>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_HUGEPAGEALLOCATOR_H_
@@ -0,0 +1,564 @@
+#ifndef ALGO_INLINEHASHMAP_H_
+#define ALGO_INLINEHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// A bucket holding its first node inline; the node's next pointer is the
+// head of the overflow chain.
+template<typename Node>
+struct InlineHashMapBucket
+{
+    Node* GetNode() { return reinterpret_cast<Node*>(&storage); }
+    const Node* GetNode() const { return reinterpret_cast<const Node*>(&storage); }
+
+    typename ::std::aligned_storage<sizeof(Node), ::std::alignment_of<Node>::value>::type storage;
+    bool is_used;
+};
+
+}  // namespace detail
+
+// Same interface as HashMap, but every bucket slot stores its first
+// key/value pair inline and only the other entries of the bucket are
+// chained in heap nodes. A hit on the first entry of a bucket reads one
+// cache line instead of the bucket pointer plus the node.
+//
+// The price is that an empty bucket takes a whole node worth of memory,
+// and rehashing copies the inline entries instead of relinking them.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy,
+         typename Allocator = ::std::allocator<Key> >
+class InlineHashMap
+{
+public:
+    typedef detail::HashMapNode<Key, Value, true> Node;
+    typedef detail::InlineHashMapBucket<Node> Bucket;
+
+private:
+    class IteratorBase
+    {
+        friend bool operator== (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.IsEqual(rhs);
+        }
+
+        friend bool operator!= (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return !lhs.IsEqual(rhs);
+        }
+
+    public:
+        // last_bucket is the one past the end, current_node must be in
+        // current_bucket, or NULL to start from the next used bucket.
+        IteratorBase(Bucket* current_bucket, Bucket* last_bucket, Node* current_node)
+        : m_current_bucket(current_bucket), m_last_bucket(last_bucket)
+        , m_current_node(current_node)
+        {
+            if (m_current_node == NULL)
+            {
+                this->SkipUnusedBuckets();
+            }
+        }
+
+        void Next()
+        {
+            if (m_current_node->next == NULL)
+            {
+                ++m_current_bucket;
+                this->SkipUnusedBuckets();
+            }
+            else
+            {
+                m_current_node = m_current_node->next;
+            }
+        }
+
+    protected:
+        void SkipUnusedBuckets()
+        {
+            while (m_current_bucket != m_last_bucket && !m_current_bucket->is_used)
+            {
+                ++m_current_bucket;
+            }
+            m_current_node = m_current_bucket != m_last_bucket ?
+                    m_current_bucket->GetNode() : NULL;
+        }
+
+        bool IsEqual(const IteratorBase& other) const
+        {
+            return m_current_bucket == other.m_current_bucket &&
+                    m_current_node == other.m_current_node;
+        }
+
+        Bucket* m_current_bucket;
+        Bucket* m_last_bucket;
+        Node* m_current_node;
+    };
+
+public:
+
+    class Iterator : public IteratorBase
+    {
+    public:
+        Iterator(Bucket* current_bucket, Bucket* last_bucket, Node* current_node)
+        : IteratorBase(current_bucket, last_bucket, current_node)
+        {}
+
+        Iterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_current_node->key;
+        }
+
+        Value& GetValue()
+        {
+            return this->m_current_node->value;
+        }
+    };
+
+    class ConstIterator : public IteratorBase
+    {
+    public:
+        ConstIterator(Bucket* current_bucket, Bucket* last_bucket, Node* current_node)
+        : IteratorBase(current_bucket, last_bucket, current_node)
+        {}
+
+        // We can convert a Iterator to ConstIterator
+        ConstIterator(const Iterator& it)
+        : IteratorBase(it)
+        {}
+
+        ConstIterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_current_node->key;
+        }
+
+        typename ParamTrait<const Value>::DeclType GetValue() const
+        {
+            return this->m_current_node->value;
+        }
+    };
+
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Node>
+            NodeAllocator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Bucket>
+            BucketAllocator;
+
+    typedef KeyEqual key_equal;
+    typedef HashPolicy hash_policy;
+    typedef RehashPolicy rehash_policy;
+
+    InlineHashMap(std::size_t size_hint = 0,
+                  const KeyEqual& key_equal = KeyEqual(),
+                  const HashPolicy& hash_policy = HashPolicy(),
+                  const RehashPolicy& rehash_policy = RehashPolicy(),
+                  const NodeAllocator& node_alloc = NodeAllocator(),
+                  const BucketAllocator& bucket_alloc = BucketAllocator())
+    : m_hash_impl(node_alloc, key_equal, hash_policy)
+    , m_rehash_impl(bucket_alloc, rehash_policy)
+    , m_bucket_count(rehash_policy.NextBucketCount(size_hint))
+    , m_buckets(NewBuckets(m_bucket_count))
+    , m_node_count(0)
+    {}
+
+    InlineHashMap(const InlineHashMap& m)
+    : m_hash_impl(m.m_hash_impl)
+    , m_rehash_impl(m.m_rehash_impl)
+    , m_bucket_count(m.m_bucket_count)
+    , m_buckets(NewBuckets(m.m_bucket_count))
+    , m_node_count(m.m_node_count)
+    {
+        for (::std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            const Bucket& bucket = m.m_buckets[i];
+            if (!bucket.is_used)
+            {
+                continue;
+            }
+
+            Node* node = new (m_buckets[i].GetNode()) Node(*bucket.GetNode());
+            m_buckets[i].is_used = true;
+            for (Node* other = node->next; other != NULL; other = other->next)
+            {
+                Node* new_node = m_hash_impl.allocate(1);
+                (void) new (new_node) Node(*other);
+                node->next = new_node;
+                node = new_node;
+            }
+            node->next = NULL;
+        }
+    }
+
+    // Do NOT derive from this class
+    ~InlineHashMap()
+    {
+        Clear();
+        m_rehash_impl.deallocate(m_buckets, m_bucket_count + 1);
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        if (FindInBucket(m_buckets + hash_code % m_bucket_count, key, hash_code) != NULL)
+        {
+            return false;
+        }
+
+        (void) AddNode(key, value, hash_code);
+        return true;
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        if (Node* node = FindInBucket(m_buckets + hash_code % m_bucket_count, key, hash_code))
+        {
+            value = node->value;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        Bucket* bucket = m_buckets + hash_code % m_bucket_count;
+        if (Node* node = FindInBucket(bucket, key, hash_code))
+        {
+            return iterator(bucket, m_buckets + m_bucket_count, node);
+        }
+        else
+        {
+            return end();
+        }
+    }
+
+    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        Bucket* bucket = m_buckets + hash_code % m_bucket_count;
+        if (Node* node = FindInBucket(bucket, key, hash_code))
+        {
+            return const_iterator(bucket, m_buckets + m_bucket_count, node);
+        }
+        else
+        {
+            return end();
+        }
+    }
+
+    Value& FindAndInsertIfNotPresent(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        if (Node* node = FindInBucket(m_buckets + hash_code % m_bucket_count, key, hash_code))
+        {
+            return node->value;
+        }
+
+        return AddNode(key, Value(), hash_code)->value;
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        Bucket* bucket = m_buckets + hash_code % m_bucket_count;
+        if (!bucket->is_used)
+        {
+            return false;
+        }
+
+        Node* first = bucket->GetNode();
+        if (first->cached_hash == hash_code && m_hash_impl.Equal(first->key, key))
+        {
+            Node* overflow = first->next;
+            first->~Node();
+            if (overflow == NULL)
+            {
+                bucket->is_used = false;
+            }
+            else
+            {
+                // pull the first overflow node into the slot
+                (void) new (first) Node(*overflow);
+                DeleteNode(overflow);
+            }
+            --m_node_count;
+            return true;
+        }
+
+        Node** prev_node = &(first->next);
+        for (Node* cur_node = *prev_node; cur_node != NULL; cur_node = *prev_node)
+        {
+            if (cur_node->cached_hash == hash_code && m_hash_impl.Equal(cur_node->key, key))
+            {
+                *prev_node = cur_node->next;
+                DeleteNode(cur_node);
+                --m_node_count;
+                return true;
+            }
+            prev_node = &(cur_node->next);
+        }
+
+        return false;
+    }
+
+    void Clear()
+    {
+        for (std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            Bucket& bucket = m_buckets[i];
+            if (!bucket.is_used)
+            {
+                continue;
+            }
+
+            Node* next = NULL;
+            for (Node* node = bucket.GetNode()->next; node != NULL; node = next)
+            {
+                next = node->next;
+                DeleteNode(node);
+            }
+            bucket.GetNode()->~Node();
+            bucket.is_used = false;
+        }
+        m_node_count = 0;
+    }
+
+    // if hint is 0, then try to rehash to fit the current node_count;
+    // returns the new bucket_count
+    ::std::size_t Rehash(std::size_t size_hint = 0)
+    {
+        if (size_hint == 0)
+        {
+            size_hint = m_rehash_impl.rehash_policy.BucketCountForElements(m_node_count);
+        }
+        else
+        {
+            size_hint = m_rehash_impl.rehash_policy.NextBucketCount(size_hint);
+        }
+
+        if (size_hint != m_bucket_count)
+        {
+            RehashImpl(size_hint);
+        }
+        return m_bucket_count;
+    }
+
+    ::std::size_t GetBucketCount() const { return m_bucket_count; }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_node_count; }
+    bool empty() const { return m_node_count == 0; }
+    void clear() { Clear(); }
+
+    Value& operator[] (typename ParamTrait<const Key>::DeclType key)
+    {
+        return FindAndInsertIfNotPresent(key);
+    }
+
+    iterator begin() { return iterator(m_buckets, m_buckets + m_bucket_count, NULL); }
+    const_iterator begin() const
+    {
+        return const_iterator(m_buckets, m_buckets + m_bucket_count, NULL);
+    }
+
+    iterator end()
+    {
+        return iterator(m_buckets + m_bucket_count, m_buckets + m_bucket_count, NULL);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(m_buckets + m_bucket_count, m_buckets + m_bucket_count, NULL);
+    }
+
+private:
+    Bucket* NewBuckets(const std::size_t bucket_count)
+    {
+        // one more bucket so that end() is a valid pointer
+        Bucket* buckets = m_rehash_impl.allocate(bucket_count + 1);
+        for (std::size_t i = 0; i <= bucket_count; ++i)
+        {
+            buckets[i].is_used = false;
+        }
+        return buckets;
+    }
+
+    Node* FindInBucket(Bucket* bucket, typename ParamTrait<const Key>::DeclType key,
+                       const std::size_t hash_code) const
+    {
+        if (!bucket->is_used)
+        {
+            return NULL;
+        }
+
+        for (Node* node = bucket->GetNode(); node != NULL; node = node->next)
+        {
+            if (node->cached_hash == hash_code && m_hash_impl.Equal(key, node->key))
+            {
+                return node;
+            }
+        }
+        return NULL;
+    }
+
+    // key must not be in the map.
+    Node* AddNode(typename ParamTrait<const Key>::DeclType key,
+                  typename ParamTrait<const Value>::DeclType value,
+                  const std::size_t hash_code)
+    {
+        if (m_rehash_impl.rehash_policy.IsRehash(m_bucket_count, m_node_count + 1))
+        {
+            RehashImpl(m_rehash_impl.rehash_policy.BucketCountForElements(m_node_count + 1));
+        }
+
+        ++m_node_count;
+        Bucket* bucket = m_buckets + hash_code % m_bucket_count;
+        if (!bucket->is_used)
+        {
+            bucket->is_used = true;
+            return new (bucket->GetNode()) Node(key, value, NULL, hash_code);
+        }
+
+        Node* first = bucket->GetNode();
+        Node* new_node = m_hash_impl.allocate(1);
+        (void) new (new_node) Node(key, value, first->next, hash_code);
+        first->next = new_node;
+        return new_node;
+    }
+
+    void DeleteNode(Node* node)
+    {
+        node->~Node();
+        m_hash_impl.deallocate(node, 1);
+    }
+
+    // Link node, an overflow node of the old buckets, into buckets.
+    void MoveNode(Node* node, Bucket* buckets, const std::size_t bucket_count)
+    {
+        Bucket* bucket = buckets + node->cached_hash % bucket_count;
+        if (!bucket->is_used)
+        {
+            Node* first = new (bucket->GetNode()) Node(*node);
+            first->next = NULL;
+            bucket->is_used = true;
+            DeleteNode(node);
+        }
+        else
+        {
+            Node* first = bucket->GetNode();
+            node->next = first->next;
+            first->next = node;
+        }
+    }
+
+    void RehashImpl(std::size_t new_bucket_count)
+    {
+        Bucket* new_buckets = NewBuckets(new_bucket_count);
+        for (std::size_t i = 0; i < m_bucket_count; ++i)
+        {
+            Bucket& bucket = m_buckets[i];
+            if (!bucket.is_used)
+            {
+                continue;
+            }
+
+            Node* first = bucket.GetNode();
+            Node* next = NULL;
+            for (Node* node = first->next; node != NULL; node = next)
+            {
+                next = node->next;
+                MoveNode(node, new_buckets, new_bucket_count);
+            }
+
+            // the inline node is copied to a new slot or a new overflow node
+            Bucket* new_bucket = new_buckets + first->cached_hash % new_bucket_count;
+            if (!new_bucket->is_used)
+            {
+                Node* node = new (new_bucket->GetNode()) Node(*first);
+                node->next = NULL;
+                new_bucket->is_used = true;
+            }
+            else
+            {
+                Node* new_first = new_bucket->GetNode();
+                Node* node = m_hash_impl.allocate(1);
+                (void) new (node) Node(*first);
+                node->next = new_first->next;
+                new_first->next = node;
+            }
+            first->~Node();
+        }
+
+        m_rehash_impl.deallocate(m_buckets, m_bucket_count + 1);
+        m_buckets = new_buckets;
+        m_bucket_count = new_bucket_count;
+    }
+
+    InlineHashMap& operator=(const InlineHashMap&);
+
+    struct HashPolicyAndNodeAllocator : public NodeAllocator, public KeyEqual
+    {
+        HashPolicyAndNodeAllocator(const NodeAllocator& alloc,
+                                   const KeyEqual& key_equal,
+                                   const HashPolicy& policy)
+        : NodeAllocator(alloc), KeyEqual(key_equal), hash_policy(policy)
+        {}
+
+        HashPolicy hash_policy;
+    };
+
+    HashPolicyAndNodeAllocator m_hash_impl;
+
+    struct RehashPolicyAndBucketAllocator : public BucketAllocator
+    {
+        RehashPolicyAndBucketAllocator(const BucketAllocator& alloc,
+                                       const RehashPolicy& policy)
+        : BucketAllocator(alloc), rehash_policy(policy)
+        {}
+
+        RehashPolicy rehash_policy;
+    };
+
+    RehashPolicyAndBucketAllocator m_rehash_impl;
+
+    ::std::size_t m_bucket_count;
+    Bucket* m_buckets;
+    ::std::size_t m_node_count;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_INLINEHASHMAP_H_
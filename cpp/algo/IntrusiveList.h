@@ -89,6 +89,11 @@ struct IntrusiveListStorage<Node, false>
         Delete(prev, next);
     }
 
+    static void Unlink(Node* node)
+    {
+        Delete(node->prev, node->next);
+    }
+
     void Clear() { head.next = head.prev = &head; }
 };
 
@@ -305,6 +310,14 @@ public:
         return NodeToElem(node);
     }
 
+    // Remove elem from whatever list it is linked in, in O(1).
+    // Only lists without STORE_SIZE support this, because the owning
+    // list is not needed to update its size.
+    static void Unlink(T* elem)
+    {
+        detail::IntrusiveListStorage<Node, STORE_SIZE>::Unlink(&(elem->*MemberOffset));
+    }
+
     ::std::size_t GetUsedBytes() const { return sizeof(*this) + sizeof(T) * size(); }
 
 private:
@@ -0,0 +1,624 @@
+#ifndef ALGO_ORDEREDHASHMAP_H_
+#define ALGO_ORDEREDHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/ParamTrait.h"
+#include "algo/TypeTrait.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <stdint.h>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+template<typename Key, typename Value>
+struct OrderedHashMapItem
+{
+    OrderedHashMapItem(typename ParamTrait<const Key>::DeclType k,
+                       typename ParamTrait<const Value>::DeclType v)
+    : key(k), value(v)
+    {}
+
+    const Key key;
+    Value value;
+};
+
+}  // namespace detail
+
+// Hash map iterating in insertion order, laid out like the dict of
+// CPython 3.6: the entries are appended to a dense array, and an open
+// addressing index table holds their positions in 1, 2, 4 or 8 bytes
+// depending on its size. Iterating is a linear scan of the entries, and
+// the index table of a map with less than 128 entries is a few bytes.
+//
+// Delete leaves a hole in the entries, which are compacted when the
+// array is full. Insert, Delete and Clear all invalidate the iterators:
+// an Insert that compacts or grows the entry array moves the entries,
+// like std::vector.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename Allocator = ::std::allocator<Key> >
+class OrderedHashMap
+{
+public:
+    typedef detail::OrderedHashMapItem<Key, Value> Item;
+
+    struct Entry
+    {
+        Item* GetItem() { return reinterpret_cast<Item*>(&storage); }
+        const Item* GetItem() const { return reinterpret_cast<const Item*>(&storage); }
+        bool IsDeleted() const { return hash == DELETED_HASH; }
+
+        ::std::size_t hash;
+        typename ::std::aligned_storage<sizeof(Item), ::std::alignment_of<Item>::value>::type
+                storage;
+    };
+
+private:
+    static const ::std::size_t DELETED_HASH = ~static_cast< ::std::size_t>(0);
+
+    class IteratorBase
+    {
+        friend bool operator== (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.m_entry == rhs.m_entry;
+        }
+
+        friend bool operator!= (const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.m_entry != rhs.m_entry;
+        }
+
+    public:
+        IteratorBase(Entry* entry, Entry* end)
+        : m_entry(entry), m_end(end)
+        {
+            SkipDeleted();
+        }
+
+    protected:
+        void Next()
+        {
+            ++m_entry;
+            SkipDeleted();
+        }
+
+        void SkipDeleted()
+        {
+            while (m_entry != m_end && m_entry->IsDeleted())
+            {
+                ++m_entry;
+            }
+        }
+
+        Entry* m_entry;
+        Entry* m_end;
+    };
+
+public:
+
+    class Iterator : public IteratorBase
+    {
+    public:
+        Iterator(Entry* entry, Entry* end)
+        : IteratorBase(entry, end)
+        {}
+
+        Iterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_entry->GetItem()->key;
+        }
+
+        Value& GetValue()
+        {
+            return this->m_entry->GetItem()->value;
+        }
+    };
+
+    class ConstIterator : public IteratorBase
+    {
+    public:
+        ConstIterator(const Entry* entry, const Entry* end)
+        : IteratorBase(const_cast<Entry*>(entry), const_cast<Entry*>(end))
+        {}
+
+        // We can convert a Iterator to ConstIterator
+        ConstIterator(const Iterator& it)
+        : IteratorBase(it)
+        {}
+
+        ConstIterator& operator++()
+        {
+            this->Next();
+            return *this;
+        }
+
+        typename ParamTrait<const Key>::DeclType GetKey() const
+        {
+            return this->m_entry->GetItem()->key;
+        }
+
+        typename ParamTrait<const Value>::DeclType GetValue() const
+        {
+            return this->m_entry->GetItem()->value;
+        }
+    };
+
+    typedef Key KeyType;
+    typedef Value ValueType;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<Entry>
+            EntryAllocator;
+    typedef typename ::std::allocator_traits<Allocator>::template rebind_alloc<unsigned char>
+            IndexAllocator;
+
+    typedef KeyEqual key_equal;
+    typedef HashPolicy hash_policy;
+
+    OrderedHashMap(std::size_t size_hint = 0,
+                   const KeyEqual& key_equal = KeyEqual(),
+                   const HashPolicy& hash_policy = HashPolicy(),
+                   const EntryAllocator& entry_alloc = EntryAllocator(),
+                   const IndexAllocator& index_alloc = IndexAllocator())
+    : m_hash_impl(entry_alloc, key_equal, hash_policy)
+    , m_index_alloc(index_alloc)
+    , m_index_size(0)
+    , m_index_width(0)
+    , m_indices(NULL)
+    , m_entries(NULL)
+    , m_entry_count(0)
+    , m_entry_capacity(0)
+    , m_node_count(0)
+    {
+        AllocateTable(GetIndexSizeFor(size_hint));
+    }
+
+    OrderedHashMap(const OrderedHashMap& m)
+    : m_hash_impl(m.m_hash_impl)
+    , m_index_alloc(m.m_index_alloc)
+    , m_index_size(0)
+    , m_index_width(0)
+    , m_indices(NULL)
+    , m_entries(NULL)
+    , m_entry_count(0)
+    , m_entry_capacity(0)
+    , m_node_count(0)
+    {
+        AllocateTable(m.m_index_size);
+        ::memcpy(m_indices, m.m_indices, m_index_size * m_index_width);
+        CopyEntries(m_entries, m.m_entries, m.m_entry_count, IsTrivialItem());
+        m_entry_count = m.m_entry_count;
+        m_node_count = m.m_node_count;
+    }
+
+    // Do NOT derive from this class
+    ~OrderedHashMap()
+    {
+        DestroyEntries(m_entries, m_entry_count, IsTrivialItem());
+        DeallocateTable();
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        const std::size_t hash_code = HashCode(key);
+        std::size_t slot = 0;
+        if (FindEntry(key, hash_code, &slot) != NIL_INDEX)
+        {
+            return false;
+        }
+
+        (void) AddEntry(key, value, hash_code, slot);
+        return true;
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        std::size_t slot = 0;
+        const std::size_t index = FindEntry(key, HashCode(key), &slot);
+        if (index != NIL_INDEX)
+        {
+            value = m_entries[index].GetItem()->value;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    iterator Find(typename ParamTrait<const Key>::DeclType key)
+    {
+        std::size_t slot = 0;
+        const std::size_t index = FindEntry(key, HashCode(key), &slot);
+        return index != NIL_INDEX ?
+                iterator(m_entries + index, m_entries + m_entry_count) : end();
+    }
+
+    const_iterator Find(typename ParamTrait<const Key>::DeclType key) const
+    {
+        std::size_t slot = 0;
+        const std::size_t index = FindEntry(key, HashCode(key), &slot);
+        return index != NIL_INDEX ?
+                const_iterator(m_entries + index, m_entries + m_entry_count) : end();
+    }
+
+    Value& FindAndInsertIfNotPresent(typename ParamTrait<const Key>::DeclType key)
+    {
+        const std::size_t hash_code = HashCode(key);
+        std::size_t slot = 0;
+        const std::size_t index = FindEntry(key, hash_code, &slot);
+        if (index != NIL_INDEX)
+        {
+            return m_entries[index].GetItem()->value;
+        }
+
+        return AddEntry(key, Value(), hash_code, slot)->value;
+    }
+
+    // The order of the other entries is kept.
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        std::size_t slot = 0;
+        const std::size_t index = FindEntry(key, HashCode(key), &slot);
+        if (index == NIL_INDEX)
+        {
+            return false;
+        }
+
+        SetIndex(slot, GetDummyIndex());
+        DestroyItem(m_entries + index, IsTrivialItem());
+        m_entries[index].hash = DELETED_HASH;
+        --m_node_count;
+        return true;
+    }
+
+    void Clear()
+    {
+        DestroyEntries(m_entries, m_entry_count, IsTrivialItem());
+        m_entry_count = 0;
+        m_node_count = 0;
+        ::memset(m_indices, 0xff, m_index_size * m_index_width);
+    }
+
+    ::std::size_t GetIndexSize() const { return m_index_size; }
+
+    // Bytes held by the index table and the entry array.
+    ::std::size_t GetMemoryUsage() const
+    {
+        return m_index_size * m_index_width + m_entry_capacity * sizeof(Entry);
+    }
+
+    // STL compatible methods
+    ::std::size_t size() const { return m_node_count; }
+    bool empty() const { return m_node_count == 0; }
+    void clear() { Clear(); }
+
+    Value& operator[] (typename ParamTrait<const Key>::DeclType key)
+    {
+        return FindAndInsertIfNotPresent(key);
+    }
+
+    iterator begin() { return iterator(m_entries, m_entries + m_entry_count); }
+    const_iterator begin() const
+    {
+        return const_iterator(m_entries, m_entries + m_entry_count);
+    }
+
+    iterator end()
+    {
+        return iterator(m_entries + m_entry_count, m_entries + m_entry_count);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(m_entries + m_entry_count, m_entries + m_entry_count);
+    }
+
+private:
+    enum { MIN_INDEX_SIZE = 8, PERTURB_SHIFT = 5 };
+
+    static const ::std::size_t NIL_INDEX = ~static_cast< ::std::size_t>(0);
+
+    typedef BoolType< ::std::is_trivially_copyable<Item>::value> IsTrivialItem;
+
+    // 2/3 of the index table can be used, as in CPython.
+    static ::std::size_t GetUsableSize(const ::std::size_t index_size)
+    {
+        return index_size * 2 / 3;
+    }
+
+    static ::std::size_t GetIndexSizeFor(const ::std::size_t entry_num)
+    {
+        ::std::size_t index_size = MIN_INDEX_SIZE;
+        while (GetUsableSize(index_size) < entry_num)
+        {
+            index_size <<= 1;
+        }
+        return index_size;
+    }
+
+    // The all ones index is an empty slot and the one below a deleted one.
+    static unsigned int GetIndexWidth(const ::std::size_t index_size)
+    {
+        if (index_size <= 0x80)
+        {
+            return 1;
+        }
+        else if (index_size <= 0x8000)
+        {
+            return 2;
+        }
+        else if (index_size <= 0x80000000ull)
+        {
+            return 4;
+        }
+        return 8;
+    }
+
+    ::std::size_t GetEmptyIndex() const
+    {
+        return m_index_width == 8 ? NIL_INDEX :
+                ((static_cast< ::std::size_t>(1) << (m_index_width * 8)) - 1);
+    }
+
+    ::std::size_t GetDummyIndex() const
+    {
+        return GetEmptyIndex() - 1;
+    }
+
+    ::std::size_t GetIndex(const ::std::size_t slot) const
+    {
+        switch (m_index_width)
+        {
+        case 1:
+            return reinterpret_cast<const uint8_t*>(m_indices)[slot];
+        case 2:
+            return reinterpret_cast<const uint16_t*>(m_indices)[slot];
+        case 4:
+            return reinterpret_cast<const uint32_t*>(m_indices)[slot];
+        default:
+            return reinterpret_cast<const uint64_t*>(m_indices)[slot];
+        }
+    }
+
+    void SetIndex(const ::std::size_t slot, const ::std::size_t index)
+    {
+        switch (m_index_width)
+        {
+        case 1:
+            reinterpret_cast<uint8_t*>(m_indices)[slot] = static_cast<uint8_t>(index);
+            break;
+        case 2:
+            reinterpret_cast<uint16_t*>(m_indices)[slot] = static_cast<uint16_t>(index);
+            break;
+        case 4:
+            reinterpret_cast<uint32_t*>(m_indices)[slot] = static_cast<uint32_t>(index);
+            break;
+        default:
+            reinterpret_cast<uint64_t*>(m_indices)[slot] = index;
+            break;
+        }
+    }
+
+    ::std::size_t HashCode(typename ParamTrait<const Key>::DeclType key) const
+    {
+        const ::std::size_t hash_code = m_hash_impl.hash_policy.DoHash(key);
+        return hash_code != DELETED_HASH ? hash_code : 0;
+    }
+
+    // Returns the entry index of key, or NIL_INDEX with *slot set to where
+    // its index should be inserted.
+    ::std::size_t FindEntry(typename ParamTrait<const Key>::DeclType key,
+                            const ::std::size_t hash_code, ::std::size_t* slot) const
+    {
+        const ::std::size_t empty_index = GetEmptyIndex();
+        const ::std::size_t dummy_index = GetDummyIndex();
+        const ::std::size_t mask = m_index_size - 1;
+        ::std::size_t free_slot = NIL_INDEX;
+        ::std::size_t perturb = hash_code;
+        ::std::size_t i = hash_code & mask;
+        for (;;)
+        {
+            const ::std::size_t index = GetIndex(i);
+            if (index == empty_index)
+            {
+                *slot = free_slot != NIL_INDEX ? free_slot : i;
+                return NIL_INDEX;
+            }
+            else if (index == dummy_index)
+            {
+                if (free_slot == NIL_INDEX)
+                {
+                    free_slot = i;
+                }
+            }
+            else
+            {
+                const Entry& entry = m_entries[index];
+                if (entry.hash == hash_code &&
+                    m_hash_impl.Equal(key, entry.GetItem()->key))
+                {
+                    *slot = i;
+                    return index;
+                }
+            }
+
+            perturb >>= PERTURB_SHIFT;
+            i = (i * 5 + perturb + 1) & mask;
+        }
+    }
+
+    // The first empty slot for hash_code, in a table without deleted entries.
+    ::std::size_t FindEmptySlot(const ::std::size_t hash_code) const
+    {
+        const ::std::size_t empty_index = GetEmptyIndex();
+        const ::std::size_t mask = m_index_size - 1;
+        ::std::size_t perturb = hash_code;
+        ::std::size_t i = hash_code & mask;
+        while (GetIndex(i) != empty_index)
+        {
+            perturb >>= PERTURB_SHIFT;
+            i = (i * 5 + perturb + 1) & mask;
+        }
+        return i;
+    }
+
+    // key must not be in the map, slot is from FindEntry.
+    Item* AddEntry(typename ParamTrait<const Key>::DeclType key,
+                   typename ParamTrait<const Value>::DeclType value,
+                   const ::std::size_t hash_code, ::std::size_t slot)
+    {
+        if (m_entry_count == m_entry_capacity)
+        {
+            // as CPython, grow to hold 3 times the live entries
+            Resize(GetIndexSizeFor(m_node_count * 3));
+            slot = FindEmptySlot(hash_code);
+        }
+
+        Entry* entry = m_entries + m_entry_count;
+        Item* item = new (entry->GetItem()) Item(key, value);
+        entry->hash = hash_code;
+        SetIndex(slot, m_entry_count);
+        ++m_entry_count;
+        ++m_node_count;
+        return item;
+    }
+
+    // Drops the deleted entries and rebuilds the index table.
+    void Resize(const ::std::size_t new_index_size)
+    {
+        unsigned char* old_indices = m_indices;
+        Entry* old_entries = m_entries;
+        const ::std::size_t old_index_size = m_index_size;
+        const unsigned int old_index_width = m_index_width;
+        const ::std::size_t old_entry_count = m_entry_count;
+        const ::std::size_t old_entry_capacity = m_entry_capacity;
+
+        AllocateTable(new_index_size);
+        m_entry_count = 0;
+        for (::std::size_t i = 0; i < old_entry_count; ++i)
+        {
+            if (!old_entries[i].IsDeleted())
+            {
+                MoveEntry(m_entries + m_entry_count, old_entries + i, IsTrivialItem());
+                SetIndex(FindEmptySlot(old_entries[i].hash), m_entry_count);
+                ++m_entry_count;
+            }
+        }
+
+        m_index_alloc.deallocate(old_indices, old_index_size * old_index_width);
+        m_hash_impl.deallocate(old_entries, old_entry_capacity);
+    }
+
+    void AllocateTable(const ::std::size_t index_size)
+    {
+        m_index_size = index_size;
+        m_index_width = GetIndexWidth(index_size);
+        m_indices = m_index_alloc.allocate(index_size * m_index_width);
+        ::memset(m_indices, 0xff, index_size * m_index_width);
+        m_entry_capacity = GetUsableSize(index_size);
+        m_entries = m_hash_impl.allocate(m_entry_capacity);
+    }
+
+    void DeallocateTable()
+    {
+        m_index_alloc.deallocate(m_indices, m_index_size * m_index_width);
+        m_hash_impl.deallocate(m_entries, m_entry_capacity);
+    }
+
+    static void MoveEntry(Entry* dest, Entry* src, BoolType<true>)
+    {
+        ::memcpy(static_cast<void*>(dest), src, sizeof(Entry));
+    }
+
+    static void MoveEntry(Entry* dest, Entry* src, BoolType<false>)
+    {
+        (void) new (dest->GetItem()) Item(*src->GetItem());
+        dest->hash = src->hash;
+        src->GetItem()->~Item();
+    }
+
+    static void CopyEntries(Entry* dest, const Entry* src, const ::std::size_t n, BoolType<true>)
+    {
+        if (n > 0)
+        {
+            ::memcpy(static_cast<void*>(dest), src, n * sizeof(Entry));
+        }
+    }
+
+    static void CopyEntries(Entry* dest, const Entry* src, const ::std::size_t n, BoolType<false>)
+    {
+        for (::std::size_t i = 0; i < n; ++i)
+        {
+            dest[i].hash = src[i].hash;
+            if (!src[i].IsDeleted())
+            {
+                (void) new (dest[i].GetItem()) Item(*src[i].GetItem());
+            }
+        }
+    }
+
+    static void DestroyItem(Entry*, BoolType<true>) {}
+
+    static void DestroyItem(Entry* entry, BoolType<false>)
+    {
+        entry->GetItem()->~Item();
+    }
+
+    static void DestroyEntries(Entry*, const ::std::size_t, BoolType<true>) {}
+
+    static void DestroyEntries(Entry* entries, const ::std::size_t n, BoolType<false>)
+    {
+        for (::std::size_t i = 0; i < n; ++i)
+        {
+            if (!entries[i].IsDeleted())
+            {
+                entries[i].GetItem()->~Item();
+            }
+        }
+    }
+
+    OrderedHashMap& operator=(const OrderedHashMap&);
+
+    struct HashPolicyAndEntryAllocator : public EntryAllocator, public KeyEqual
+    {
+        HashPolicyAndEntryAllocator(const EntryAllocator& alloc,
+                                    const KeyEqual& key_equal,
+                                    const HashPolicy& policy)
+        : EntryAllocator(alloc), KeyEqual(key_equal), hash_policy(policy)
+        {}
+
+        HashPolicy hash_policy;
+    };
+
+    HashPolicyAndEntryAllocator m_hash_impl;
+    IndexAllocator m_index_alloc;
+
+    ::std::size_t m_index_size;
+    unsigned int m_index_width;
+    unsigned char* m_indices;
+    Entry* m_entries;
+    ::std::size_t m_entry_count;  // including the deleted ones
+    ::std::size_t m_entry_capacity;
+    ::std::size_t m_node_count;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_ORDEREDHASHMAP_H_
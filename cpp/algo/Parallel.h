@@ -0,0 +1,90 @@
+#ifndef ALGO_PARALLEL_H_
+#define ALGO_PARALLEL_H_
+
+#include "algo/Partition.h"
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// Runs task(i) and keeps what it throws instead of letting the
+// exception leave a thread, which would call std::terminate.
+template<typename Task>
+struct CatchingTask
+{
+    CatchingTask(Task& t, const unsigned int n)
+    : task(t), errors(n)
+    {}
+
+    void operator()(const unsigned int i)
+    {
+        try
+        {
+            task(i);
+        }
+        catch (...)
+        {
+            errors[i] = ::std::current_exception();
+        }
+    }
+
+    Task& task;
+    ::std::vector< ::std::exception_ptr> errors;
+};
+
+}  // namespace detail
+
+// Call task(i) for every i in [0, thread_num), each on its own thread,
+// and wait for all of them. task(0) runs on the calling thread, and so
+// do the tasks whose thread could not be created. All the tasks finish
+// before the first exception thrown by one of them is rethrown here.
+template<typename Task>
+void RunInParallel(const unsigned int thread_num, Task& task)
+{
+    detail::CatchingTask<Task> catching_task(task, thread_num);
+    ::std::vector< ::std::thread> threads;
+    threads.reserve(thread_num > 0 ? thread_num - 1 : 0);
+    unsigned int i = 1;
+    for (; i < thread_num; ++i)
+    {
+        try
+        {
+            threads.push_back(::std::thread(::std::ref(catching_task), i));
+        }
+        catch (const ::std::system_error&)
+        {
+            break;
+        }
+    }
+
+    for (; i < thread_num; ++i)
+    {
+        catching_task(i);
+    }
+    catching_task(0);
+    for (::std::size_t j = 0; j < threads.size(); ++j)
+    {
+        threads[j].join();
+    }
+
+    for (i = 0; i < thread_num; ++i)
+    {
+        if (catching_task.errors[i])
+        {
+            ::std::rethrow_exception(catching_task.errors[i]);
+        }
+    }
+}
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_PARALLEL_H_
@@ -0,0 +1,104 @@
+#ifndef ALGO_PARALLELHASHMAP_H_
+#define ALGO_PARALLELHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/Parallel.h"
+
+#include <cstddef>
+
+namespace snippet {
+namespace algo {
+
+// Rehash policy splitting the rehash and the copy of large maps over
+// threads. A map of node_count nodes uses
+// min(node_count / MIN_NODES_PER_THREAD, thread_num) threads, so it only
+// goes parallel from 2 * MIN_NODES_PER_THREAD nodes. The node allocator
+// has to be thread safe in that case.
+//
+// It lives apart from HashMap.h so that single threaded users of HashMap
+// do not need <thread> and pthread.
+class ParallelHashMapRehashPolicy : public DefaultHashMapRehashPolicy
+{
+public:
+    enum { MIN_NODES_PER_THREAD = 1 << 16 };
+
+    ParallelHashMapRehashPolicy(unsigned int load_factor = 2,
+                                unsigned int thread_num = 1)
+    : DefaultHashMapRehashPolicy(load_factor)
+    , m_thread_num(thread_num > 0 ? thread_num : 1)
+    {}
+
+    unsigned int GetThreadNum(::std::size_t node_count) const
+    {
+        const ::std::size_t max_thread_num = node_count / MIN_NODES_PER_THREAD;
+        if (max_thread_num < 2)
+        {
+            return 1;
+        }
+        return max_thread_num < m_thread_num ?
+                static_cast<unsigned int>(max_thread_num) : m_thread_num;
+    }
+
+    template<typename Task>
+    void RunInParallel(const unsigned int thread_num, Task& task) const
+    {
+        ::snippet::algo::RunInParallel(thread_num, task);
+    }
+
+private:
+    unsigned int m_thread_num;
+};
+
+namespace detail {
+
+// One round of ParallelMerge: maps[i + step] is merged into maps[i]
+// for every i multiple of 2 * step, the pairs shared out to the threads.
+template<typename HashMapType, typename Combiner>
+struct ParallelMergeTask
+{
+    ParallelMergeTask(HashMapType** m, const ::std::size_t n, const Combiner& c,
+                      const unsigned int t)
+    : maps(m), map_num(n), combiner(c), thread_num(t), step(1)
+    {}
+
+    void operator()(const unsigned int thread_index)
+    {
+        for (::std::size_t i = 2 * step * thread_index; i + step < map_num;
+             i += 2 * step * thread_num)
+        {
+            maps[i]->Merge(*maps[i + step], combiner);
+        }
+    }
+
+    HashMapType** maps;
+    const ::std::size_t map_num;
+    const Combiner combiner;
+    const unsigned int thread_num;
+    ::std::size_t step;
+};
+
+}  // namespace detail
+
+// Merge all the maps into maps[0] with Merge(other, combiner), leaving
+// the others empty. It takes log2(map_num) rounds of pairwise merges,
+// each round running on up to thread_num threads.
+template<typename HashMapType, typename Combiner>
+void ParallelMerge(HashMapType** maps, const ::std::size_t map_num,
+                   const Combiner& combiner, const unsigned int thread_num)
+{
+    for (::std::size_t step = 1; step < map_num; step *= 2)
+    {
+        const ::std::size_t pair_num = (map_num - step + 2 * step - 1) / (2 * step);
+        const unsigned int used_thread_num = static_cast<unsigned int>(
+                pair_num < thread_num ? pair_num : (thread_num > 0 ? thread_num : 1));
+        detail::ParallelMergeTask<HashMapType, Combiner>
+                task(maps, map_num, combiner, used_thread_num);
+        task.step = step;
+        RunInParallel(used_thread_num, task);
+    }
+}
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_PARALLELHASHMAP_H_
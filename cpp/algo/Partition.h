@@ -0,0 +1,35 @@
+#ifndef ALGO_PARTITION_H_
+#define ALGO_PARTITION_H_
+
+#include <cstddef>
+
+namespace snippet {
+namespace algo {
+
+// The i-th of part_num nearly equal parts of [0, total).
+inline void GetPartition(const ::std::size_t total, const unsigned int part_num,
+                         const unsigned int i,
+                         ::std::size_t* first, ::std::size_t* last)
+{
+    *first = total / part_num * i + (i < total % part_num ? i : total % part_num);
+    *last = *first + total / part_num + (i < total % part_num ? 1 : 0);
+}
+
+// The part of GetPartition(total, part_num, ...) that contains index.
+inline unsigned int GetPartitionIndex(const ::std::size_t total, const unsigned int part_num,
+                                      const ::std::size_t index)
+{
+    const ::std::size_t part_size = total / part_num;
+    const ::std::size_t big_part_num = total % part_num;
+    const ::std::size_t big_parts_end = big_part_num * (part_size + 1);
+    if (index < big_parts_end)
+    {
+        return static_cast<unsigned int>(index / (part_size + 1));
+    }
+    return static_cast<unsigned int>(big_part_num + (index - big_parts_end) / part_size);
+}
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_PARTITION_H_
@@ -0,0 +1,200 @@
+#ifndef ALGO_PARTITIONEDHASHMAP_H_
+#define ALGO_PARTITIONEDHASHMAP_H_
+
+#include "algo/HashMap.h"
+#include "algo/Parallel.h"
+#include "algo/ParamTrait.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace snippet {
+namespace algo {
+
+// HashMap sharded over 2^partition_bits partitions by the top bits of the
+// key hash (see GetRadixPartition), for building from big inputs on many
+// threads with Build().
+//
+// Once built it is a read view: Find() may be called by any number of
+// threads, and every partition is a plain HashMap.
+template<typename Key, typename Value,
+         typename KeyEqual = DefaultKeyEqual<Key>,
+         typename HashPolicy = DefaultHashMapHashPolicy<Key>,
+         typename RehashPolicy = DefaultHashMapRehashPolicy,
+         typename Allocator = ::std::allocator<Key> >
+class PartitionedHashMap
+{
+public:
+    typedef HashMap<Key, Value, KeyEqual, HashPolicy, RehashPolicy, Allocator> MapType;
+    typedef Key KeyType;
+    typedef Value ValueType;
+
+    enum { DEFAULT_PARTITION_BITS = 8, MAX_PARTITION_BITS = 16 };
+
+    explicit PartitionedHashMap(unsigned int partition_bits = DEFAULT_PARTITION_BITS,
+                                const KeyEqual& key_equal = KeyEqual(),
+                                const HashPolicy& hash_policy = HashPolicy(),
+                                const RehashPolicy& rehash_policy = RehashPolicy())
+    : m_hash_policy(hash_policy)
+    , m_partition_bits(partition_bits < MAX_PARTITION_BITS ?
+                       partition_bits : static_cast<unsigned int>(MAX_PARTITION_BITS))
+    , m_partitions(static_cast< ::std::size_t>(1) << m_partition_bits,
+                   MapType(static_cast< ::std::size_t>(0), key_equal, hash_policy,
+                           rehash_policy))
+    {}
+
+    // Insert the tuples (keys[i], values[i]) for i in [0, n) on thread_num
+    // threads. Every thread scatters its share of the input into buffers
+    // of its own, one per partition, then every thread builds a range of
+    // partitions from the buffers of all the threads, with a single
+    // rehash each. The buffers are a copy of the input while building.
+    //
+    // Like Insert(), a key already present keeps its value, and of the
+    // keys repeated in the input the first one is kept.
+    void Build(const Key* keys, const Value* values, const ::std::size_t n,
+               const unsigned int thread_num)
+    {
+        BuildTask task(*this, keys, values, n, thread_num > 0 ? thread_num : 1);
+        RunInParallel(task.thread_num, task);
+        task.is_scattering = false;
+        RunInParallel(task.thread_num, task);
+    }
+
+    bool Insert(typename ParamTrait<const Key>::DeclType key,
+                typename ParamTrait<const Value>::DeclType value)
+    {
+        return GetPartitionOf(key).Insert(key, value);
+    }
+
+    bool Find(typename ParamTrait<const Key>::DeclType key, Value& value) const
+    {
+        return m_partitions[GetPartitionIndex(key)].Find(key, value);
+    }
+
+    bool Delete(typename ParamTrait<const Key>::DeclType key)
+    {
+        return GetPartitionOf(key).Delete(key);
+    }
+
+    void Clear()
+    {
+        for (::std::size_t i = 0; i < m_partitions.size(); ++i)
+        {
+            m_partitions[i].Clear();
+        }
+    }
+
+    ::std::size_t GetPartitionNum() const { return m_partitions.size(); }
+    const MapType& GetPartition(const ::std::size_t i) const { return m_partitions[i]; }
+
+    ::std::size_t GetPartitionIndex(typename ParamTrait<const Key>::DeclType key) const
+    {
+        return GetRadixPartition(m_hash_policy.DoHash(key), m_partition_bits);
+    }
+
+    // STL compatible methods
+    ::std::size_t size() const
+    {
+        ::std::size_t node_count = 0;
+        for (::std::size_t i = 0; i < m_partitions.size(); ++i)
+        {
+            node_count += m_partitions[i].size();
+        }
+        return node_count;
+    }
+
+    bool empty() const { return size() == 0; }
+    void clear() { Clear(); }
+
+private:
+    typedef ::std::vector< ::std::pair<Key, Value> > Buffer;
+
+    struct BuildTask
+    {
+        BuildTask(PartitionedHashMap& m, const Key* k, const Value* v,
+                  const ::std::size_t num, const unsigned int t)
+        : hash_map(m), keys(k), values(v), n(num), thread_num(t)
+        , is_scattering(true)
+        , buffers(t, ::std::vector<Buffer>(m.m_partitions.size()))
+        {}
+
+        void operator()(const unsigned int thread_index)
+        {
+            if (is_scattering)
+            {
+                Scatter(thread_index);
+            }
+            else
+            {
+                BuildPartitions(thread_index);
+            }
+        }
+
+        void Scatter(const unsigned int thread_index)
+        {
+            ::std::vector<Buffer>& thread_buffers = buffers[thread_index];
+            ::std::size_t first = 0;
+            ::std::size_t last = 0;
+            ::snippet::algo::GetPartition(n, thread_num, thread_index, &first, &last);
+            for (::std::size_t i = first; i < last; ++i)
+            {
+                thread_buffers[hash_map.GetPartitionIndex(keys[i])].push_back(
+                        ::std::make_pair(keys[i], values[i]));
+            }
+        }
+
+        // In the order of the threads, which keeps the order of the input.
+        void BuildPartitions(const unsigned int thread_index)
+        {
+            ::std::size_t first = 0;
+            ::std::size_t last = 0;
+            ::snippet::algo::GetPartition(hash_map.m_partitions.size(), thread_num,
+                                          thread_index, &first, &last);
+            for (::std::size_t p = first; p < last; ++p)
+            {
+                MapType& partition = hash_map.m_partitions[p];
+                ::std::size_t node_count = partition.size();
+                for (unsigned int t = 0; t < thread_num; ++t)
+                {
+                    node_count += buffers[t][p].size();
+                }
+                partition.Rehash(node_count);
+
+                for (unsigned int t = 0; t < thread_num; ++t)
+                {
+                    Buffer& buffer = buffers[t][p];
+                    for (typename Buffer::const_iterator it = buffer.begin();
+                         it != buffer.end(); ++it)
+                    {
+                        partition.Insert(it->first, it->second);
+                    }
+                    Buffer().swap(buffer);
+                }
+            }
+        }
+
+        PartitionedHashMap& hash_map;
+        const Key* keys;
+        const Value* values;
+        const ::std::size_t n;
+        const unsigned int thread_num;
+        bool is_scattering;
+        ::std::vector< ::std::vector<Buffer> > buffers;  // [thread][partition]
+    };
+
+    MapType& GetPartitionOf(typename ParamTrait<const Key>::DeclType key)
+    {
+        return m_partitions[GetPartitionIndex(key)];
+    }
+
+    HashPolicy m_hash_policy;
+    const unsigned int m_partition_bits;
+    ::std::vector<MapType> m_partitions;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_PARTITIONEDHASHMAP_H_
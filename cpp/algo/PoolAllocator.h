@@ -0,0 +1,354 @@
+#ifndef ALGO_POOLALLOCATOR_H_
+#define ALGO_POOLALLOCATOR_H_
+
+#include "algo/TypeTrait.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// Round size up to a multiple of alignment, a power of 2.
+inline ::std::uintptr_t AlignUp(const ::std::uintptr_t size, const ::std::size_t alignment)
+{
+    return (size + alignment - 1) & ~static_cast< ::std::uintptr_t>(alignment - 1);
+}
+
+// The slots of one size and alignment, carved from big chunks. Freed
+// slots go to a free list for reuse; the chunks are only returned by
+// Release() or the destructor.
+class SlotPool
+{
+public:
+    SlotPool(const ::std::size_t slot_size, const ::std::size_t slot_alignment,
+             const ::std::size_t chunk_size, SlotPool* next_pool)
+    : next(next_pool)
+    , m_slot_size(slot_size), m_slot_alignment(slot_alignment), m_chunk_size(chunk_size)
+    , m_chunks(NULL), m_free_list(NULL), m_next_slot(NULL), m_end_slot(NULL)
+    {}
+
+    ~SlotPool()
+    {
+        Release();
+    }
+
+    void* Allocate()
+    {
+        if (m_free_list != NULL)
+        {
+            FreeSlot* slot = m_free_list;
+            m_free_list = slot->next;
+            return slot;
+        }
+
+        if (m_next_slot == m_end_slot)
+        {
+            m_next_slot = NewChunk(m_chunk_size);
+            m_end_slot = m_next_slot + m_chunk_size * m_slot_size;
+        }
+        void* slot = m_next_slot;
+        m_next_slot += m_slot_size;
+        return slot;
+    }
+
+    void Deallocate(void* p)
+    {
+        FreeSlot* slot = static_cast<FreeSlot*>(p);
+        slot->next = m_free_list;
+        m_free_list = slot;
+    }
+
+    // n contiguous slots in a chunk of their own.
+    void* AllocateBlock(const ::std::size_t n)
+    {
+        return NewChunk(n);
+    }
+
+    void Release()
+    {
+        while (m_chunks != NULL)
+        {
+            ChunkHeader* next_chunk = m_chunks->next;
+            ::operator delete(m_chunks);
+            m_chunks = next_chunk;
+        }
+        m_free_list = NULL;
+        m_next_slot = NULL;
+        m_end_slot = NULL;
+    }
+
+    bool IsSlotOf(const ::std::size_t slot_size, const ::std::size_t slot_alignment) const
+    {
+        return m_slot_size == slot_size && m_slot_alignment == slot_alignment;
+    }
+
+    SlotPool* const next;  // the other pools of the same PoolResource
+
+private:
+    struct FreeSlot
+    {
+        FreeSlot* next;
+    };
+
+    struct ChunkHeader
+    {
+        ChunkHeader* next;
+    };
+
+    // The slots start at the first m_slot_alignment boundary after the
+    // header. The chunk is aligned by hand rather than by the aligned
+    // operator new, which needs C++17.
+    char* NewChunk(const ::std::size_t slot_num)
+    {
+        ChunkHeader* chunk = static_cast<ChunkHeader*>(
+                ::operator new(sizeof(ChunkHeader) + m_slot_alignment - 1 +
+                               slot_num * m_slot_size));
+        chunk->next = m_chunks;
+        m_chunks = chunk;
+        return reinterpret_cast<char*>(
+                AlignUp(reinterpret_cast< ::std::uintptr_t>(chunk + 1), m_slot_alignment));
+    }
+
+    SlotPool(const SlotPool&);
+    SlotPool& operator=(const SlotPool&);
+
+    const ::std::size_t m_slot_size;
+    const ::std::size_t m_slot_alignment;
+    const ::std::size_t m_chunk_size;
+    ChunkHeader* m_chunks;
+    FreeSlot* m_free_list;
+    char* m_next_slot;
+    char* m_end_slot;
+};
+
+}  // namespace detail
+
+// The memory behind PoolAllocator: one SlotPool per slot size, as the
+// rebound copies of an allocator share the resource. It is not copyable,
+// and lives as long as the last allocator pointing to it.
+class PoolResource
+{
+public:
+    typedef detail::SlotPool Pool;
+
+    // chunk_size is the number of slots per chunk.
+    explicit PoolResource(const ::std::size_t chunk_size)
+    : m_chunk_size(chunk_size > 0 ? chunk_size : 1), m_pools(NULL)
+    {}
+
+    ~PoolResource()
+    {
+        while (m_pools != NULL)
+        {
+            Pool* next = m_pools->next;
+            delete m_pools;
+            m_pools = next;
+        }
+    }
+
+    // The pool of the slots of slot_size bytes, made on the first call.
+    Pool* GetPool(const ::std::size_t slot_size, const ::std::size_t slot_alignment)
+    {
+        for (Pool* pool = m_pools; pool != NULL; pool = pool->next)
+        {
+            if (pool->IsSlotOf(slot_size, slot_alignment))
+            {
+                return pool;
+            }
+        }
+
+        m_pools = new Pool(slot_size, slot_alignment, m_chunk_size, m_pools);
+        return m_pools;
+    }
+
+    // Free the chunks of all the pools, the objects in them must have
+    // been destroyed.
+    void Release()
+    {
+        for (Pool* pool = m_pools; pool != NULL; pool = pool->next)
+        {
+            pool->Release();
+        }
+    }
+
+    ::std::size_t GetChunkSize() const { return m_chunk_size; }
+
+private:
+    PoolResource(const PoolResource&);
+    PoolResource& operator=(const PoolResource&);
+
+    const ::std::size_t m_chunk_size;
+    Pool* m_pools;
+};
+
+// Allocator handing out single objects from big chunks, meant as the
+// node allocator of HashMap and BTree. Freed objects go to a free list
+// for reuse; the chunks are only returned by Release() or along with the
+// PoolResource, which lets HashMap::Clear() drop all the nodes at once.
+//
+// The copies of an allocator, rebound ones included, share its
+// PoolResource and compare equal, so any of them may free what another
+// has allocated. A container copy gets a pool of its own from
+// select_on_container_copy_construction().
+// Arrays (n > 1), like the HashMap buckets, go to operator new.
+//
+// Alignment, if not 0, is a power of 2 the objects are aligned to, e.g.
+// the cache line size for the nodes of BTree. The objects then take a
+// multiple of Alignment bytes each.
+template<typename T, ::std::size_t Alignment = 0>
+class PoolAllocator
+{
+    // for alignment
+    union NaturalAlign
+    {
+        long long ll;
+        double d;
+        void* p;
+    };
+
+    enum { NATURAL_ALIGNMENT = alignof(T) > alignof(NaturalAlign) ?
+                               alignof(T) : alignof(NaturalAlign),
+           SLOT_ALIGNMENT = Alignment > NATURAL_ALIGNMENT ?
+                            Alignment : NATURAL_ALIGNMENT,
+           SLOT_SIZE = (sizeof(T) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT,
+           // operator new before C++17 only aligns to max_align_t
+           IS_ALIGNED_ARRAY = SLOT_ALIGNMENT > alignof(::std::max_align_t) };
+
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef ::std::size_t size_type;
+    typedef ::std::ptrdiff_t difference_type;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef PoolAllocator<Other, Alignment> other;
+    };
+
+    // chunk_size is the number of objects per chunk.
+    explicit PoolAllocator(::std::size_t chunk_size = 1024)
+    : m_resource(::std::make_shared<PoolResource>(chunk_size))
+    , m_pool(m_resource->GetPool(SLOT_SIZE, SLOT_ALIGNMENT))
+    {}
+
+    template<typename Other>
+    PoolAllocator(const PoolAllocator<Other, Alignment>& other)
+    : m_resource(other.GetResource())
+    , m_pool(m_resource->GetPool(SLOT_SIZE, SLOT_ALIGNMENT))
+    {}
+
+    // A new pool of the same chunk size.
+    PoolAllocator select_on_container_copy_construction() const
+    {
+        return PoolAllocator(GetChunkSize());
+    }
+
+    T* allocate(::std::size_t n, const void* = 0)
+    {
+        if (n != 1)
+        {
+            return static_cast<T*>(AllocateArray(n * sizeof(T), BoolType<IS_ALIGNED_ARRAY>()));
+        }
+        return static_cast<T*>(m_pool->Allocate());
+    }
+
+    void deallocate(T* p, ::std::size_t n)
+    {
+        if (n != 1)
+        {
+            DeallocateArray(p, BoolType<IS_ALIGNED_ARRAY>());
+            return;
+        }
+        m_pool->Deallocate(p);
+    }
+
+    // n contiguous objects in a chunk of their own, to be filled at once,
+    // e.g. when copying a HashMap. Each of them may later be deallocated
+    // one by one.
+    T* AllocateBlock(::std::size_t n)
+    {
+        return n > 0 ? static_cast<T*>(m_pool->AllocateBlock(n)) : NULL;
+    }
+
+    // Whether other allocators share the pool, and so may have objects
+    // in it, which rules out Release().
+    bool IsPoolShared() const
+    {
+        return m_resource.use_count() > 1;
+    }
+
+    // Free all the chunks, the objects in them must have been destroyed.
+    void Release()
+    {
+        m_resource->Release();
+    }
+
+    ::std::size_t GetChunkSize() const { return m_resource->GetChunkSize(); }
+
+    const ::std::shared_ptr<PoolResource>& GetResource() const { return m_resource; }
+
+private:
+    static void* AllocateArray(const ::std::size_t size, BoolType<false>)
+    {
+        return ::operator new(size);
+    }
+
+    // Aligned by hand, with the address from operator new kept right
+    // before the array.
+    static void* AllocateArray(const ::std::size_t size, BoolType<true>)
+    {
+        void* const raw = ::operator new(size + sizeof(void*) + SLOT_ALIGNMENT - 1);
+        void** const array = reinterpret_cast<void**>(detail::AlignUp(
+                reinterpret_cast< ::std::uintptr_t>(raw) + sizeof(void*), SLOT_ALIGNMENT));
+        array[-1] = raw;
+        return array;
+    }
+
+    static void DeallocateArray(void* p, BoolType<false>)
+    {
+        ::operator delete(p);
+    }
+
+    static void DeallocateArray(void* p, BoolType<true>)
+    {
+        ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
+    ::std::shared_ptr<PoolResource> m_resource;
+    PoolResource::Pool* m_pool;
+};
+
+// The copies sharing a PoolResource can free each other's memory.
+template<typename T, typename U, ::std::size_t Alignment>
+inline bool operator==(const PoolAllocator<T, Alignment>& lhs,
+                       const PoolAllocator<U, Alignment>& rhs)
+{
+    return lhs.GetResource() == rhs.GetResource();
+}
+
+template<typename T, typename U, ::std::size_t Alignment>
+inline bool operator!=(const PoolAllocator<T, Alignment>& lhs,
+                       const PoolAllocator<U, Alignment>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, ::std::size_t Alignment>
+struct IsBulkReleaseAllocator<PoolAllocator<T, Alignment> >
+{
+    enum { Result = true };
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_POOLALLOCATOR_H_
@@ -0,0 +1,310 @@
+#ifndef ALGO_STATICHASHMAP_H_
+#define ALGO_STATICHASHMAP_H_
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+
+namespace snippet {
+namespace algo {
+
+// Same as Hash(const char*, size_t) in HashMap.h, but usable at compile time.
+struct StaticHashMapHashPolicy
+{
+    static constexpr ::std::size_t DoHash(const char* str, const ::std::size_t str_size)
+    {
+        ::std::size_t result = str_size > 0 ?
+                static_cast< ::std::size_t>(static_cast<unsigned char>(str[0])) << 7 : 0;
+        for (::std::size_t i = 0; i < str_size; ++i)
+        {
+            result = (1000003 * result) ^ static_cast<unsigned char>(str[i]);
+        }
+        result ^= str_size;
+        return result;
+    }
+};
+
+template<typename Value>
+struct StaticHashMapItem
+{
+    const char* key;
+    Value value;
+};
+
+namespace detail {
+
+constexpr ::std::size_t StaticStrlen(const char* str)
+{
+    ::std::size_t size = 0;
+    while (str[size] != '\0')
+    {
+        ++size;
+    }
+    return size;
+}
+
+constexpr bool StaticStrEqual(const char* lhs, const char* rhs, const ::std::size_t size)
+{
+    for (::std::size_t i = 0; i < size; ++i)
+    {
+        if (lhs[i] != rhs[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr ::std::size_t StaticHashMapTableSize(const ::std::size_t n)
+{
+    ::std::size_t size = 1;
+    while (size < n)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+// The finalizer of MurmurHash3 over the hash code and the seed.
+constexpr ::std::size_t StaticHashMapMix(const ::std::size_t hash_code, const uint32_t seed)
+{
+    uint64_t h = static_cast<uint64_t>(hash_code) + seed * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast< ::std::size_t>(h);
+}
+
+}  // namespace detail
+
+// Read only map from a fixed set of string keys, perfect hashed by hash
+// and displace: the keys are grouped into buckets by their hash code, and
+// every bucket gets the seed which moves all its keys to free slots. A
+// bucket of a single key records its slot directly. Find() is then one
+// hash, one seed load and one key compare.
+//
+// Everything is constexpr (C++14), so a constexpr map is built by the
+// compiler and costs nothing at startup:
+//
+//   constexpr StaticHashMapItem<int> items[] = { {"GET", 1}, {"PUT", 2} };
+//   constexpr StaticHashMap<int, 2> methods(items);
+//   static_assert(*methods.Find("PUT") == 2, "");
+//
+// Duplicated keys, or keys of the same hash code, fail to compile.
+template<typename Value, ::std::size_t N,
+         typename HashPolicy = StaticHashMapHashPolicy>
+class StaticHashMap
+{
+public:
+    typedef Value ValueType;
+    typedef StaticHashMapItem<Value> Item;
+    typedef HashPolicy hash_policy;
+
+    enum { TABLE_SIZE = detail::StaticHashMapTableSize(N) };
+
+    static_assert(N > 0, "StaticHashMap needs at least one key");
+
+    constexpr explicit StaticHashMap(const Item (&items)[N])
+    : m_slots(), m_seeds()
+    {
+        Build(items);
+    }
+
+    // NULL if key is not present.
+    constexpr const Value* Find(const char* key, const ::std::size_t key_size) const
+    {
+        const Slot& slot = GetSlot(key, key_size);
+        return slot.key != NULL && detail::StaticStrEqual(slot.key, key, key_size) ?
+                &slot.value : NULL;
+    }
+
+    constexpr const Value* Find(const char* key) const
+    {
+        return Find(key, detail::StaticStrlen(key));
+    }
+
+    // Not constexpr, the key is compared by memcmp.
+    bool Find(const ::std::string& key, Value& value) const
+    {
+        const Slot& slot = GetSlot(key.data(), key.size());
+        if (slot.key != NULL && ::memcmp(slot.key, key.data(), key.size()) == 0)
+        {
+            value = slot.value;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    constexpr ::std::size_t size() const { return N; }
+    constexpr bool empty() const { return false; }
+    constexpr ::std::size_t GetTableSize() const { return TABLE_SIZE; }
+
+private:
+    enum { MAX_SEED = 1 << 20 };
+
+    struct Slot
+    {
+        constexpr Slot()
+        : key(NULL), key_size(0), hash_code(0), value()
+        {}
+
+        const char* key;
+        ::std::size_t key_size;
+        ::std::size_t hash_code;
+        Value value;
+    };
+
+    // A negative seed is the slot -seed - 1 of a bucket with a single key,
+    // otherwise it is mixed into the hash code; empty buckets keep 0.
+    constexpr ::std::size_t GetSlotIndex(const ::std::size_t hash_code) const
+    {
+        const int32_t seed = m_seeds[hash_code & (TABLE_SIZE - 1)];
+        return seed >= 0 ?
+                detail::StaticHashMapMix(hash_code, seed) & (TABLE_SIZE - 1) :
+                static_cast< ::std::size_t>(-seed - 1);
+    }
+
+    // The only slot where key may be, with an empty key if it is not.
+    constexpr const Slot& GetSlot(const char* key, const ::std::size_t key_size) const
+    {
+        const ::std::size_t hash_code = HashPolicy::DoHash(key, key_size);
+        const Slot& slot = m_slots[GetSlotIndex(hash_code)];
+        return slot.hash_code == hash_code && slot.key_size == key_size ?
+                slot : m_slots[TABLE_SIZE];
+    }
+
+    constexpr void Build(const Item (&items)[N])
+    {
+        ::std::size_t hash_codes[N] = {};
+        ::std::size_t next[N] = {};
+        ::std::size_t heads[TABLE_SIZE] = {};
+        ::std::size_t bucket_sizes[TABLE_SIZE] = {};
+        ::std::size_t max_bucket_size = 0;
+
+        // link the keys of every bucket, index + 1 so that 0 ends a list
+        for (::std::size_t i = 0; i < N; ++i)
+        {
+            hash_codes[i] = HashPolicy::DoHash(items[i].key, detail::StaticStrlen(items[i].key));
+            const ::std::size_t bucket = hash_codes[i] & (TABLE_SIZE - 1);
+            next[i] = heads[bucket];
+            heads[bucket] = i + 1;
+            if (++bucket_sizes[bucket] > max_bucket_size)
+            {
+                max_bucket_size = bucket_sizes[bucket];
+            }
+        }
+
+        // the biggest buckets first, while most slots are free
+        for (::std::size_t size = max_bucket_size; size > 1; --size)
+        {
+            for (::std::size_t bucket = 0; bucket < TABLE_SIZE; ++bucket)
+            {
+                if (bucket_sizes[bucket] == size)
+                {
+                    PlaceBucket(items, hash_codes, next, heads[bucket], bucket);
+                }
+            }
+        }
+
+        ::std::size_t free_slot = 0;
+        for (::std::size_t bucket = 0; bucket < TABLE_SIZE; ++bucket)
+        {
+            if (bucket_sizes[bucket] == 1)
+            {
+                while (m_slots[free_slot].key != NULL)
+                {
+                    ++free_slot;
+                }
+                const ::std::size_t i = heads[bucket] - 1;
+                SetSlot(free_slot, items[i], hash_codes[i]);
+                m_seeds[bucket] = -static_cast<int32_t>(free_slot) - 1;
+            }
+        }
+    }
+
+    constexpr void PlaceBucket(const Item (&items)[N], const ::std::size_t (&hash_codes)[N],
+                               const ::std::size_t (&next)[N], const ::std::size_t head,
+                               const ::std::size_t bucket)
+    {
+        for (::std::size_t i = head; i != 0; i = next[i - 1])
+        {
+            for (::std::size_t j = next[i - 1]; j != 0; j = next[j - 1])
+            {
+                if (hash_codes[i - 1] == hash_codes[j - 1])
+                {
+                    throw ::std::invalid_argument("StaticHashMap keys are duplicated or collide");
+                }
+            }
+        }
+
+        for (int32_t seed = 1; seed < MAX_SEED; ++seed)
+        {
+            if (IsSeedFree(hash_codes, next, head, seed))
+            {
+                for (::std::size_t i = head; i != 0; i = next[i - 1])
+                {
+                    const ::std::size_t slot =
+                            detail::StaticHashMapMix(hash_codes[i - 1], seed) & (TABLE_SIZE - 1);
+                    SetSlot(slot, items[i - 1], hash_codes[i - 1]);
+                }
+                m_seeds[bucket] = seed;
+                return;
+            }
+        }
+        throw ::std::invalid_argument("StaticHashMap keys are duplicated or collide");
+    }
+
+    // Whether seed sends all the keys of the bucket to distinct free slots.
+    constexpr bool IsSeedFree(const ::std::size_t (&hash_codes)[N],
+                              const ::std::size_t (&next)[N],
+                              const ::std::size_t head, const int32_t seed) const
+    {
+        for (::std::size_t i = head; i != 0; i = next[i - 1])
+        {
+            const ::std::size_t slot =
+                    detail::StaticHashMapMix(hash_codes[i - 1], seed) & (TABLE_SIZE - 1);
+            if (m_slots[slot].key != NULL)
+            {
+                return false;
+            }
+            for (::std::size_t j = head; j != i; j = next[j - 1])
+            {
+                if ((detail::StaticHashMapMix(hash_codes[j - 1], seed) & (TABLE_SIZE - 1)) == slot)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    constexpr void SetSlot(const ::std::size_t slot, const Item& item,
+                           const ::std::size_t hash_code)
+    {
+        m_slots[slot].key = item.key;
+        m_slots[slot].key_size = detail::StaticStrlen(item.key);
+        m_slots[slot].hash_code = hash_code;
+        m_slots[slot].value = item.value;
+    }
+
+    Slot m_slots[TABLE_SIZE + 1];  // the last one is always empty
+    int32_t m_seeds[TABLE_SIZE];
+};
+
+template<typename Value, ::std::size_t N>
+constexpr StaticHashMap<Value, N> MakeStaticHashMap(const StaticHashMapItem<Value> (&items)[N])
+{
+    return StaticHashMap<Value, N>(items);
+}
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_STATICHASHMAP_H_
@@ -0,0 +1,310 @@
+#ifndef ALGO_STRINGINTERNER_H_
+#define ALGO_STRINGINTERNER_H_
+
+#include "algo/HashMap.h"
+
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace snippet {
+namespace algo {
+
+namespace detail {
+
+// A string not owned, with its hash computed once.
+struct StringRef
+{
+    StringRef(const char* d, ::std::size_t s)
+    : data(d), size(s), hash(Hash(d, s))
+    {}
+
+    StringRef(const char* d, ::std::size_t s, ::std::size_t h)
+    : data(d), size(s), hash(h)
+    {}
+
+    const char* data;
+    ::std::size_t size;
+    ::std::size_t hash;
+};
+
+struct StringRefEqual
+{
+    static bool Equal(const StringRef& lhs, const StringRef& rhs)
+    {
+        return lhs.hash == rhs.hash && lhs.size == rhs.size &&
+                ::memcmp(lhs.data, rhs.data, lhs.size) == 0;
+    }
+};
+
+struct StringRefHashPolicy
+{
+    static ::std::size_t DoHash(const StringRef& str)
+    {
+        return str.hash;
+    }
+};
+
+// Bump allocator of chars, only freed as a whole.
+class StringArena
+{
+public:
+    enum { CHUNK_SIZE = 64 * 1024 };
+
+    StringArena()
+    : m_current(NULL), m_end(NULL), m_allocated_bytes(0)
+    {}
+
+    ~StringArena()
+    {
+        for (::std::size_t i = 0; i < m_chunks.size(); ++i)
+        {
+            ::operator delete(m_chunks[i]);
+        }
+    }
+
+    // Copy str with a trailing '\0'.
+    const char* Copy(const char* str, const ::std::size_t size)
+    {
+        const ::std::size_t bytes = size + 1;
+        if (static_cast< ::std::size_t>(m_end - m_current) < bytes)
+        {
+            // big strings get a chunk of their own
+            const ::std::size_t chunk_size =
+                    bytes > CHUNK_SIZE / 4 ? bytes : static_cast< ::std::size_t>(CHUNK_SIZE);
+            char* chunk = static_cast<char*>(::operator new(chunk_size));
+            m_chunks.push_back(chunk);
+            m_allocated_bytes += chunk_size;
+            if (chunk_size != CHUNK_SIZE)
+            {
+                ::memcpy(chunk, str, size);
+                chunk[size] = '\0';
+                return chunk;
+            }
+            m_current = chunk;
+            m_end = chunk + chunk_size;
+        }
+
+        char* copy = m_current;
+        ::memcpy(copy, str, size);
+        copy[size] = '\0';
+        m_current += bytes;
+        return copy;
+    }
+
+    ::std::size_t GetAllocatedBytes() const { return m_allocated_bytes; }
+
+private:
+    StringArena(const StringArena&);
+    StringArena& operator=(const StringArena&);
+
+    ::std::vector<char*> m_chunks;
+    char* m_current;
+    char* m_end;
+    ::std::size_t m_allocated_bytes;
+};
+
+}  // namespace detail
+
+// Maps strings to compact 32 bit symbols and back. Every distinct string
+// is stored once, '\0' terminated, in an arena, so the const char* handles
+// stay valid as long as the interner. The symbols make good
+// HashMap<uint32_t, V> keys, as the integers are hashed by identity.
+//
+// Interning is thread safe: the strings are sharded by hash over
+// 2^shard_bits tables, each with its own mutex. GetString() takes no
+// lock; it may be called by any thread which got the symbol from Intern().
+// A symbol is the index in its shard shifted left by shard_bits, or'ed
+// with the shard, so the symbols have gaps when the shards fill unevenly.
+class StringInterner
+{
+public:
+    typedef uint32_t Symbol;
+
+    struct Stats
+    {
+        ::std::size_t intern_count;    // calls of Intern()
+        ::std::size_t string_count;    // distinct strings
+        ::std::size_t interned_bytes;  // size of the strings of all the calls
+        ::std::size_t stored_bytes;    // size of the distinct strings
+
+        // bytes of the duplicates, which would be copies without interning
+        ::std::size_t GetSavedBytes() const { return interned_bytes - stored_bytes; }
+    };
+
+    explicit StringInterner(unsigned int shard_bits = 4)
+    : m_shard_bits(shard_bits < MAX_SHARD_BITS ? shard_bits
+                                               : static_cast<unsigned int>(MAX_SHARD_BITS))
+    , m_shards(static_cast< ::std::size_t>(1) << m_shard_bits)
+    {}
+
+    Symbol Intern(const char* str, const ::std::size_t size)
+    {
+        const detail::StringRef key(str, size);
+        const unsigned int shard_index = GetShardIndex(key.hash);
+        Shard& shard = m_shards[shard_index];
+
+        ::std::lock_guard< ::std::mutex> lock(shard.mutex);
+        ++shard.intern_count;
+        shard.interned_bytes += size;
+
+        Symbol symbol = 0;
+        if (shard.table.Find(key, symbol))
+        {
+            return symbol;
+        }
+
+        const ::std::size_t index = shard.table.size();
+        if (index >= (static_cast< ::std::size_t>(1) << (32 - m_shard_bits)))
+        {
+            throw ::std::length_error("StringInterner is full");
+        }
+
+        const char* data = shard.arena.Copy(str, size);
+        Entry* entry = shard.GetEntry(index, true);
+        entry->data = data;
+        entry->size = size;
+        shard.stored_bytes += size;
+
+        symbol = static_cast<Symbol>((index << m_shard_bits) | shard_index);
+        (void) shard.table.Insert(detail::StringRef(data, size, key.hash), symbol);
+        return symbol;
+    }
+
+    Symbol Intern(const char* str)
+    {
+        return Intern(str, ::strlen(str));
+    }
+
+    Symbol Intern(const ::std::string& str)
+    {
+        return Intern(str.data(), str.size());
+    }
+
+    // Look up without interning.
+    bool Find(const char* str, const ::std::size_t size, Symbol* symbol) const
+    {
+        const detail::StringRef key(str, size);
+        const Shard& shard = m_shards[GetShardIndex(key.hash)];
+        ::std::lock_guard< ::std::mutex> lock(shard.mutex);
+        return shard.table.Find(key, *symbol);
+    }
+
+    // The '\0' terminated string of symbol.
+    const char* GetString(const Symbol symbol) const
+    {
+        return GetEntry(symbol)->data;
+    }
+
+    ::std::size_t GetLength(const Symbol symbol) const
+    {
+        return GetEntry(symbol)->size;
+    }
+
+    void GetStats(Stats* stats) const
+    {
+        ::std::memset(stats, 0, sizeof(*stats));
+        for (::std::size_t i = 0; i < m_shards.size(); ++i)
+        {
+            const Shard& shard = m_shards[i];
+            ::std::lock_guard< ::std::mutex> lock(shard.mutex);
+            stats->intern_count += shard.intern_count;
+            stats->string_count += shard.table.size();
+            stats->interned_bytes += shard.interned_bytes;
+            stats->stored_bytes += shard.stored_bytes;
+        }
+    }
+
+    // The number of distinct strings.
+    ::std::size_t size() const
+    {
+        Stats stats;
+        GetStats(&stats);
+        return stats.string_count;
+    }
+
+private:
+    enum { MAX_SHARD_BITS = 8 };
+
+    struct Entry
+    {
+        const char* data;
+        ::std::size_t size;
+    };
+
+    // The entries are in segments of SEGMENT_SIZE << i entries for the
+    // i-th segment, so that a segment never moves once allocated.
+    enum { SEGMENT_BITS = 8, SEGMENT_SIZE = 1 << SEGMENT_BITS, MAX_SEGMENT_NUM = 32 };
+
+    struct Shard
+    {
+        Shard()
+        : intern_count(0), interned_bytes(0), stored_bytes(0)
+        {
+            ::std::memset(segments, 0, sizeof(segments));
+        }
+
+        ~Shard()
+        {
+            for (int i = 0; i < MAX_SEGMENT_NUM; ++i)
+            {
+                delete [] segments[i];
+            }
+        }
+
+        Entry* GetEntry(const ::std::size_t index, const bool is_create)
+        {
+            const ::std::size_t n = (index >> SEGMENT_BITS) + 1;
+            unsigned int segment = 0;
+            while ((n >> (segment + 1)) != 0)
+            {
+                ++segment;
+            }
+
+            if (is_create && segments[segment] == NULL)
+            {
+                segments[segment] = new Entry[static_cast< ::std::size_t>(SEGMENT_SIZE) << segment];
+            }
+            const ::std::size_t first_index =
+                    ((static_cast< ::std::size_t>(1) << segment) - 1) * SEGMENT_SIZE;
+            return segments[segment] + (index - first_index);
+        }
+
+        mutable ::std::mutex mutex;
+        HashMap<detail::StringRef, Symbol, detail::StringRefEqual,
+                detail::StringRefHashPolicy> table;
+        detail::StringArena arena;
+        Entry* segments[MAX_SEGMENT_NUM];
+        ::std::size_t intern_count;
+        ::std::size_t interned_bytes;
+        ::std::size_t stored_bytes;
+    };
+
+    unsigned int GetShardIndex(const ::std::size_t hash) const
+    {
+        // the low bits pick the bucket in the table of the shard
+        return static_cast<unsigned int>((hash >> 16) & (m_shards.size() - 1));
+    }
+
+    const Entry* GetEntry(const Symbol symbol) const
+    {
+        Shard& shard = const_cast<Shard&>(m_shards[symbol & (m_shards.size() - 1)]);
+        return shard.GetEntry(symbol >> m_shard_bits, false);
+    }
+
+    StringInterner(const StringInterner&);
+    StringInterner& operator=(const StringInterner&);
+
+    const unsigned int m_shard_bits;
+    ::std::vector<Shard> m_shards;
+};
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_STRINGINTERNER_H_
@@ -0,0 +1,280 @@
+#ifndef ALGO_TIMERWHEEL_H_
+#define ALGO_TIMERWHEEL_H_
+
+#include "algo/IntrusiveList.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace snippet {
+namespace algo {
+
+// Hierarchical timing wheel, the same layout as the classic Linux timer:
+// level 0 has 256 slots of one tick each, and every upper level has 64
+// slots, each covering a whole turn of the level below it. Elements are
+// linked into the slots through an intrusive ListNode, so adding and
+// removing is O(1) and Advance only touches the elements that are due
+// (plus the cascading of upper levels, amortized O(1) per element).
+//
+// T must carry a ListNode and a uint64_t deadline in ticks. The wheel
+// does not own the elements.
+template<typename T, ListNode T::*NodeMember = &T::list_node,
+         uint64_t T::*DeadlineMember = &T::deadline>
+class TimerWheel
+{
+public:
+    typedef uint64_t TimeType;
+
+    explicit TimerWheel(TimeType now = 0)
+    : m_now(now), m_size(0)
+    {
+        memset(m_root_bitmap, 0, sizeof(m_root_bitmap));
+        memset(m_level_bitmaps, 0, sizeof(m_level_bitmaps));
+    }
+
+    // elem->*DeadlineMember must be set before adding. Elements whose
+    // deadline has already passed expire on the next tick.
+    void Add(T* elem)
+    {
+        Place(elem, m_now + 1);
+        ++m_size;
+    }
+
+    // elem must be in this wheel.
+    void Remove(T* elem)
+    {
+        Slot::Unlink(elem);
+        --m_size;
+    }
+
+    // Move elem to its new deadline.
+    void Reschedule(T* elem, TimeType deadline)
+    {
+        Slot::Unlink(elem);
+        elem->*DeadlineMember = deadline;
+        Place(elem, m_now + 1);
+    }
+
+    // Advance the wheel to now and call expire(elem) for every element
+    // whose deadline is not later than now. Each element is unlinked
+    // before the callback, so the callback may free it.
+    // Returns the number of expired elements.
+    template<typename Callback>
+    ::std::size_t Advance(TimeType now, Callback& expire)
+    {
+        ::std::size_t expired_num = 0;
+        while (m_now < now)
+        {
+            if (m_size == 0)
+            {
+                m_now = now;
+                break;
+            }
+
+            // Jump over the ticks that have nothing to expire or cascade,
+            // so an idle wheel does not cost O(ticks).
+            if (!HasRootSlotBeforeWrap())
+            {
+                unsigned int bits = ROOT_BITS;
+                if (IsRootEmpty())
+                {
+                    unsigned int level = 0;
+                    while (level + 1 < LEVEL_NUM && IsLevelEmpty(level))
+                    {
+                        ++level;
+                    }
+                    bits = ROOT_BITS + level * LEVEL_BITS;
+                }
+
+                const TimeType last_quiet_tick =
+                        m_now | ((static_cast<TimeType>(1) << bits) - 1);
+                if (last_quiet_tick >= now)
+                {
+                    m_now = now;
+                    break;
+                }
+                m_now = last_quiet_tick;
+            }
+
+            ++m_now;
+            const unsigned int index = static_cast<unsigned int>(m_now & ROOT_MASK);
+            if (index == 0)
+            {
+                Cascade();
+            }
+
+            Slot& slot = m_root[index];
+            while (!slot.empty())
+            {
+                T* elem = &slot.front();
+                slot.pop_front();
+                --m_size;
+                ++expired_num;
+                expire(elem);
+            }
+            ClearBit(m_root_bitmap, index);
+        }
+        return expired_num;
+    }
+
+    TimeType GetCurrentTime() const { return m_now; }
+    ::std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    typedef IntrusiveList<T, ListNode, NodeMember, false> Slot;
+
+    enum { ROOT_BITS = 8, LEVEL_BITS = 6, LEVEL_NUM = 4 };
+    enum { ROOT_SIZE = 1 << ROOT_BITS, LEVEL_SIZE = 1 << LEVEL_BITS };
+    enum { ROOT_MASK = ROOT_SIZE - 1, LEVEL_MASK = LEVEL_SIZE - 1 };
+
+    static const TimeType MAX_DELTA =
+            (static_cast<TimeType>(1) << (ROOT_BITS + LEVEL_NUM * LEVEL_BITS)) - 1;
+
+    // earliest is the first tick whose slot has not been processed yet.
+    void Place(T* elem, TimeType earliest)
+    {
+        TimeType deadline = elem->*DeadlineMember;
+        if (deadline < earliest)
+        {
+            deadline = earliest;
+        }
+
+        TimeType delta = deadline - m_now;
+        if (delta < ROOT_SIZE)
+        {
+            const unsigned int index = static_cast<unsigned int>(deadline & ROOT_MASK);
+            m_root[index].push_back(elem);
+            SetBit(m_root_bitmap, index);
+            return;
+        }
+
+        if (delta > MAX_DELTA)
+        {
+            // parked in the farthest slot, it cascades down until due
+            deadline = m_now + MAX_DELTA;
+            delta = MAX_DELTA;
+        }
+
+        unsigned int level = 0;
+        while (delta >= (static_cast<TimeType>(1) << (ROOT_BITS + (level + 1) * LEVEL_BITS)))
+        {
+            ++level;
+        }
+        const unsigned int shift = ROOT_BITS + level * LEVEL_BITS;
+        const unsigned int index = static_cast<unsigned int>((deadline >> shift) & LEVEL_MASK);
+        m_levels[level][index].push_back(elem);
+        SetBit(&m_level_bitmaps[level], index);
+    }
+
+    // Called when level 0 wraps around: refill it from the next level,
+    // which in turn is refilled from the level above when it wraps.
+    void Cascade()
+    {
+        for (unsigned int level = 0; level < LEVEL_NUM; ++level)
+        {
+            const unsigned int shift = ROOT_BITS + level * LEVEL_BITS;
+            const unsigned int index = static_cast<unsigned int>((m_now >> shift) & LEVEL_MASK);
+
+            Slot& slot = m_levels[level][index];
+            while (!slot.empty())
+            {
+                T* elem = &slot.front();
+                slot.pop_front();
+                Place(elem, m_now);
+            }
+            ClearBit(&m_level_bitmaps[level], index);
+
+            if (index != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    // The bitmaps mark the slots that may be non-empty. Remove does not
+    // know the slot of the element, so the bits are only cleared lazily
+    // by the following checks.
+
+    static void SetBit(uint64_t* bitmap, const unsigned int i)
+    {
+        bitmap[i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+    }
+
+    static void ClearBit(uint64_t* bitmap, const unsigned int i)
+    {
+        bitmap[i / 64] &= ~(static_cast<uint64_t>(1) << (i % 64));
+    }
+
+    // Whether any of the slots [first, last) in the word of bitmap is
+    // non-empty; the bits of the empty ones are cleared.
+    static bool HasSlot(uint64_t* word, Slot* slots, unsigned int first, const unsigned int last)
+    {
+        for (; first < last; ++first)
+        {
+            const uint64_t bit = static_cast<uint64_t>(1) << (first % 64);
+            if ((*word & bit) != 0)
+            {
+                if (!slots[first].empty())
+                {
+                    return true;
+                }
+                *word &= ~bit;
+            }
+        }
+        return false;
+    }
+
+    // Whether the root slots after the current tick hold anything.
+    bool HasRootSlotBeforeWrap()
+    {
+        const unsigned int first = static_cast<unsigned int>(m_now & ROOT_MASK) + 1;
+        for (unsigned int word = first / 64; word < ROOT_SIZE / 64; ++word)
+        {
+            const unsigned int begin = word * 64 > first ? word * 64 : first;
+            if (m_root_bitmap[word] != 0 &&
+                HasSlot(&m_root_bitmap[word], m_root,
+                        begin, (word + 1) * 64))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool IsRootEmpty()
+    {
+        for (unsigned int word = 0; word < ROOT_SIZE / 64; ++word)
+        {
+            if (m_root_bitmap[word] != 0 &&
+                HasSlot(&m_root_bitmap[word], m_root, word * 64, (word + 1) * 64))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsLevelEmpty(const unsigned int level)
+    {
+        return m_level_bitmaps[level] == 0 ||
+                !HasSlot(&m_level_bitmaps[level], m_levels[level], 0, LEVEL_SIZE);
+    }
+
+    TimeType m_now;
+    ::std::size_t m_size;
+    Slot m_root[ROOT_SIZE];
+    Slot m_levels[LEVEL_NUM][LEVEL_SIZE];
+    uint64_t m_root_bitmap[ROOT_SIZE / 64];
+    uint64_t m_level_bitmaps[LEVEL_NUM];  // LEVEL_SIZE is 64
+};
+
+template<typename T, ListNode T::*NodeMember, uint64_t T::*DeadlineMember>
+const typename TimerWheel<T, NodeMember, DeadlineMember>::TimeType
+TimerWheel<T, NodeMember, DeadlineMember>::MAX_DELTA;
+
+}  // namespace algo
+}  // namespace snippet
+
+#endif  // ALGO_TIMERWHEEL_H_
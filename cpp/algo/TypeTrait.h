@@ -0,0 +1,39 @@
+#ifndef ALGO_TYPETRAIT_H_
+#define ALGO_TYPETRAIT_H_
+
+#include <type_traits>
+
+namespace snippet {
+namespace algo {
+
+// Whether the destructor of T does nothing, so it need not be called.
+template<typename T>
+struct IsTriviallyDestructible
+{
+    enum { Result = ::std::is_trivially_destructible<T>::value };
+};
+
+// Whether Alloc has a Release() method freeing all the memory of its pool
+// at once, so the containers can skip deallocating one by one. Release()
+// is only called when IsPoolShared() says no other allocator may have
+// objects in the pool.
+template<typename Alloc>
+struct IsBulkReleaseAllocator
+{
+    enum { Result = false };
+};
+
+// Used to select an overload by a compile time bool.
+template<bool Value>
+struct BoolType
+{
+    enum { Result = Value };
+};
+
+
+}  // namespace algo
+}  // namespace snippet
+
+
+
+#endif /* ALGO_TYPETRAIT_H_ */
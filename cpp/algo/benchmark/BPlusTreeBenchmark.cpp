@@ -0,0 +1,187 @@
+#include "BPlusTree.h"
+#include "BTree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace snippet::algo;
+
+typedef BPlusTree<long long, long long> Int64BPlusTree;
+typedef BTree<long long, long long> Int64BTree;
+typedef std::map<long long, long long> Int64StdMap;
+
+enum { SCAN_KEY_NUM = 1 << 20, SCAN_NUM = 256 };
+
+// range_x random 64 bit timestamps, shuffled.
+static std::vector<long long> MakeKeys(int key_num)
+{
+    srand(0);
+    std::vector<long long> keys;
+    for (int i = 0; i < key_num; ++i)
+    {
+        keys.push_back((static_cast<long long>(rand()) << 20) + i);
+    }
+    return keys;
+}
+
+template<typename MapType>
+static void DoInsert(MapType& map, const std::vector<long long>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        map.Insert(keys[i], keys[i]);
+    }
+}
+
+template<>
+void DoInsert(Int64StdMap& std_map, const std::vector<long long>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        std_map.insert(std::make_pair(keys[i], keys[i]));
+    }
+}
+
+template<typename MapType>
+static void BM_Insert(benchmark::State& state)
+{
+    const std::vector<long long> keys = MakeKeys(state.range_x());
+    while (state.KeepRunning())
+    {
+        MapType map;
+        DoInsert(map, keys);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename MapType>
+static void BM_Find(benchmark::State& state)
+{
+    std::vector<long long> keys = MakeKeys(state.range_x());
+    MapType map;
+    DoInsert(map, keys);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    long long value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+struct SumCallback
+{
+    SumCallback() : sum(0) {}
+
+    void operator()(long long, long long value)
+    {
+        sum += value;
+    }
+
+    long long sum;
+};
+
+// SCAN_NUM ranges of range_x keys, in SCAN_KEY_NUM keys.
+struct ScanRanges
+{
+    ScanRanges(const int range_key_num)
+    : keys(MakeKeys(SCAN_KEY_NUM))
+    {
+        std::vector<long long> sorted_keys(keys);
+        std::sort(sorted_keys.begin(), sorted_keys.end());
+        for (int i = 0; i < SCAN_NUM; ++i)
+        {
+            const int first = rand() % (SCAN_KEY_NUM - range_key_num);
+            froms.push_back(sorted_keys[first]);
+            tos.push_back(sorted_keys[first + range_key_num]);
+        }
+    }
+
+    std::vector<long long> keys;
+    std::vector<long long> froms;
+    std::vector<long long> tos;
+};
+
+static void BM_BPlusTreeScan(benchmark::State& state)
+{
+    const ScanRanges ranges(state.range_x());
+    Int64BPlusTree btree;
+    DoInsert(btree, ranges.keys);
+
+    SumCallback callback;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < SCAN_NUM; ++i)
+        {
+            btree.Scan(ranges.froms[i], ranges.tos[i], callback);
+        }
+    }
+    benchmark::DoNotOptimize(callback.sum);
+    state.SetItemsProcessed(state.iterations() * SCAN_NUM * state.range_x());
+}
+
+static void BM_BPlusTreeIteratorScan(benchmark::State& state)
+{
+    const ScanRanges ranges(state.range_x());
+    Int64BPlusTree btree;
+    DoInsert(btree, ranges.keys);
+
+    long long sum = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < SCAN_NUM; ++i)
+        {
+            for (Int64BPlusTree::const_iterator it = btree.LowerBound(ranges.froms[i]);
+                 it != btree.end() && it.GetKey() < ranges.tos[i]; ++it)
+            {
+                sum += it.GetValue();
+            }
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * SCAN_NUM * state.range_x());
+}
+
+static void BM_StdMapScan(benchmark::State& state)
+{
+    const ScanRanges ranges(state.range_x());
+    Int64StdMap std_map;
+    DoInsert(std_map, ranges.keys);
+
+    long long sum = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < SCAN_NUM; ++i)
+        {
+            const Int64StdMap::const_iterator last = std_map.lower_bound(ranges.tos[i]);
+            for (Int64StdMap::const_iterator it = std_map.lower_bound(ranges.froms[i]);
+                 it != last; ++it)
+            {
+                sum += it->second;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * SCAN_NUM * state.range_x());
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, Int64BPlusTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, Int64BTree)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_TEMPLATE(BM_Find, Int64BPlusTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Find, Int64BTree)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_BPlusTreeScan)->Range(16, 1 << 16);
+BENCHMARK(BM_BPlusTreeIteratorScan)->Range(16, 1 << 16);
+BENCHMARK(BM_StdMapScan)->Range(16, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,553 @@
+#include "BTree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace snippet::algo;
+
+typedef BTree<long long, long long> Int64BTree;
+typedef BTree<long long, long long, std::less<long long>, 512,
+              PoolAllocator<long long, 64> > Int64PoolBTree;
+
+// Same order as std::less, but searched in the nodes by binary search.
+template<typename T>
+struct GenericLess
+{
+    bool operator()(const T& lhs, const T& rhs) const
+    {
+        return lhs < rhs;
+    }
+};
+
+typedef BTree<long long, long long, GenericLess<long long> > Int64BinarySearchBTree;
+typedef std::map<long long, long long> Int64StdMap;
+
+// range_x random 64 bit timestamps, shuffled.
+static std::vector<long long> MakeKeys(int key_num)
+{
+    srand(0);
+    std::vector<long long> keys;
+    for (int i = 0; i < key_num; ++i)
+    {
+        keys.push_back((static_cast<long long>(rand()) << 20) + i);
+    }
+    return keys;
+}
+
+static std::vector<std::string> MakeStringKeys(int key_num)
+{
+    const std::vector<long long> int_keys = MakeKeys(key_num);
+    std::vector<std::string> keys;
+    char key[32];
+    for (int i = 0; i < key_num; ++i)
+    {
+        snprintf(key, sizeof(key), "key-%lld", int_keys[i]);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+template<typename MapType>
+static void DoInsert(MapType& map, const std::vector<long long>& keys);
+
+template<typename BTreeType>
+static void DoInsertBTree(BTreeType& btree, const std::vector<long long>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        btree.Insert(keys[i], keys[i]);
+    }
+}
+
+template<>
+void DoInsert(Int64BinarySearchBTree& btree, const std::vector<long long>& keys)
+{
+    DoInsertBTree(btree, keys);
+}
+
+template<>
+void DoInsert(Int64BTree& btree, const std::vector<long long>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        btree.Insert(keys[i], keys[i]);
+    }
+}
+
+template<>
+void DoInsert(Int64PoolBTree& btree, const std::vector<long long>& keys)
+{
+    DoInsertBTree(btree, keys);
+}
+
+template<>
+void DoInsert(Int64StdMap& std_map, const std::vector<long long>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        std_map.insert(std::make_pair(keys[i], keys[i]));
+    }
+}
+
+template<typename MapType>
+static void BM_Insert(benchmark::State& state)
+{
+    const std::vector<long long> keys = MakeKeys(state.range_x());
+    while (state.KeepRunning())
+    {
+        MapType map;
+        DoInsert(map, keys);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename BTreeType>
+static void BM_BTreeFind(benchmark::State& state)
+{
+    std::vector<long long> keys = MakeKeys(state.range_x());
+    BTreeType btree;
+    DoInsert(btree, keys);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    long long value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            btree.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_StdMapFind(benchmark::State& state)
+{
+    std::vector<long long> keys = MakeKeys(state.range_x());
+    Int64StdMap std_map;
+    DoInsert(std_map, keys);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    long long value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            Int64StdMap::const_iterator it = std_map.find(keys[i]);
+            if (it != std_map.end())
+            {
+                value = it->second;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+// 64 bytes of payload per key, of which a node of pairs holds 5 only.
+struct LargeValue
+{
+    LargeValue() { std::fill(data, data + 8, 0); }
+    explicit LargeValue(long long v) { std::fill(data, data + 8, v); }
+
+    long long data[8];
+};
+
+typedef BTree<long long, LargeValue> LargeValuePairBTree;
+typedef BTree<long long, LargeValue, std::less<long long>, 512,
+              std::allocator<long long>, BTreeSplitLayout> LargeValueSplitBTree;
+
+template<typename BTreeType>
+static void BM_BTreeLargeValueFind(benchmark::State& state)
+{
+    std::vector<long long> keys = MakeKeys(state.range_x());
+    BTreeType btree;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        btree.Insert(keys[i], LargeValue(keys[i]));
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+
+    LargeValue value;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            btree.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    char label[32];
+    snprintf(label, sizeof(label), "%u keys per node", btree.GetMaxKeyNum());
+    state.SetLabel(label);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename Node, typename Key>
+static void SetNodeValues(Node&, Key*, BTreePairLayout) {}
+
+template<typename Node, typename Key>
+static void SetNodeValues(Node& node, Key* values, BTreeSplitLayout)
+{
+    node.SetValues(values);
+}
+
+// The search in one full node, the work of Find() per level of the tree.
+template<typename Key, typename Layout = BTreePairLayout>
+struct FullNode
+{
+    typedef typename BTree<Key, Key, std::less<Key>, 512,
+                           std::allocator<Key>, Layout>::BTreeNode Node;
+
+    FullNode() : node(Node::MAX_KEY_NUM), values(Node::MAX_KEY_NUM)
+    {
+        srand(0);
+        SetNodeValues(node, &values[0], Layout());
+        for (unsigned i = 0; i < Node::MAX_KEY_NUM; ++i)
+        {
+            node.SetItem(i, static_cast<Key>(i * 2), static_cast<Key>(i));
+            node.SetKeyNum(i + 1);
+        }
+        for (int i = 0; i < 1024; ++i)
+        {
+            probes.push_back(static_cast<Key>(rand() % (Node::MAX_KEY_NUM * 2 + 1)));
+        }
+    }
+
+    Node node;
+    std::vector<Key> values;
+    std::vector<Key> probes;
+};
+
+template<typename Key, typename Compare, typename Layout = BTreePairLayout>
+static void BM_NodeLowerBound(benchmark::State& state)
+{
+    const FullNode<Key, Layout> full_node;
+    const Compare compare = Compare();
+    unsigned sum = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < full_node.probes.size(); ++i)
+        {
+            sum += full_node.node.LowerBound(full_node.probes[i], compare);
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    char label[32];
+    snprintf(label, sizeof(label), "%u keys", full_node.node.GetKeyNum());
+    state.SetLabel(label);
+    state.SetItemsProcessed(state.iterations() * full_node.probes.size());
+}
+
+// The linear scan the nodes used to do.
+template<typename Key>
+static void BM_NodeLinearSearch(benchmark::State& state)
+{
+    const FullNode<Key> full_node;
+    unsigned sum = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < full_node.probes.size(); ++i)
+        {
+            unsigned j = 0;
+            while (j < full_node.node.GetKeyNum() &&
+                   full_node.node.GetKey(j) < full_node.probes[i])
+            {
+                ++j;
+            }
+            sum += j;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * full_node.probes.size());
+}
+
+struct SumVisitor
+{
+    SumVisitor() : sum(0) {}
+
+    void operator()(long long, long long value)
+    {
+        sum += value;
+    }
+
+    long long sum;
+};
+
+static void BM_BTreeScan(benchmark::State& state)
+{
+    Int64BTree btree;
+    DoInsert(btree, MakeKeys(state.range_x()));
+
+    SumVisitor visitor;
+    while (state.KeepRunning())
+    {
+        btree.ForEach(visitor);
+    }
+    benchmark::DoNotOptimize(visitor.sum);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_StdMapScan(benchmark::State& state)
+{
+    Int64StdMap std_map;
+    DoInsert(std_map, MakeKeys(state.range_x()));
+
+    long long sum = 0;
+    while (state.KeepRunning())
+    {
+        for (Int64StdMap::const_iterator it = std_map.begin(); it != std_map.end(); ++it)
+        {
+            sum += it->second;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+// range_x sorted keys, as pairs of key and value.
+static std::vector<std::pair<long long, long long> > MakeSortedItems(int key_num)
+{
+    std::vector<long long> keys = MakeKeys(key_num);
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::pair<long long, long long> > items;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        items.push_back(std::make_pair(keys[i], keys[i]));
+    }
+    return items;
+}
+
+static void BM_BTreeSortedInsert(benchmark::State& state)
+{
+    const std::vector<std::pair<long long, long long> > items =
+            MakeSortedItems(state.range_x());
+    while (state.KeepRunning())
+    {
+        Int64BTree btree;
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            btree.Insert(items[i].first, items[i].second);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_BTreeBulkLoad(benchmark::State& state)
+{
+    const std::vector<std::pair<long long, long long> > items =
+            MakeSortedItems(state.range_x());
+    while (state.KeepRunning())
+    {
+        Int64BTree btree;
+        btree.BulkLoad(items.begin(), items.end());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+// 4M keys on range_x threads.
+static void BM_BTreeParallelBulkLoad(benchmark::State& state)
+{
+    const std::vector<std::pair<long long, long long> > items = MakeSortedItems(1 << 22);
+    while (state.KeepRunning())
+    {
+        Int64BTree btree;
+        btree.BulkLoad(items.begin(), items.end(), 1.0, state.range_x());
+    }
+    state.SetItemsProcessed(state.iterations() * items.size());
+}
+
+// Find in a tree of range_x keys bulk loaded with range_y percent full
+// nodes, or inserted in order if range_y is 0.
+static void BM_BTreeFindAfterLoad(benchmark::State& state)
+{
+    const std::vector<std::pair<long long, long long> > items =
+            MakeSortedItems(state.range_x());
+    Int64BTree btree;
+    if (state.range_y() > 0)
+    {
+        btree.BulkLoad(items.begin(), items.end(), state.range_y() / 100.0);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            btree.Insert(items[i].first, items[i].second);
+        }
+    }
+    std::vector<long long> keys = MakeKeys(state.range_x());
+
+    long long value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            btree.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+// Delete and Insert of keys in a tree of range_x keys, which keeps
+// splitting and merging nodes.
+template<typename BTreeType>
+static void BM_BTreeChurn(benchmark::State& state)
+{
+    const std::vector<long long> keys = MakeKeys(state.range_x() * 2);
+    BTreeType btree;
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        btree.Insert(keys[i], keys[i]);
+    }
+
+    std::size_t i = 0;
+    while (state.KeepRunning())
+    {
+        const std::size_t j = (i + state.range_x()) % keys.size();
+        btree.Delete(keys[i]);
+        btree.Insert(keys[j], keys[j]);
+        i = (i + 1) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+static void BM_BTreeRank(benchmark::State& state)
+{
+    std::vector<long long> keys = MakeKeys(state.range_x());
+    Int64BTree btree;
+    DoInsert(btree, keys);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    std::size_t rank = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            rank += btree.Rank(keys[i]);
+        }
+    }
+    benchmark::DoNotOptimize(rank);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_BTreeSelect(benchmark::State& state)
+{
+    const std::vector<long long> keys = MakeKeys(state.range_x());
+    Int64BTree btree;
+    DoInsert(btree, keys);
+    std::vector<std::size_t> ranks;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        ranks.push_back(i);
+    }
+    std::random_shuffle(ranks.begin(), ranks.end());
+
+    long long key = 0;
+    long long value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < ranks.size(); ++i)
+        {
+            btree.Select(ranks[i], &key, &value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_BTreeStringFind(benchmark::State& state)
+{
+    std::vector<std::string> keys = MakeStringKeys(state.range_x());
+    BTree<std::string, int> btree;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        btree.Insert(keys[i], static_cast<int>(i));
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            btree.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_StdMapStringFind(benchmark::State& state)
+{
+    std::vector<std::string> keys = MakeStringKeys(state.range_x());
+    std::map<std::string, int> std_map;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        std_map[keys[i]] = static_cast<int>(i);
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            std::map<std::string, int>::const_iterator it = std_map.find(keys[i]);
+            if (it != std_map.end())
+            {
+                value = it->second;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, int, std::less<int>);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, int, GenericLess<int>);
+BENCHMARK_TEMPLATE(BM_NodeLinearSearch, int);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, long long, std::less<long long>);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, long long, GenericLess<long long>);
+BENCHMARK_TEMPLATE(BM_NodeLinearSearch, long long);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, int, std::less<int>, BTreeSplitLayout);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, int, GenericLess<int>, BTreeSplitLayout);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, long long, std::less<long long>, BTreeSplitLayout);
+BENCHMARK_TEMPLATE(BM_NodeLowerBound, long long, GenericLess<long long>, BTreeSplitLayout);
+
+BENCHMARK_TEMPLATE(BM_Insert, Int64BTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, Int64StdMap)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_TEMPLATE(BM_BTreeFind, Int64BTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BTreeFind, Int64BinarySearchBTree)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_StdMapFind)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_TEMPLATE(BM_BTreeLargeValueFind, LargeValuePairBTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BTreeLargeValueFind, LargeValueSplitBTree)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_BTreeScan)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_StdMapScan)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_BTreeSortedInsert)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_BTreeBulkLoad)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_BTreeParallelBulkLoad)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(BM_BTreeFindAfterLoad)->ArgPair(1 << 20, 0)->ArgPair(1 << 20, 50)
+        ->ArgPair(1 << 20, 70)->ArgPair(1 << 20, 100);
+
+BENCHMARK_TEMPLATE(BM_Insert, Int64PoolBTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BTreeChurn, Int64BTree)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BTreeChurn, Int64PoolBTree)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_BTreeRank)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_BTreeSelect)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_BTreeStringFind)->Range(1 << 10, 1 << 18);
+BENCHMARK(BM_StdMapStringFind)->Range(1 << 10, 1 << 18);
+
+BENCHMARK_MAIN();
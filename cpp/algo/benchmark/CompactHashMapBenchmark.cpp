@@ -0,0 +1,136 @@
+#include "HashMap.h"
+#include "CompactHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace snippet::algo;
+
+static std::size_t gs_allocated_bytes = 0;
+
+// std::allocator counting the bytes in use, to get the memory of HashMap.
+template<typename T>
+struct CountingAllocator : public std::allocator<T>
+{
+    template<typename Other>
+    struct rebind
+    {
+        typedef CountingAllocator<Other> other;
+    };
+
+    CountingAllocator() {}
+
+    template<typename Other>
+    CountingAllocator(const CountingAllocator<Other>&) {}
+
+    T* allocate(std::size_t n, const void* = 0)
+    {
+        gs_allocated_bytes += n * sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        gs_allocated_bytes -= n * sizeof(T);
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                DefaultHashMapRehashPolicy, CountingAllocator<int> > IntHashMap;
+typedef CompactHashMap<int, int> IntCompactHashMap;
+
+static std::size_t GetMemoryUsage(const IntHashMap&)
+{
+    return gs_allocated_bytes;
+}
+
+static std::size_t GetMemoryUsage(const IntCompactHashMap& hash_map)
+{
+    return hash_map.GetMemoryUsage();
+}
+
+// Allocator overhead of HashMap nodes is not included.
+template<typename C>
+static void SetBytesPerEntry(benchmark::State& state, const C& hash_map)
+{
+    char label[64];
+    snprintf(label, sizeof(label), "bytes/entry=%.1f",
+             static_cast<double>(GetMemoryUsage(hash_map)) / hash_map.size());
+    state.SetLabel(label);
+}
+
+template<typename C>
+static void BM_Insert(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        C hash_map;
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Insert(i, i);
+        }
+        state.PauseTiming();
+        SetBytesPerEntry(state, hash_map);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename C>
+static void BM_RandomFind(benchmark::State& state)
+{
+    C hash_map;
+    std::vector<int> keys(state.range_x());
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(i, i);
+        keys[i] = rand() % state.range_x();
+    }
+    SetBytesPerEntry(state, hash_map);
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename C>
+static void BM_Copy(benchmark::State& state)
+{
+    C hash_map;
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(i, i);
+    }
+    SetBytesPerEntry(state, hash_map);
+
+    while (state.KeepRunning())
+    {
+        C copy(hash_map);
+        benchmark::DoNotOptimize(copy.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, IntHashMap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Insert, IntCompactHashMap)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_TEMPLATE(BM_RandomFind, IntHashMap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_RandomFind, IntCompactHashMap)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_TEMPLATE(BM_Copy, IntHashMap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Copy, IntCompactHashMap)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_MAIN();
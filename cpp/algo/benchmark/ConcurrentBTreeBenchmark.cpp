@@ -0,0 +1,197 @@
+#include "BTree.h"
+#include "ConcurrentBTree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+
+static const int KEY_NUM = 1 << 20;
+static const int OP_NUM = 1 << 21;
+
+// Keys drawn from a Zipfian distribution with s = 1 over KEY_NUM keys,
+// scattered over the key space so that the hot keys are not neighbours.
+static const std::vector<int>& GetZipfianStream()
+{
+    static std::vector<int> stream;
+    if (stream.empty())
+    {
+        std::vector<double> cdf(KEY_NUM);
+        double sum = 0;
+        for (int i = 0; i < KEY_NUM; ++i)
+        {
+            sum += 1.0 / (i + 1);
+            cdf[i] = sum;
+        }
+
+        srand(0);
+        stream.resize(OP_NUM);
+        for (int i = 0; i < OP_NUM; ++i)
+        {
+            const double r = sum * rand() / RAND_MAX;
+            const int rank = static_cast<int>(
+                    std::lower_bound(cdf.begin(), cdf.end(), r) - cdf.begin());
+            stream[i] = static_cast<int>((rank * 2654435761u) % KEY_NUM);
+        }
+    }
+    return stream;
+}
+
+// BTree behind one mutex, the baseline.
+class LockedBTree
+{
+public:
+    bool Find(const int key, int& value) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_btree.Find(key, value);
+    }
+
+    bool Update(const int key, const int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        BTree<int, int>::BTreeNode* node = NULL;
+        int index = 0;
+        if (!m_btree.Find(key, &node, &index))
+        {
+            return false;
+        }
+        node->GetValue(static_cast<unsigned>(index)) = value;
+        return true;
+    }
+
+    bool Insert(const int key, const int value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_btree.Insert(key, value);
+    }
+
+    bool Delete(const int key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_btree.Delete(key);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    BTree<int, int> m_btree;
+};
+
+typedef ConcurrentBTree<int, int> IntConcurrentBTree;
+
+// The even keys are loaded, so that the odd ones can be inserted.
+template<typename T>
+static void LoadKeys(T& btree)
+{
+    for (int key = 0; key < KEY_NUM; key += 2)
+    {
+        btree.Insert(key, key);
+    }
+}
+
+// Every thread runs its share of the stream. update_percent of the
+// operations are updates and the rest are finds, like YCSB A (50),
+// B (5) and C (0). With is_churn, the updates are inserts and deletes
+// of the odd keys instead.
+template<typename T>
+struct YcsbWorker
+{
+    YcsbWorker(T& b, const int u, const bool c)
+    : btree(b), update_percent(u), is_churn(c)
+    {}
+
+    void operator()(const int thread_index, const int thread_num)
+    {
+        const std::vector<int>& stream = GetZipfianStream();
+        int value = 0;
+        for (std::size_t i = thread_index; i < stream.size(); i += thread_num)
+        {
+            const int key = stream[i];
+            if (static_cast<int>(i % 100) >= update_percent)
+            {
+                benchmark::DoNotOptimize(btree.Find(key, value));
+            }
+            else if (!is_churn)
+            {
+                btree.Update(key, static_cast<int>(i));
+            }
+            else if (i & 1)
+            {
+                btree.Insert(key | 1, key);
+            }
+            else
+            {
+                btree.Delete(key | 1);
+            }
+        }
+    }
+
+    T& btree;
+    const int update_percent;
+    const bool is_churn;
+};
+
+template<typename T>
+static void RunYcsb(benchmark::State& state, const int update_percent, const bool is_churn)
+{
+    (void) GetZipfianStream();
+    T btree;
+    LoadKeys(btree);
+    YcsbWorker<T> worker(btree, update_percent, is_churn);
+    while (state.KeepRunning())
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < state.range_x(); ++t)
+        {
+            threads.push_back(std::thread(std::ref(worker), t, state.range_x()));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OP_NUM);
+}
+
+// range_x is the number of threads.
+template<typename T>
+static void BM_YcsbA(benchmark::State& state)
+{
+    RunYcsb<T>(state, 50, false);
+}
+
+template<typename T>
+static void BM_YcsbB(benchmark::State& state)
+{
+    RunYcsb<T>(state, 5, false);
+}
+
+template<typename T>
+static void BM_YcsbC(benchmark::State& state)
+{
+    RunYcsb<T>(state, 0, false);
+}
+
+template<typename T>
+static void BM_YcsbChurn(benchmark::State& state)
+{
+    RunYcsb<T>(state, 50, true);
+}
+
+BENCHMARK_TEMPLATE(BM_YcsbA, LockedBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbA, IntConcurrentBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbB, LockedBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbB, IntConcurrentBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbC, LockedBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbC, IntConcurrentBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbChurn, LockedBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_YcsbChurn, IntConcurrentBTree)->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+                                                    ->UseRealTime();
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+#include "CountingHashMap.h"
+#include "HashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+
+static const int KEY_NUM = 1 << 20;
+static const int STREAM_SIZE = 1 << 22;
+
+// Keys drawn from a Zipfian distribution with s = 1 over KEY_NUM keys.
+static const std::vector<int>& GetZipfianStream()
+{
+    static std::vector<int> stream;
+    if (stream.empty())
+    {
+        std::vector<double> cdf(KEY_NUM);
+        double sum = 0;
+        for (int i = 0; i < KEY_NUM; ++i)
+        {
+            sum += 1.0 / (i + 1);
+            cdf[i] = sum;
+        }
+
+        srand(0);
+        stream.resize(STREAM_SIZE);
+        for (int i = 0; i < STREAM_SIZE; ++i)
+        {
+            const double r = sum * rand() / RAND_MAX;
+            stream[i] = static_cast<int>(
+                    std::lower_bound(cdf.begin(), cdf.end(), r) - cdf.begin());
+        }
+    }
+    return stream;
+}
+
+// Every thread counts its share of the stream.
+template<typename Worker>
+static void RunWorkers(const int thread_num, Worker& worker)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; ++t)
+    {
+        threads.push_back(std::thread(std::ref(worker), t, thread_num));
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+}
+
+struct LockedCountWorker
+{
+    void operator()(const int thread_index, const int thread_num)
+    {
+        const std::vector<int>& stream = GetZipfianStream();
+        for (std::size_t i = thread_index; i < stream.size(); i += thread_num)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            hash_map.FindAndInsertIfNotPresent(stream[i]) += 1;
+        }
+    }
+
+    std::mutex mutex;
+    HashMap<int, long long> hash_map;
+};
+
+struct LocalCountWorker
+{
+    void operator()(const int thread_index, const int thread_num)
+    {
+        const std::vector<int>& stream = GetZipfianStream();
+        CountingHashMap<int>::LocalCounter counter(counting_map);
+        for (std::size_t i = thread_index; i < stream.size(); i += thread_num)
+        {
+            counter.Add(stream[i]);
+        }
+    }
+
+    CountingHashMap<int> counting_map;
+};
+
+// range_x is the number of threads.
+static void BM_LockedHashMapCount(benchmark::State& state)
+{
+    (void) GetZipfianStream();
+    while (state.KeepRunning())
+    {
+        LockedCountWorker worker;
+        RunWorkers(state.range_x(), worker);
+    }
+    state.SetItemsProcessed(state.iterations() * STREAM_SIZE);
+}
+
+static void BM_CountingHashMapCount(benchmark::State& state)
+{
+    (void) GetZipfianStream();
+    while (state.KeepRunning())
+    {
+        LocalCountWorker worker;
+        RunWorkers(state.range_x(), worker);
+    }
+    state.SetItemsProcessed(state.iterations() * STREAM_SIZE);
+}
+
+BENCHMARK(BM_LockedHashMapCount)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)
+                                ->UseRealTime();
+BENCHMARK(BM_CountingHashMapCount)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)
+                                  ->UseRealTime();
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#include "HashMap.h"
+#include "ExpiringHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace snippet::algo;
+
+// Session table: ticks are milliseconds, sessions live for 10 minutes
+// and the expiration runs once every second.
+static const uint64_t gs_session_ttl = 600 * 1000;
+static const uint64_t gs_tick_interval = 1000;
+
+struct Session
+{
+    Session() : value(0), deadline(0) {}
+
+    int value;
+    uint64_t deadline;
+};
+
+static uint64_t InitialDeadline()
+{
+    return 1 + static_cast<uint64_t>(rand()) % gs_session_ttl;
+}
+
+// What we do today: walk the whole map every second.
+static void BM_HashMapSweepExpire(benchmark::State& state)
+{
+    HashMap<int, Session> hash_map;
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[i].deadline = InitialDeadline();
+    }
+
+    uint64_t now = 0;
+    std::vector<int> expired_keys;
+    while (state.KeepRunning())
+    {
+        now += gs_tick_interval;
+        expired_keys.clear();
+        for (HashMap<int, Session>::iterator it = hash_map.begin();
+             it != hash_map.end(); ++it)
+        {
+            if (it.GetValue().deadline <= now)
+            {
+                expired_keys.push_back(it.GetKey());
+            }
+        }
+
+        for (std::size_t i = 0; i < expired_keys.size(); ++i)
+        {
+            hash_map.Delete(expired_keys[i]);
+        }
+
+        // keep the table size steady
+        for (std::size_t i = 0; i < expired_keys.size(); ++i)
+        {
+            hash_map[expired_keys[i]].deadline = now + gs_session_ttl;
+        }
+    }
+}
+
+static void BM_ExpiringHashMapTick(benchmark::State& state)
+{
+    ExpiringHashMap<int, int> hash_map;
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(i, 0, InitialDeadline());
+    }
+
+    uint64_t now = 0;
+    int next_key = static_cast<int>(state.range_x());
+    while (state.KeepRunning())
+    {
+        now += gs_tick_interval;
+        const std::size_t expired_num = hash_map.Tick(now);
+        // keep the table size steady
+        for (std::size_t i = 0; i < expired_num; ++i)
+        {
+            hash_map.Insert(next_key++, 0, now + gs_session_ttl);
+        }
+    }
+}
+
+BENCHMARK(BM_HashMapSweepExpire)->Arg(1 << 16)->Arg(1 << 20)->Arg(10 * 1000 * 1000);
+BENCHMARK(BM_ExpiringHashMapTick)->Arg(1 << 16)->Arg(1 << 20)->Arg(10 * 1000 * 1000);
+
+
+BENCHMARK_MAIN();
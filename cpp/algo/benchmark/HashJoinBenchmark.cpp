@@ -0,0 +1,218 @@
+#include "HashMap.h"
+#include "HashJoin.h"
+#include "GroupByAggregator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace snippet::algo;
+
+// Columns of TPC-H like orders and lineitem tables: range_x orders with
+// 1 to 7 lines each. The order keys are sparse as in dbgen, and the
+// lines are shuffled, as they would be after a selection on another column.
+struct TpchData
+{
+    explicit TpchData(int order_num)
+    {
+        srand(0);
+        for (int i = 0; i < order_num; ++i)
+        {
+            const int order_key = (i / 8) * 32 + (i % 8) + 1;
+            o_orderkey.push_back(order_key);
+            o_totalprice.push_back(rand() % 50000000);
+
+            const int line_num = rand() % 7 + 1;
+            for (int j = 0; j < line_num; ++j)
+            {
+                l_orderkey.push_back(order_key);
+                l_quantity.push_back(rand() % 50 + 1);
+                l_extendedprice.push_back(rand() % 10000000);
+                // returnflag * 2 + linestatus, 6 groups
+                l_flag_status.push_back(rand() % 6);
+            }
+        }
+
+        std::vector<std::size_t> order(l_orderkey.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::random_shuffle(order.begin(), order.end());
+        Permute(order, l_orderkey);
+        Permute(order, l_quantity);
+        Permute(order, l_extendedprice);
+        Permute(order, l_flag_status);
+    }
+
+    static void Permute(const std::vector<std::size_t>& order, std::vector<int>& column)
+    {
+        std::vector<int> permuted(column.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            permuted[i] = column[order[i]];
+        }
+        column.swap(permuted);
+    }
+
+    static const TpchData& Get(int order_num)
+    {
+        static std::map<int, TpchData*> s_data;
+        TpchData*& data = s_data[order_num];
+        if (data == NULL)
+        {
+            data = new TpchData(order_num);
+        }
+        return *data;
+    }
+
+    std::vector<int> o_orderkey;
+    std::vector<int> o_totalprice;
+    std::vector<int> l_orderkey;
+    std::vector<int> l_quantity;
+    std::vector<int> l_extendedprice;
+    std::vector<int> l_flag_status;
+};
+
+enum { PROBE_BATCH_SIZE = 1 << 16 };
+
+struct SumPrice
+{
+    SumPrice() : sum(0) {}
+
+    void operator()(std::size_t, int totalprice)
+    {
+        sum += totalprice;
+    }
+
+    long long sum;
+};
+
+// select sum(o_totalprice) from orders, lineitem where o_orderkey = l_orderkey
+static void BM_JoinByFind(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    long long sum = 0;
+    while (state.KeepRunning())
+    {
+        HashMap<int, int> hash_map(data.o_orderkey.size());
+        for (std::size_t i = 0; i < data.o_orderkey.size(); ++i)
+        {
+            hash_map.Insert(data.o_orderkey[i], data.o_totalprice[i]);
+        }
+
+        int totalprice = 0;
+        for (std::size_t i = 0; i < data.l_orderkey.size(); ++i)
+        {
+            if (hash_map.Find(data.l_orderkey[i], totalprice))
+            {
+                sum += totalprice;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() *
+                            (data.o_orderkey.size() + data.l_orderkey.size()));
+}
+
+static void BM_JoinByFindBatch(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    SumPrice sum_price;
+    while (state.KeepRunning())
+    {
+        HashMap<int, int> hash_map(data.o_orderkey.size());
+        for (std::size_t i = 0; i < data.o_orderkey.size(); ++i)
+        {
+            hash_map.Insert(data.o_orderkey[i], data.o_totalprice[i]);
+        }
+        hash_map.FindBatch(&data.l_orderkey[0], data.l_orderkey.size(), sum_price);
+    }
+    benchmark::DoNotOptimize(sum_price.sum);
+    state.SetItemsProcessed(state.iterations() *
+                            (data.o_orderkey.size() + data.l_orderkey.size()));
+}
+
+static void BM_JoinByHashJoinTable(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    SumPrice sum_price;
+    while (state.KeepRunning())
+    {
+        HashJoinTable<int, int> join_table(data.o_orderkey.size());
+        for (std::size_t i = 0; i < data.o_orderkey.size(); ++i)
+        {
+            join_table.Add(data.o_orderkey[i], data.o_totalprice[i]);
+        }
+        join_table.Build();
+
+        for (std::size_t i = 0; i < data.l_orderkey.size(); i += PROBE_BATCH_SIZE)
+        {
+            const std::size_t n = std::min<std::size_t>(PROBE_BATCH_SIZE,
+                                                         data.l_orderkey.size() - i);
+            join_table.Probe(&data.l_orderkey[i], n, sum_price);
+        }
+        state.SetLabel(join_table.GetPartitionNum() > 1 ? "partitioned" : "1 partition");
+    }
+    benchmark::DoNotOptimize(sum_price.sum);
+    state.SetItemsProcessed(state.iterations() *
+                            (data.o_orderkey.size() + data.l_orderkey.size()));
+}
+
+// select l_orderkey, sum(l_quantity) from lineitem group by l_orderkey
+static void BM_GroupByOrderKeyWithHashMap(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    while (state.KeepRunning())
+    {
+        HashMap<int, long long> hash_map;
+        for (std::size_t i = 0; i < data.l_orderkey.size(); ++i)
+        {
+            hash_map[data.l_orderkey[i]] += data.l_quantity[i];
+        }
+        benchmark::DoNotOptimize(hash_map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * data.l_orderkey.size());
+}
+
+static void BM_GroupByOrderKeyWithAggregator(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    while (state.KeepRunning())
+    {
+        GroupByAggregator<int, SumReducer<int> > aggregator;
+        aggregator.Add(&data.l_orderkey[0], &data.l_quantity[0], data.l_orderkey.size());
+        benchmark::DoNotOptimize(aggregator.size());
+    }
+    state.SetItemsProcessed(state.iterations() * data.l_orderkey.size());
+}
+
+// select l_returnflag, l_linestatus, avg(l_extendedprice) from lineitem
+// group by l_returnflag, l_linestatus
+static void BM_GroupByFlagStatus(benchmark::State& state)
+{
+    const TpchData& data = TpchData::Get(state.range_x());
+    while (state.KeepRunning())
+    {
+        GroupByAggregator<int, AvgReducer<long long> > aggregator;
+        for (std::size_t i = 0; i < data.l_flag_status.size(); ++i)
+        {
+            aggregator.Add(data.l_flag_status[i], data.l_extendedprice[i]);
+        }
+        benchmark::DoNotOptimize(aggregator.size());
+    }
+    state.SetItemsProcessed(state.iterations() * data.l_flag_status.size());
+}
+
+BENCHMARK(BM_JoinByFind)->Range(1 << 14, 1 << 20);
+BENCHMARK(BM_JoinByFindBatch)->Range(1 << 14, 1 << 20);
+BENCHMARK(BM_JoinByHashJoinTable)->Range(1 << 14, 1 << 20);
+
+BENCHMARK(BM_GroupByOrderKeyWithHashMap)->Range(1 << 14, 1 << 20);
+BENCHMARK(BM_GroupByOrderKeyWithAggregator)->Range(1 << 14, 1 << 20);
+BENCHMARK(BM_GroupByFlagStatus)->Range(1 << 14, 1 << 20);
+
+BENCHMARK_MAIN();
@@ -2,10 +2,12 @@
 
 #include <benchmark/benchmark.h>
 
+#include <cstdio>
 #include <string>
 #include <tr1/unordered_map>
 #include <map>
 #include <utility>
+#include <vector>
 
 using namespace snippet::algo;
 
@@ -90,6 +92,95 @@ static void BM_StdUnorderedMapDelete(benchmark::State& state)
     }
 }
 
+typedef HashMap<std::string, int> StringHashMap;
+
+static void FillStringHashMap(StringHashMap& hash_map, int size)
+{
+    char key[32];
+    for (int i = 0; i < size; ++i)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        hash_map.Insert(key, i);
+    }
+}
+
+// An eviction sweep dropping the odd values, by the three ways below.
+static bool IsEvicted(int value)
+{
+    return value % 2 == 1;
+}
+
+struct EvictPredicate
+{
+    bool operator()(const std::string&, int value) const
+    {
+        return IsEvicted(value);
+    }
+};
+
+static void BM_HashMapSweepByDelete(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        StringHashMap hash_map;
+        FillStringHashMap(hash_map, state.range_x());
+        state.ResumeTiming();
+
+        std::vector<std::string> keys;
+        for (StringHashMap::const_iterator it = hash_map.begin(); it != hash_map.end(); ++it)
+        {
+            if (IsEvicted(it.GetValue()))
+            {
+                keys.push_back(it.GetKey());
+            }
+        }
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            hash_map.Delete(keys[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_HashMapSweepByErase(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        StringHashMap hash_map;
+        FillStringHashMap(hash_map, state.range_x());
+        state.ResumeTiming();
+
+        for (StringHashMap::iterator it = hash_map.begin(); it != hash_map.end(); )
+        {
+            if (IsEvicted(it.GetValue()))
+            {
+                it = hash_map.Erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+static void BM_HashMapSweepByEraseIf(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        StringHashMap hash_map;
+        FillStringHashMap(hash_map, state.range_x());
+        state.ResumeTiming();
+
+        hash_map.EraseIf(EvictPredicate());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
 BENCHMARK_TEMPLATE(BM_HashMapDelete, int)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdMapDelete, int)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdUnorderedMapDelete, int)->Range(8, 8<<10);
@@ -98,6 +189,10 @@ BENCHMARK_TEMPLATE(BM_HashMapDelete, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdMapDelete, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdUnorderedMapDelete, std::string)->Range(8, 8<<10);
 
+BENCHMARK(BM_HashMapSweepByDelete)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_HashMapSweepByErase)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_HashMapSweepByEraseIf)->Range(1 << 10, 1 << 20);
+
 
 BENCHMARK_MAIN();
 
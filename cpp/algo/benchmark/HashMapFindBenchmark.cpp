@@ -1,8 +1,12 @@
 #include "HashMap.h"
+#include "FilteredHashMap.h"
+#include "HugePageAllocator.h"
 
 #include <benchmark/benchmark.h>
 
+#include <cstdlib>
 #include <string>
+#include <vector>
 #include <tr1/unordered_map>
 #include <map>
 #include <utility>
@@ -88,6 +92,37 @@ BENCHMARK_TEMPLATE2(BM_HashMapConstFind, StrHashMap, std::string)->Range(8, 8<<1
 BENCHMARK_TEMPLATE2(BM_StdMapConstFind, StrStdMap, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE2(BM_StdMapConstFind, StrUnorderedMap, std::string)->Range(8, 8<<10);
 
+// 80% of the lookups are misses, like a dedup path.
+template<typename C>
+static void BM_HashMapMissHeavyFind(benchmark::State& state)
+{
+    C hash_map;
+    std::vector<int> keys(state.range_x());
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[i * 2] = i;
+        const int key = rand() % state.range_x();
+        keys[i] = (rand() % 5 == 0) ? key * 2 : key * 2 + 1;
+    }
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+typedef FilteredHashMap<int, int> IntFilteredHashMap;
+
+BENCHMARK_TEMPLATE(BM_HashMapMissHeavyFind, IntHashMap)->Range(1 << 10, 1 << 24);
+BENCHMARK_TEMPLATE(BM_HashMapMissHeavyFind, IntFilteredHashMap)->Range(1 << 10, 1 << 24);
+
 template<typename C, typename T>
 static void BM_HashMapSeqFind(benchmark::State& state)
 {
@@ -134,6 +169,55 @@ BENCHMARK_TEMPLATE2(BM_HashMapSeqFind, StrHashMap, std::string)->Range(8, 8<<10)
 BENCHMARK_TEMPLATE2(BM_StdMapSeqFind, StrStdMap, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE2(BM_StdMapSeqFind, StrUnorderedMap, std::string)->Range(8, 8<<10);
 
+typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                DefaultHashMapRehashPolicy, HugePageAllocator<int> > IntHugePageHashMap;
+
+// Random lookups over a large map, where the TLB misses on the bucket
+// array matter. range_y is the NumaPolicy of the huge page buckets.
+template<typename C>
+static void DoRandomFind(benchmark::State& state, C& hash_map)
+{
+    std::vector<int> keys(state.range_x());
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[i] = i;
+        keys[i] = rand() % state.range_x();
+    }
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+}
+
+static void BM_HashMapRandomFind(benchmark::State& state)
+{
+    IntHashMap hash_map;
+    DoRandomFind(state, hash_map);
+}
+
+static void BM_HugePageHashMapRandomFind(benchmark::State& state)
+{
+    const NumaPolicy policy = static_cast<NumaPolicy>(state.range_y());
+    IntHugePageHashMap hash_map(static_cast<std::size_t>(0),
+                                IntHugePageHashMap::key_equal(),
+                                IntHugePageHashMap::hash_policy(),
+                                IntHugePageHashMap::rehash_policy(),
+                                IntHugePageHashMap::NodeAllocator(),
+                                IntHugePageHashMap::BucketAllocator(policy));
+    DoRandomFind(state, hash_map);
+}
+
+BENCHMARK(BM_HashMapRandomFind)->Range(1 << 16, 1 << 24);
+BENCHMARK(BM_HugePageHashMapRandomFind)->RangePair(1 << 16, 1 << 24,
+                                                   NUMA_DEFAULT, NUMA_INTERLEAVE);
+
 
 BENCHMARK_MAIN();
 
@@ -6,6 +6,11 @@
 #include <tr1/unordered_map>
 #include <map>
 #include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 using namespace snippet::algo;
 
@@ -74,6 +79,42 @@ static void BM_StdUnorderedMapInsert(benchmark::State& state)
     }
 }
 
+// A map per request, filled then dropped: the nodes come from operator new,
+// or from a monotonic buffer resource over a buffer reused by the requests.
+template<typename T>
+static void BM_HashMapRequestInsert(benchmark::State& state)
+{
+    T value = GetValue<T>::Get();
+    while (state.KeepRunning())
+    {
+        HashMap<int, T> hash_map;
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Insert(i, value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+#if __cplusplus >= 201703L
+template<typename T>
+static void BM_PmrHashMapRequestInsert(benchmark::State& state)
+{
+    std::vector<char> buffer(state.range_x() * 128 + 4096);
+    T value = GetValue<T>::Get();
+    while (state.KeepRunning())
+    {
+        std::pmr::monotonic_buffer_resource resource(&buffer[0], buffer.size());
+        pmr::HashMap<int, T> hash_map(0, &resource);
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Insert(i, value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+#endif
+
 // Register the function as a benchmark
 // BM for <int, int>
 BENCHMARK_TEMPLATE(BM_HashMapInsert, int)->Range(8, 8<<10);
@@ -84,6 +125,13 @@ BENCHMARK_TEMPLATE(BM_HashMapInsert, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdMapInsert, std::string)->Range(8, 8<<10);
 BENCHMARK_TEMPLATE(BM_StdUnorderedMapInsert, std::string)->Range(8, 8<<10);
 
+BENCHMARK_TEMPLATE(BM_HashMapRequestInsert, int)->Range(8, 8<<10);
+BENCHMARK_TEMPLATE(BM_HashMapRequestInsert, std::string)->Range(8, 8<<10);
+#if __cplusplus >= 201703L
+BENCHMARK_TEMPLATE(BM_PmrHashMapRequestInsert, int)->Range(8, 8<<10);
+BENCHMARK_TEMPLATE(BM_PmrHashMapRequestInsert, std::string)->Range(8, 8<<10);
+#endif
+
 
 BENCHMARK_MAIN();
 
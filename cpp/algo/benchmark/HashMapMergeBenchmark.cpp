@@ -0,0 +1,113 @@
+#include "HashMap.h"
+#include "ParallelHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace snippet::algo;
+
+typedef HashMap<int, int> IntHashMap;
+
+struct AddValue
+{
+    void operator()(int& value, int other_value) const
+    {
+        value += other_value;
+    }
+};
+
+// range_x partial maps of 10000 keys each, half of them shared.
+static void MakePartialMaps(benchmark::State& state, std::vector<IntHashMap*>& maps)
+{
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        IntHashMap* hash_map = new IntHashMap();
+        for (int j = 0; j < 10000; ++j)
+        {
+            (*hash_map)[rand() % (state.range_x() * 5000)] = 1;
+        }
+        maps.push_back(hash_map);
+    }
+}
+
+static void DeletePartialMaps(std::vector<IntHashMap*>& maps)
+{
+    for (std::size_t i = 0; i < maps.size(); ++i)
+    {
+        delete maps[i];
+    }
+    maps.clear();
+}
+
+static void BM_HashMapMergeByInsert(benchmark::State& state)
+{
+    std::vector<IntHashMap*> maps;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        MakePartialMaps(state, maps);
+        state.ResumeTiming();
+
+        IntHashMap result;
+        for (std::size_t i = 0; i < maps.size(); ++i)
+        {
+            for (IntHashMap::const_iterator it = maps[i]->begin(); it != maps[i]->end(); ++it)
+            {
+                result[it.GetKey()] += it.GetValue();
+            }
+        }
+
+        state.PauseTiming();
+        DeletePartialMaps(maps);
+        state.ResumeTiming();
+    }
+}
+
+static void BM_HashMapMerge(benchmark::State& state)
+{
+    std::vector<IntHashMap*> maps;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        MakePartialMaps(state, maps);
+        state.ResumeTiming();
+
+        for (std::size_t i = 1; i < maps.size(); ++i)
+        {
+            maps[0]->Merge(*maps[i], AddValue());
+        }
+
+        state.PauseTiming();
+        DeletePartialMaps(maps);
+        state.ResumeTiming();
+    }
+}
+
+// range_y is the number of threads.
+static void BM_HashMapParallelMerge(benchmark::State& state)
+{
+    std::vector<IntHashMap*> maps;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        MakePartialMaps(state, maps);
+        state.ResumeTiming();
+
+        ParallelMerge(&maps[0], maps.size(), AddValue(), state.range_y());
+
+        state.PauseTiming();
+        DeletePartialMaps(maps);
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK(BM_HashMapMergeByInsert)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(BM_HashMapMerge)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(BM_HashMapParallelMerge)->ArgPair(256, 1)->ArgPair(256, 4)
+                                  ->ArgPair(256, 16)->UseRealTime();
+
+
+BENCHMARK_MAIN();
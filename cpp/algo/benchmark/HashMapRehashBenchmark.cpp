@@ -0,0 +1,84 @@
+#include "HashMap.h"
+#include "ParallelHashMap.h"
+#include "PoolAllocator.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace snippet::algo;
+
+// range_x is the number of nodes, range_y the number of threads.
+static void BM_HashMapRehash(benchmark::State& state)
+{
+    HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+            ParallelHashMapRehashPolicy> hash_map(static_cast<std::size_t>(0),
+                                                  DefaultKeyEqual<int>(),
+                                                  DefaultHashMapHashPolicy<int>(),
+                                                  ParallelHashMapRehashPolicy(2, state.range_y()));
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[i] = i;
+    }
+
+    const std::size_t small_bucket_count = hash_map.GetBucketCount();
+    const std::size_t large_bucket_count = small_bucket_count * 2;
+    while (state.KeepRunning())
+    {
+        hash_map.Rehash(large_bucket_count);
+        hash_map.Rehash(small_bucket_count);
+    }
+}
+
+typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                ParallelHashMapRehashPolicy> IntHashMap;
+typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                ParallelHashMapRehashPolicy, PoolAllocator<int> > IntPoolHashMap;
+
+template<typename C>
+static void BM_HashMapCopy(benchmark::State& state)
+{
+    C hash_map(static_cast<std::size_t>(0), DefaultKeyEqual<int>(),
+               DefaultHashMapHashPolicy<int>(),
+               ParallelHashMapRehashPolicy(2, state.range_y()));
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[i] = i;
+    }
+
+    while (state.KeepRunning())
+    {
+        C hash_map_copy(hash_map);
+        benchmark::DoNotOptimize(hash_map_copy.size());
+    }
+}
+
+// With a PoolAllocator the nodes are freed without walking them.
+template<typename C>
+static void BM_HashMapClear(benchmark::State& state)
+{
+    C hash_map;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map[i] = i;
+        }
+        state.ResumeTiming();
+        hash_map.Clear();
+    }
+}
+
+BENCHMARK(BM_HashMapRehash)->ArgPair(1 << 22, 1)->ArgPair(1 << 22, 2)
+                           ->ArgPair(1 << 22, 4)->ArgPair(1 << 22, 8)
+                           ->ArgPair(1 << 22, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HashMapCopy, IntHashMap)->ArgPair(1 << 22, 1)->ArgPair(1 << 22, 2)
+                                             ->ArgPair(1 << 22, 4)->ArgPair(1 << 22, 8)
+                                             ->ArgPair(1 << 22, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HashMapCopy, IntPoolHashMap)->ArgPair(1 << 22, 1)->ArgPair(1 << 22, 2)
+                                                 ->ArgPair(1 << 22, 4)->ArgPair(1 << 22, 8)
+                                                 ->ArgPair(1 << 22, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HashMapClear, IntHashMap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_HashMapClear, IntPoolHashMap)->Range(1 << 10, 1 << 22);
+
+
+BENCHMARK_MAIN();
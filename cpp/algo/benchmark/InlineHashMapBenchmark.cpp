@@ -0,0 +1,73 @@
+#include "HashMap.h"
+#include "InlineHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace snippet::algo;
+
+// range_x is the number of entries, range_y the load factor of
+// DefaultHashMapRehashPolicy, i.e. the average chain length before rehash.
+template<typename C>
+static void BM_RandomFind(benchmark::State& state)
+{
+    C hash_map(static_cast<std::size_t>(0), typename C::key_equal(),
+               typename C::hash_policy(),
+               DefaultHashMapRehashPolicy(state.range_y()));
+    std::vector<int> keys(state.range_x());
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map[rand()] = i;
+    }
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        keys[i] = rand();
+    }
+    // half of the lookups hit
+    srand(0);
+    for (int i = 0; i < state.range_x(); i += 2)
+    {
+        keys[i] = rand();
+    }
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename C>
+static void BM_Insert(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        C hash_map(static_cast<std::size_t>(0), typename C::key_equal(),
+                   typename C::hash_policy(),
+                   DefaultHashMapRehashPolicy(state.range_y()));
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Insert(i, i);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+typedef HashMap<int, int> IntHashMap;
+typedef InlineHashMap<int, int> IntInlineHashMap;
+
+BENCHMARK_TEMPLATE(BM_RandomFind, IntHashMap)->RangePair(1 << 10, 1 << 22, 1, 4);
+BENCHMARK_TEMPLATE(BM_RandomFind, IntInlineHashMap)->RangePair(1 << 10, 1 << 22, 1, 4);
+
+BENCHMARK_TEMPLATE(BM_Insert, IntHashMap)->RangePair(1 << 10, 1 << 20, 1, 4);
+BENCHMARK_TEMPLATE(BM_Insert, IntInlineHashMap)->RangePair(1 << 10, 1 << 20, 1, 4);
+
+BENCHMARK_MAIN();
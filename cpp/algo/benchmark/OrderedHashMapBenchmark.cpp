@@ -0,0 +1,115 @@
+#include "HashMap.h"
+#include "OrderedHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace snippet::algo;
+
+typedef HashMap<int, int> IntHashMap;
+typedef OrderedHashMap<int, int> IntOrderedHashMap;
+
+template<typename C>
+static void BM_Insert(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        C hash_map;
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Insert(i, i);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+template<typename C>
+static void BM_RandomFind(benchmark::State& state)
+{
+    C hash_map;
+    std::vector<int> keys(state.range_x());
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(rand(), i);
+        keys[i] = rand() % state.range_x();
+    }
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < state.range_x(); ++i)
+        {
+            hash_map.Find(keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range_x());
+}
+
+// Full scan after deleting range_y percent of the entries.
+template<typename C>
+static void BM_Iterate(benchmark::State& state)
+{
+    C hash_map;
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(rand(), i);
+    }
+    srand(0);
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        const int key = rand();
+        if (i % 100 < state.range_y())
+        {
+            hash_map.Delete(key);
+        }
+    }
+
+    long long sum = 0;
+    while (state.KeepRunning())
+    {
+        for (typename C::const_iterator it = hash_map.begin(); it != hash_map.end(); ++it)
+        {
+            sum += it.GetValue();
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * hash_map.size());
+}
+
+static void BM_OrderedHashMapMemory(benchmark::State& state)
+{
+    IntOrderedHashMap hash_map;
+    for (int i = 0; i < state.range_x(); ++i)
+    {
+        hash_map.Insert(i, i);
+    }
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(hash_map.GetMemoryUsage());
+    }
+
+    // HashMap has a Node* bucket per entry at most plus a 24 bytes node
+    char label[64];
+    snprintf(label, sizeof(label), "bytes/entry=%.1f",
+             static_cast<double>(hash_map.GetMemoryUsage()) / hash_map.size());
+    state.SetLabel(label);
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, IntHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, IntOrderedHashMap)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_TEMPLATE(BM_RandomFind, IntHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_RandomFind, IntOrderedHashMap)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_TEMPLATE(BM_Iterate, IntHashMap)->RangePair(1 << 10, 1 << 20, 0, 50);
+BENCHMARK_TEMPLATE(BM_Iterate, IntOrderedHashMap)->RangePair(1 << 10, 1 << 20, 0, 50);
+
+BENCHMARK(BM_OrderedHashMapMemory)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
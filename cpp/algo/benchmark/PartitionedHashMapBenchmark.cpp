@@ -0,0 +1,110 @@
+#include "HashMap.h"
+#include "PartitionedHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace snippet::algo;
+
+static const int INPUT_SIZE = 1 << 23;
+
+// Random keys, a quarter of which are repeated.
+struct BuildInput
+{
+    BuildInput()
+    {
+        srand(0);
+        for (int i = 0; i < INPUT_SIZE; ++i)
+        {
+            keys.push_back(rand() % (INPUT_SIZE / 4 * 3));
+            values.push_back(i);
+        }
+    }
+
+    static const BuildInput& Get()
+    {
+        static BuildInput s_input;
+        return s_input;
+    }
+
+    std::vector<int> keys;
+    std::vector<int> values;
+};
+
+static void BM_HashMapBuild(benchmark::State& state)
+{
+    const BuildInput& input = BuildInput::Get();
+    while (state.KeepRunning())
+    {
+        HashMap<int, int> hash_map;
+        for (std::size_t i = 0; i < input.keys.size(); ++i)
+        {
+            hash_map.Insert(input.keys[i], input.values[i]);
+        }
+        benchmark::DoNotOptimize(hash_map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * INPUT_SIZE);
+}
+
+// range_x is the number of threads.
+static void BM_PartitionedHashMapBuild(benchmark::State& state)
+{
+    const BuildInput& input = BuildInput::Get();
+    while (state.KeepRunning())
+    {
+        PartitionedHashMap<int, int> hash_map;
+        hash_map.Build(&input.keys[0], &input.values[0], input.keys.size(), state.range_x());
+        benchmark::DoNotOptimize(hash_map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * INPUT_SIZE);
+}
+
+static void BM_PartitionedHashMapFind(benchmark::State& state)
+{
+    const BuildInput& input = BuildInput::Get();
+    PartitionedHashMap<int, int> hash_map;
+    hash_map.Build(&input.keys[0], &input.values[0], input.keys.size(), 1);
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < (1 << 20); ++i)
+        {
+            hash_map.Find(input.keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * (1 << 20));
+}
+
+static void BM_HashMapFind(benchmark::State& state)
+{
+    const BuildInput& input = BuildInput::Get();
+    HashMap<int, int> hash_map;
+    for (std::size_t i = 0; i < input.keys.size(); ++i)
+    {
+        hash_map.Insert(input.keys[i], input.values[i]);
+    }
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < (1 << 20); ++i)
+        {
+            hash_map.Find(input.keys[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * (1 << 20));
+}
+
+BENCHMARK(BM_HashMapBuild)->UseRealTime();
+BENCHMARK(BM_PartitionedHashMapBuild)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)
+                                     ->UseRealTime();
+
+BENCHMARK(BM_HashMapFind);
+BENCHMARK(BM_PartitionedHashMapFind);
+
+BENCHMARK_MAIN();
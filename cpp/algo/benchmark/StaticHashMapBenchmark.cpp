@@ -0,0 +1,107 @@
+#include "HashMap.h"
+#include "StaticHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace snippet::algo;
+
+static constexpr StaticHashMapItem<int> gs_headers[] = {
+    {"Accept", 0}, {"Accept-Charset", 1}, {"Accept-Encoding", 2},
+    {"Accept-Language", 3}, {"Accept-Ranges", 4}, {"Age", 5}, {"Allow", 6},
+    {"Authorization", 7}, {"Cache-Control", 8}, {"Connection", 9},
+    {"Content-Encoding", 10}, {"Content-Language", 11}, {"Content-Length", 12},
+    {"Content-Location", 13}, {"Content-MD5", 14}, {"Content-Range", 15},
+    {"Content-Type", 16}, {"Cookie", 17}, {"Date", 18}, {"ETag", 19},
+    {"Expect", 20}, {"Expires", 21}, {"From", 22}, {"Host", 23},
+    {"If-Match", 24}, {"If-Modified-Since", 25}, {"If-None-Match", 26},
+    {"If-Range", 27}, {"If-Unmodified-Since", 28}, {"Last-Modified", 29},
+    {"Location", 30}, {"Max-Forwards", 31}, {"Pragma", 32},
+    {"Proxy-Authenticate", 33}, {"Proxy-Authorization", 34}, {"Range", 35},
+    {"Referer", 36}, {"Retry-After", 37}, {"Server", 38}, {"Set-Cookie", 39},
+    {"TE", 40}, {"Trailer", 41}, {"Transfer-Encoding", 42}, {"Upgrade", 43},
+    {"User-Agent", 44}, {"Vary", 45}, {"Via", 46}, {"Warning", 47},
+    {"WWW-Authenticate", 48}
+};
+
+enum { HEADER_NUM = sizeof(gs_headers) / sizeof(gs_headers[0]) };
+
+static constexpr StaticHashMap<int, HEADER_NUM> gs_header_map(gs_headers);
+
+// range_x percent of the lookups are hits.
+static std::vector<std::string> MakeLookups(int hit_percent)
+{
+    std::vector<std::string> lookups;
+    srand(0);
+    for (int i = 0; i < 1024; ++i)
+    {
+        std::string header = gs_headers[rand() % HEADER_NUM].key;
+        if (rand() % 100 >= hit_percent)
+        {
+            header += "-X";
+        }
+        lookups.push_back(header);
+    }
+    return lookups;
+}
+
+static void BM_HashMapFind(benchmark::State& state)
+{
+    HashMap<std::string, int> hash_map;
+    for (int i = 0; i < HEADER_NUM; ++i)
+    {
+        hash_map.Insert(gs_headers[i].key, gs_headers[i].value);
+    }
+    const std::vector<std::string> lookups = MakeLookups(state.range_x());
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < lookups.size(); ++i)
+        {
+            hash_map.Find(lookups[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+static void BM_StaticHashMapFind(benchmark::State& state)
+{
+    const std::vector<std::string> lookups = MakeLookups(state.range_x());
+
+    int value = 0;
+    while (state.KeepRunning())
+    {
+        for (std::size_t i = 0; i < lookups.size(); ++i)
+        {
+            gs_header_map.Find(lookups[i], value);
+        }
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+// The startup cost which StaticHashMap does not have.
+static void BM_HashMapBuild(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        HashMap<std::string, int> hash_map;
+        for (int i = 0; i < HEADER_NUM; ++i)
+        {
+            hash_map.Insert(gs_headers[i].key, gs_headers[i].value);
+        }
+        benchmark::DoNotOptimize(hash_map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * HEADER_NUM);
+}
+
+BENCHMARK(BM_HashMapFind)->Arg(0)->Arg(50)->Arg(100);
+BENCHMARK(BM_StaticHashMapFind)->Arg(0)->Arg(50)->Arg(100);
+BENCHMARK(BM_HashMapBuild);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,115 @@
+#include "HashMap.h"
+#include "StringInterner.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+
+static const int STREAM_SIZE = 1 << 20;
+
+// STREAM_SIZE names drawn from range_x distinct host names.
+static void MakeNames(benchmark::State& state, std::vector<std::string>& names)
+{
+    srand(0);
+    names.resize(STREAM_SIZE);
+    char name[64];
+    for (int i = 0; i < STREAM_SIZE; ++i)
+    {
+        const int host = rand() % static_cast<int>(state.range_x());
+        snprintf(name, sizeof(name), "host-%08d.rack-%03d.example.com", host, host % 100);
+        names[i] = name;
+    }
+}
+
+static void BM_StringKeyCount(benchmark::State& state)
+{
+    std::vector<std::string> names;
+    MakeNames(state, names);
+    while (state.KeepRunning())
+    {
+        HashMap<std::string, int> counts;
+        for (int i = 0; i < STREAM_SIZE; ++i)
+        {
+            ++counts[names[i]];
+        }
+        benchmark::DoNotOptimize(counts.size());
+    }
+    state.SetItemsProcessed(state.iterations() * STREAM_SIZE);
+}
+
+static void BM_InternedKeyCount(benchmark::State& state)
+{
+    std::vector<std::string> names;
+    MakeNames(state, names);
+    StringInterner::Stats stats;
+    while (state.KeepRunning())
+    {
+        StringInterner interner;
+        HashMap<StringInterner::Symbol, int> counts;
+        for (int i = 0; i < STREAM_SIZE; ++i)
+        {
+            ++counts[interner.Intern(names[i])];
+        }
+        benchmark::DoNotOptimize(counts.size());
+        interner.GetStats(&stats);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "saved_bytes=%zu", stats.GetSavedBytes());
+    state.SetLabel(label);
+    state.SetItemsProcessed(state.iterations() * STREAM_SIZE);
+}
+
+struct InternWorker
+{
+    InternWorker(StringInterner& i, const std::vector<std::string>& n)
+    : interner(i), names(n)
+    {}
+
+    void operator()(const int thread_index, const int thread_num)
+    {
+        for (std::size_t i = thread_index; i < names.size(); i += thread_num)
+        {
+            benchmark::DoNotOptimize(interner.Intern(names[i]));
+        }
+    }
+
+    StringInterner& interner;
+    const std::vector<std::string>& names;
+};
+
+// range_y is the number of threads.
+static void BM_ConcurrentIntern(benchmark::State& state)
+{
+    std::vector<std::string> names;
+    MakeNames(state, names);
+    while (state.KeepRunning())
+    {
+        StringInterner interner;
+        InternWorker worker(interner, names);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < state.range_y(); ++t)
+        {
+            threads.push_back(std::thread(std::ref(worker), t, state.range_y()));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * STREAM_SIZE);
+}
+
+BENCHMARK(BM_StringKeyCount)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_InternedKeyCount)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_ConcurrentIntern)->ArgPair(1 << 16, 1)->ArgPair(1 << 16, 4)
+                              ->ArgPair(1 << 16, 16)->UseRealTime();
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,305 @@
+#include "BPlusTree.h"
+#include "PoolAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+namespace {
+
+// small nodes, for deep trees
+typedef BPlusTree<int, int, less<int>, 96> SmallBPlusTree;
+
+template<typename Key, typename Value>
+struct CollectCallback
+{
+    void operator()(const Key& key, const Value& value)
+    {
+        keys.push_back(key);
+        values.push_back(value);
+    }
+
+    vector<Key> keys;
+    vector<Value> values;
+};
+
+template<typename Tree, typename Key, typename Value, typename Compare>
+void CheckEntries(const Tree& tree, const map<Key, Value, Compare>& expected)
+{
+    ASSERT_EQ(expected.size(), tree.size());
+    typename Tree::const_iterator it = tree.begin();
+    for (typename map<Key, Value, Compare>::const_iterator expected_it = expected.begin();
+         expected_it != expected.end(); ++expected_it, ++it)
+    {
+        ASSERT_TRUE(it != tree.end());
+        ASSERT_EQ(expected_it->first, it.GetKey());
+        ASSERT_EQ(expected_it->second, it.GetValue());
+    }
+    ASSERT_TRUE(it == tree.end());
+
+    typedef typename map<Key, Value, Compare>::const_reverse_iterator ReverseIterator;
+    for (ReverseIterator expected_it = expected.rbegin(); expected_it != expected.rend();
+         ++expected_it)
+    {
+        --it;
+        ASSERT_EQ(expected_it->first, it.GetKey());
+    }
+    ASSERT_TRUE(it == tree.begin());
+}
+
+template<typename T>
+struct CountingAllocator : public allocator<T>
+{
+    typedef T value_type;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef CountingAllocator<Other> other;
+    };
+
+    explicit CountingAllocator(int* n) : node_num(n) {}
+
+    template<typename Other>
+    CountingAllocator(const CountingAllocator<Other>& other) : node_num(other.node_num) {}
+
+    T* allocate(size_t n)
+    {
+        *node_num += static_cast<int>(n);
+        return allocator<T>::allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        *node_num -= static_cast<int>(n);
+        allocator<T>::deallocate(p, n);
+    }
+
+    int* node_num;
+};
+
+}
+
+TEST(BPlusTree, TestEmpty)
+{
+    SmallBPlusTree tree;
+    ASSERT_TRUE(tree.empty());
+    ASSERT_TRUE(tree.begin() == tree.end());
+    ASSERT_TRUE(tree.LowerBound(1) == tree.end());
+
+    int value = 0;
+    ASSERT_FALSE(tree.Find(1, value));
+    ASSERT_FALSE(tree.Delete(1));
+
+    CollectCallback<int, int> callback;
+    ASSERT_EQ(0u, tree.Scan(0, 100, callback));
+}
+
+TEST(BPlusTree, TestInsertFindDelete)
+{
+    SmallBPlusTree tree;
+    ASSERT_GE(static_cast<int>(SmallBPlusTree::Inner::MAX_KEY_NUM), 3);
+    ASSERT_EQ(1, SmallBPlusTree::Inner::MAX_KEY_NUM % 2);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE(tree.Insert(i, i * 10));
+    }
+    ASSERT_FALSE(tree.Insert(10, 0));
+    ASSERT_EQ(1000u, tree.size());
+
+    int value = 0;
+    ASSERT_TRUE(tree.Find(10, value));
+    ASSERT_EQ(100, value);
+    ASSERT_FALSE(tree.Find(1000, value));
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        ASSERT_TRUE(tree.Delete(i));
+    }
+    ASSERT_FALSE(tree.Delete(10));
+    ASSERT_FALSE(tree.Find(10, value));
+    ASSERT_TRUE(tree.Find(11, value));
+    ASSERT_EQ(500u, tree.size());
+
+    for (int i = 999; i >= 0; i -= 2)
+    {
+        ASSERT_TRUE(tree.Delete(i));
+    }
+    ASSERT_TRUE(tree.empty());
+    ASSERT_TRUE(tree.begin() == tree.end());
+
+    ASSERT_TRUE(tree.Insert(1, 1));
+    tree.Clear();
+    ASSERT_TRUE(tree.empty());
+}
+
+TEST(BPlusTree, TestRandomOperations)
+{
+    SmallBPlusTree tree;
+    map<int, int> expected;
+    srand(0);
+    for (int i = 0; i < 50000; ++i)
+    {
+        const int key = rand() % 3000;
+        if (rand() % 3 == 0)
+        {
+            ASSERT_EQ(expected.erase(key) > 0, tree.Delete(key));
+        }
+        else
+        {
+            ASSERT_EQ(expected.insert(make_pair(key, i)).second, tree.Insert(key, i));
+        }
+
+        if (i % 5000 == 0)
+        {
+            CheckEntries(tree, expected);
+        }
+    }
+    CheckEntries(tree, expected);
+}
+
+TEST(BPlusTree, TestLowerBoundAndUpperBound)
+{
+    SmallBPlusTree tree;
+    for (int i = 0; i < 500; ++i)
+    {
+        tree.Insert(i * 2, i);
+    }
+
+    for (int key = -1; key <= 1000; ++key)
+    {
+        SmallBPlusTree::iterator lower = tree.LowerBound(key);
+        SmallBPlusTree::const_iterator upper =
+                static_cast<const SmallBPlusTree&>(tree).UpperBound(key);
+        if (key >= 998)
+        {
+            ASSERT_TRUE(upper == tree.end());
+        }
+        else
+        {
+            ASSERT_EQ(key < 0 ? 0 : (key / 2 + 1) * 2, upper.GetKey());
+        }
+
+        if (key > 998)
+        {
+            ASSERT_TRUE(lower == tree.end());
+        }
+        else
+        {
+            ASSERT_EQ(key < 0 ? 0 : (key + 1) / 2 * 2, lower.GetKey());
+        }
+    }
+
+    SmallBPlusTree::iterator it = tree.LowerBound(10);
+    it.GetValue() = -1;
+    int value = 0;
+    ASSERT_TRUE(tree.Find(10, value));
+    ASSERT_EQ(-1, value);
+}
+
+TEST(BPlusTree, TestScan)
+{
+    SmallBPlusTree tree;
+    map<int, int> expected;
+    for (int i = 0; i < 2000; ++i)
+    {
+        const int key = rand() % 10000;
+        tree.Insert(key, i);
+        expected.insert(make_pair(key, i));
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const int from = rand() % 11000 - 500;
+        const int to = from + rand() % 3000;
+        CollectCallback<int, int> callback;
+        const size_t count = tree.Scan(from, to, callback);
+
+        vector<int> expected_keys;
+        vector<int> expected_values;
+        for (map<int, int>::const_iterator it = expected.lower_bound(from);
+             it != expected.lower_bound(to); ++it)
+        {
+            expected_keys.push_back(it->first);
+            expected_values.push_back(it->second);
+        }
+        ASSERT_EQ(expected_keys.size(), count);
+        ASSERT_EQ(expected_keys, callback.keys);
+        ASSERT_EQ(expected_values, callback.values);
+    }
+
+    CollectCallback<int, int> callback;
+    ASSERT_EQ(0u, tree.Scan(100, 100, callback));
+    ASSERT_EQ(0u, tree.Scan(100, 0, callback));
+    ASSERT_EQ(expected.size(), tree.Scan(-1, 10000, callback));
+}
+
+TEST(BPlusTree, TestStringKeyAndCompare)
+{
+    BPlusTree<string, string, greater<string>, 256> tree;
+    map<string, string, greater<string> > expected;
+    for (int i = 0; i < 5000; ++i)
+    {
+        ostringstream os;
+        os << rand() % 2000;
+        const string key = os.str();
+        if (rand() % 4 == 0)
+        {
+            ASSERT_EQ(expected.erase(key) > 0, tree.Delete(key));
+        }
+        else
+        {
+            ASSERT_EQ(expected.insert(make_pair(key, key + "v")).second,
+                      tree.Insert(key, key + "v"));
+        }
+    }
+    CheckEntries(tree, expected);
+}
+
+TEST(BPlusTree, TestAllocator)
+{
+    int node_num = 0;
+    {
+        const CountingAllocator<int> alloc(&node_num);
+        BPlusTree<int, int, less<int>, 96, CountingAllocator<int> > tree(less<int>(), alloc);
+        ASSERT_EQ(1, node_num);
+        for (int i = 0; i < 1000; ++i)
+        {
+            tree.Insert(i, i);
+        }
+        ASSERT_GT(node_num, 1000 / SmallBPlusTree::Leaf::MAX_KEY_NUM);
+        for (int i = 0; i < 1000; i += 2)
+        {
+            tree.Delete(i);
+        }
+        ASSERT_EQ(500u, tree.size());
+    }
+    ASSERT_EQ(0, node_num);
+
+    // the inner nodes come from copies of the leaf allocator
+    BPlusTree<int, int, less<int>, 512, PoolAllocator<int> > pool_tree;
+    map<int, int> expected;
+    for (int i = 0; i < 100000; ++i)
+    {
+        const int key = rand();
+        pool_tree.Insert(key, i);
+        expected.insert(make_pair(key, i));
+    }
+    for (int i = 0; i < 50000; ++i)
+    {
+        const int key = rand();
+        ASSERT_EQ(expected.erase(key) > 0, pool_tree.Delete(key));
+    }
+    CheckEntries(pool_tree, expected);
+}
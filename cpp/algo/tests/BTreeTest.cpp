@@ -14,19 +14,25 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <functional>
 
 using snippet::algo::BTree;
 
+typedef BTree<int, std::string> IntBTree;
+
 TEST(BTree, TestCtor)
 {
-    BTree btree(9);
+    IntBTree btree(9);
 
     ASSERT_EQ(static_cast<unsigned>(0), btree.GetSize());
 }
 
 TEST(BTree, TestInsert)
 {
-    BTree btree(9);
+    IntBTree btree(9);
 
     btree.Insert(1, "a");
 
@@ -52,7 +58,7 @@ public:
 TEST_P(BTreeValueTest, TestInsertWithLeave)
 {
     const int times = GetParam();
-    BTree btree(5);
+    IntBTree btree(5);
 
     for (int i = 0; i < times; ++i)
     {
@@ -69,7 +75,7 @@ TEST_P(BTreeValueTest, TestInsertWithLeave)
 TEST_P(BTreeValueTest, TestInsertWithReverseOrder)
 {
     const int times = GetParam();
-    BTree btree(5);
+    IntBTree btree(5);
 
     for (int i = times; i > 0; --i)
     {
@@ -105,7 +111,7 @@ namespace {
 TEST_P(BTreeValueTest, TestInsertWithRandomOrder)
 {
     const int times = GetParam();
-    BTree btree(5);
+    IntBTree btree(5);
 
     // generate a vector<int> with size times
     std::vector<int> numbers;
@@ -130,7 +136,7 @@ TEST_P(BTreeValueTest, TestInsertWithRandomOrder)
 
 TEST(BTree, TestFind)
 {
-    BTree btree(9);
+    IntBTree btree(9);
 
     btree.Insert(1, "a");
     btree.Insert(2, "b");
@@ -142,7 +148,7 @@ TEST(BTree, TestFind)
 
 TEST(BTree, TestFindWithEmptyTree)
 {
-    BTree btree(7);
+    IntBTree btree(7);
 
     ASSERT_FALSE(btree.Find(1, NULL, NULL));
     ASSERT_FALSE(btree.Find(2, NULL, NULL));
@@ -151,7 +157,7 @@ TEST(BTree, TestFindWithEmptyTree)
 
 TEST(BTree, TestDeleteInRoot)
 {
-    BTree btree(5);
+    IntBTree btree(5);
 
     btree.Insert(1, "a");
     ASSERT_EQ(static_cast<unsigned>(1), btree.GetSize());
@@ -164,7 +170,7 @@ TEST(BTree, TestDeleteInRoot)
 
 TEST(BTree, TestDeleteRoot2)
 {
-    BTree btree(5);
+    IntBTree btree(5);
 
     btree.Insert(1, "a");
     btree.Insert(2, "a");
@@ -180,7 +186,7 @@ TEST(BTree, TestDeleteRoot2)
 
 TEST(BTree, TestDeleteInLeaveSimple)
 {
-    BTree btree(5);
+    IntBTree btree(5);
 
     for (unsigned i = 0; i < 8; ++i)
     {
@@ -202,7 +208,7 @@ namespace {
 void DoTestDeleteElem(const unsigned times, const unsigned del_elem,
                       const bool is_reverse_insert = false)
 {
-    BTree btree(5);
+    IntBTree btree(5);
 
     if (is_reverse_insert)
     {
@@ -290,3 +296,579 @@ TEST(BTree, TestDeleteWithCase2c)
 {
     DoTestDeleteElem(21, 2);
 }
+
+namespace {
+
+template<typename Key, typename Value>
+struct CollectVisitor
+{
+    void operator()(const Key& key, const Value& value)
+    {
+        keys.push_back(key);
+        values.push_back(value);
+    }
+
+    std::vector<Key> keys;
+    std::vector<Value> values;
+};
+
+template<typename T>
+struct CountingAllocator : public std::allocator<T>
+{
+    typedef T value_type;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef CountingAllocator<Other> other;
+    };
+
+    explicit CountingAllocator(int* n) : node_num(n) {}
+
+    template<typename Other>
+    CountingAllocator(const CountingAllocator<Other>& other) : node_num(other.node_num) {}
+
+    T* allocate(std::size_t n)
+    {
+        *node_num += static_cast<int>(n);
+        return std::allocator<T>::allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        *node_num -= static_cast<int>(n);
+        std::allocator<T>::deallocate(p, n);
+    }
+
+    int* node_num;
+};
+
+}
+
+TEST(BTree, TestMaxKeyNum)
+{
+    typedef IntBTree::BTreeNode Node;
+    ASSERT_EQ(1u, Node::MAX_KEY_NUM % 2);
+    ASSERT_EQ(Node::MAX_KEY_NUM, IntBTree().GetMaxKeyNum());
+    ASSERT_EQ(Node::MAX_KEY_NUM, IntBTree(1000).GetMaxKeyNum());
+    ASSERT_EQ(3u, IntBTree(1).GetMaxKeyNum());
+    ASSERT_EQ(5u, IntBTree(5).GetMaxKeyNum());
+    ASSERT_EQ(5u, IntBTree(6).GetMaxKeyNum());
+    ASSERT_EQ(3u, (BTree<int, int, std::less<int>, 8>::BTreeNode::MAX_KEY_NUM));
+}
+
+TEST(BTree, TestFindValueAndDuplicate)
+{
+    IntBTree btree(5);
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(btree.Insert(i, VectorToString(std::vector<int>(1, i))));
+    }
+    ASSERT_FALSE(btree.Insert(10, "x"));
+    ASSERT_EQ(100u, btree.size());
+
+    std::string value;
+    ASSERT_TRUE(btree.Find(10, value));
+    ASSERT_EQ("10", value);
+    ASSERT_FALSE(btree.Find(100, value));
+
+    ASSERT_TRUE(btree.Delete(10));
+    ASSERT_FALSE(btree.Delete(10));
+    ASSERT_EQ(99u, btree.size());
+    ASSERT_FALSE(btree.Find(10, value));
+
+    btree.Clear();
+    ASSERT_TRUE(btree.empty());
+    ASSERT_EQ(0u, btree.GetSize());
+    ASSERT_TRUE(btree.Insert(1, "a"));
+}
+
+TEST(BTree, TestStringKeyAndCompare)
+{
+    BTree<std::string, int, std::greater<std::string> > btree(5);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 500; ++i)
+    {
+        keys.push_back(VectorToString(std::vector<int>(1, i)));
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        ASSERT_TRUE(btree.Insert(keys[i], static_cast<int>(i)));
+    }
+
+    CollectVisitor<std::string, int> visitor;
+    btree.ForEach(visitor);
+    std::sort(keys.begin(), keys.end(), std::greater<std::string>());
+    ASSERT_EQ(keys, visitor.keys);
+}
+
+TEST(BTree, TestRandomOperations)
+{
+    typedef BTree<long long, long long, std::less<long long>, 256> Int64BTree;
+    Int64BTree btree;
+    std::map<long long, long long> expected;
+    for (int i = 0; i < 100000; ++i)
+    {
+        const long long key = (static_cast<long long>(rand() % 5000) << 32) + 1;
+        if (rand() % 3 == 0)
+        {
+            ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+        }
+        else
+        {
+            ASSERT_EQ(expected.insert(std::make_pair(key, i)).second, btree.Insert(key, i));
+        }
+    }
+    ASSERT_EQ(expected.size(), btree.size());
+    ASSERT_EQ(expected.size(), btree.GetSize());
+
+    CollectVisitor<long long, long long> visitor;
+    btree.ForEach(visitor);
+    ASSERT_EQ(expected.size(), visitor.keys.size());
+    std::size_t i = 0;
+    for (std::map<long long, long long>::const_iterator it = expected.begin();
+         it != expected.end(); ++it, ++i)
+    {
+        ASSERT_EQ(it->first, visitor.keys[i]);
+        ASSERT_EQ(it->second, visitor.values[i]);
+    }
+}
+
+TEST(BTree, TestAllocator)
+{
+    int node_num = 0;
+    {
+        BTree<int, int, std::less<int>, 512, CountingAllocator<int> >
+                btree(5, std::less<int>(), CountingAllocator<int>(&node_num));
+        ASSERT_EQ(1, node_num);
+        for (int i = 0; i < 1000; ++i)
+        {
+            btree.Insert(i, i);
+        }
+        ASSERT_GT(node_num, 1000 / 5);
+        for (int i = 0; i < 1000; i += 2)
+        {
+            btree.Delete(i);
+        }
+        ASSERT_EQ(500u, btree.GetSize());
+    }
+    ASSERT_EQ(0, node_num);
+}
+
+// LowerBound of nodes of every key count against std::lower_bound, for
+// keys 0, 2, 4... sorted by compare and probes falling on and between them.
+template<typename Node>
+static void SetNodeValues(Node&, int*, snippet::algo::BTreePairLayout) {}
+
+template<typename Node>
+static void SetNodeValues(Node& node, int* values, snippet::algo::BTreeSplitLayout)
+{
+    node.SetValues(values);
+}
+
+template<typename Key, typename Compare, typename Layout>
+static void CheckNodeLowerBound(Key (*make_key)(int))
+{
+    typedef typename BTree<Key, int, Compare, 512, std::allocator<Key>, Layout>::BTreeNode Node;
+    const Compare compare = Compare();
+    for (unsigned key_num = 0; key_num <= Node::MAX_KEY_NUM; ++key_num)
+    {
+        std::vector<Key> keys;
+        for (unsigned i = 0; i < key_num; ++i)
+        {
+            keys.push_back(make_key(static_cast<int>(i * 2)));
+        }
+        std::sort(keys.begin(), keys.end(), compare);
+
+        Node node(Node::MAX_KEY_NUM);
+        std::vector<int> values(Node::MAX_KEY_NUM);
+        SetNodeValues(node, &values[0], typename Node::LayoutType());
+        for (unsigned i = 0; i < key_num; ++i)
+        {
+            node.SetItem(i, keys[i], static_cast<int>(i));
+        }
+        node.SetKeyNum(key_num);
+
+        for (int probe = -1; probe <= static_cast<int>(key_num * 2); ++probe)
+        {
+            const Key key = make_key(probe);
+            const std::size_t expected =
+                    std::lower_bound(keys.begin(), keys.end(), key, compare) - keys.begin();
+            ASSERT_EQ(expected, node.LowerBound(key, compare))
+                    << "key_num " << key_num << " probe " << probe;
+        }
+    }
+}
+
+template<typename Key>
+static Key MakeNumberKey(int i)
+{
+    return static_cast<Key>(i);
+}
+
+static std::string MakeStringKey(int i)
+{
+    std::ostringstream os;
+    os << i;
+    return os.str();
+}
+
+TEST(BTree, TestNodeLowerBound)
+{
+    using snippet::algo::BTreePairLayout;
+    using snippet::algo::BTreeSplitLayout;
+
+    // simdple compares
+    CheckNodeLowerBound<int, std::less<int>, BTreePairLayout>(&MakeNumberKey<int>);
+    CheckNodeLowerBound<int, std::less<int>, BTreeSplitLayout>(&MakeNumberKey<int>);
+    CheckNodeLowerBound<long long, std::less<long long>, BTreePairLayout>(
+            &MakeNumberKey<long long>);
+    CheckNodeLowerBound<long long, std::less<long long>, BTreeSplitLayout>(
+            &MakeNumberKey<long long>);
+    // branchless binary search
+    CheckNodeLowerBound<int, std::greater<int>, BTreePairLayout>(&MakeNumberKey<int>);
+    CheckNodeLowerBound<double, std::less<double>, BTreeSplitLayout>(&MakeNumberKey<double>);
+    // linear scan
+    CheckNodeLowerBound<std::string, std::less<std::string>, BTreePairLayout>(&MakeStringKey);
+    CheckNodeLowerBound<std::string, std::less<std::string>, BTreeSplitLayout>(&MakeStringKey);
+}
+
+TEST(BTree, TestSplitLayout)
+{
+    typedef BTree<long long, std::string, std::less<long long>, 512,
+                  CountingAllocator<long long>, snippet::algo::BTreeSplitLayout> SplitBTree;
+    typedef BTree<long long, std::string> PairBTree;
+    ASSERT_EQ(1u, SplitBTree::BTreeNode::MAX_KEY_NUM % 2);
+    ASSERT_GT(SplitBTree::BTreeNode::MAX_KEY_NUM, PairBTree::BTreeNode::MAX_KEY_NUM);
+
+    int alloc_num = 0;
+    {
+        SplitBTree btree(0, std::less<long long>(), CountingAllocator<long long>(&alloc_num));
+        std::map<long long, std::string> expected;
+        for (int i = 0; i < 20000; ++i)
+        {
+            const long long key = rand() % 3000;
+            if (rand() % 3 == 0)
+            {
+                ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+            }
+            else
+            {
+                const std::string value(static_cast<std::size_t>(i % 50), 'a' + i % 26);
+                ASSERT_EQ(expected.insert(std::make_pair(key, value)).second,
+                          btree.Insert(key, value));
+            }
+        }
+        ASSERT_EQ(expected.size(), btree.size());
+        ASSERT_EQ(expected.size(), btree.GetSize());
+
+        CollectVisitor<long long, std::string> visitor;
+        btree.ForEach(visitor);
+        std::size_t i = 0;
+        for (std::map<long long, std::string>::const_iterator it = expected.begin();
+             it != expected.end(); ++it, ++i)
+        {
+            ASSERT_EQ(it->first, visitor.keys[i]);
+            ASSERT_EQ(it->second, visitor.values[i]);
+            std::string value;
+            ASSERT_TRUE(btree.Find(it->first, value));
+            ASSERT_EQ(it->second, value);
+        }
+    }
+    // the nodes and their values
+    ASSERT_EQ(0, alloc_num);
+}
+
+TEST(BTree, TestSplitLayoutPoolAllocator)
+{
+    // the value arrays come from copies of the node allocator
+    typedef BTree<int, std::string, std::less<int>, 512,
+                  snippet::algo::PoolAllocator<int, 64>,
+                  snippet::algo::BTreeSplitLayout> SplitBTree;
+    SplitBTree btree(5);
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE(btree.Insert(i, "value"));
+    }
+    for (int i = 0; i < 1000; i += 2)
+    {
+        ASSERT_TRUE(btree.Delete(i));
+    }
+    ASSERT_EQ(500u, btree.size());
+}
+
+TEST(BTree, TestBulkLoad)
+{
+    typedef BTree<int, int, std::less<int>, 512, CountingAllocator<int> > CountingBTree;
+    const int key_nums[] = { 0, 1, 5, 6, 100, 1000, 30000 };
+    const double fill_factors[] = { 0.1, 0.5, 0.7, 1.0 };
+    for (std::size_t k = 0; k < sizeof(key_nums) / sizeof(key_nums[0]); ++k)
+    {
+        std::vector<std::pair<int, int> > items;
+        for (int i = 0; i < key_nums[k]; ++i)
+        {
+            items.push_back(std::make_pair(i * 2, i));
+        }
+
+        for (std::size_t f = 0; f < sizeof(fill_factors) / sizeof(fill_factors[0]); ++f)
+        {
+            int node_num = 0;
+            CountingBTree btree(5, std::less<int>(), CountingAllocator<int>(&node_num));
+            btree.Insert(-1, -1);
+            btree.BulkLoad(items.begin(), items.end(), fill_factors[f], 1 + k % 3);
+            ASSERT_EQ(items.size(), btree.size());
+            ASSERT_EQ(items.size(), btree.GetSize());
+            if (fill_factors[f] == 1.0 && !items.empty())
+            {
+                // full nodes but for the root and the last ones of a level
+                ASSERT_LE(node_num, key_nums[k] / 5 + 5);
+            }
+
+            CollectVisitor<int, int> visitor;
+            btree.ForEach(visitor);
+            ASSERT_EQ(items.size(), visitor.keys.size());
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                ASSERT_EQ(items[i].first, visitor.keys[i]);
+                ASSERT_EQ(items[i].second, visitor.values[i]);
+            }
+
+            // the nodes have between 2 and 5 keys, or Delete and Insert fail
+            std::map<int, int> expected(items.begin(), items.end());
+            for (int i = 0; i < key_nums[k] * 2; ++i)
+            {
+                const int key = rand() % (key_nums[k] * 2 + 2);
+                if (rand() % 2 == 0)
+                {
+                    ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+                }
+                else
+                {
+                    ASSERT_EQ(expected.insert(std::make_pair(key, i)).second,
+                              btree.Insert(key, i));
+                }
+            }
+            ASSERT_EQ(expected.size(), btree.GetSize());
+        }
+    }
+}
+
+namespace {
+
+// A value whose copies throw once countdown of them have been made.
+struct ThrowingValue
+{
+    ThrowingValue() : value(0) {}
+    explicit ThrowingValue(int v) : value(v) {}
+    ThrowingValue(const ThrowingValue& other) : value(other.value) { CountDown(); }
+
+    ThrowingValue& operator=(const ThrowingValue& other)
+    {
+        CountDown();
+        value = other.value;
+        return *this;
+    }
+
+    static void CountDown()
+    {
+        if (countdown > 0 && --countdown == 0)
+        {
+            throw std::runtime_error("copy");
+        }
+    }
+
+    int value;
+    static int countdown;
+};
+
+int ThrowingValue::countdown = 0;
+
+}
+
+TEST(BTree, TestBulkLoadThrows)
+{
+    typedef BTree<int, ThrowingValue, std::less<int>, 512,
+                  CountingAllocator<int> > ThrowingBTree;
+    std::vector<std::pair<int, ThrowingValue> > items;
+    for (int i = 0; i < 1000; ++i)
+    {
+        items.push_back(std::make_pair(i, ThrowingValue(i)));
+    }
+
+    // in the leaves, and in the level above them
+    const int countdowns[] = { 1, 500, 1100 };
+    for (std::size_t c = 0; c < sizeof(countdowns) / sizeof(countdowns[0]); ++c)
+    {
+        for (unsigned thread_num = 1; thread_num <= 2; ++thread_num)
+        {
+            int node_num = 0;
+            ThrowingBTree btree(5, std::less<int>(), CountingAllocator<int>(&node_num));
+            for (int i = 0; i < 100; ++i)
+            {
+                btree.Insert(-i, ThrowingValue(i));
+            }
+            const int old_node_num = node_num;
+
+            ThrowingValue::countdown = countdowns[c];
+            ASSERT_THROW(btree.BulkLoad(items.begin(), items.end(), 1.0, thread_num),
+                         std::runtime_error);
+            ThrowingValue::countdown = 0;
+
+            // the old entries are kept, and the new nodes are freed
+            ASSERT_EQ(old_node_num, node_num);
+            ASSERT_EQ(100u, btree.size());
+            ThrowingValue value;
+            ASSERT_TRUE(btree.Find(-99, value));
+            ASSERT_EQ(99, value.value);
+
+            btree.BulkLoad(items.begin(), items.end(), 1.0, thread_num);
+            ASSERT_EQ(1000u, btree.size());
+            ASSERT_FALSE(btree.Find(-99, value));
+            btree.Clear();
+            ASSERT_TRUE(btree.empty());
+        }
+    }
+}
+
+template<typename BTreeType>
+static void CheckPoolAllocator(typename BTreeType::KeyType (*make_key)(int))
+{
+    BTreeType btree(5);
+    std::map<typename BTreeType::KeyType, typename BTreeType::ValueType> expected;
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 3000; ++i)
+        {
+            const typename BTreeType::KeyType key = make_key(rand() % 1000);
+            if (rand() % 3 == 0)
+            {
+                ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+            }
+            else
+            {
+                ASSERT_EQ(expected.insert(std::make_pair(key, key)).second,
+                          btree.Insert(key, key));
+            }
+        }
+        ASSERT_EQ(expected.size(), btree.GetSize());
+
+        // every node is cache line aligned
+        for (typename std::map<typename BTreeType::KeyType,
+                               typename BTreeType::ValueType>::const_iterator it =
+                     expected.begin(); it != expected.end(); ++it)
+        {
+            typename BTreeType::BTreeNode* node = NULL;
+            int index = 0;
+            ASSERT_TRUE(btree.Find(it->first, &node, &index));
+            ASSERT_EQ(0u, reinterpret_cast<std::size_t>(node) % 64);
+            ASSERT_EQ(it->second, node->GetValue(static_cast<unsigned>(index)));
+        }
+
+        if (round == 1)
+        {
+            btree.Clear();
+            expected.clear();
+            ASSERT_TRUE(btree.empty());
+        }
+    }
+
+    // a freed node is handed out again
+    typename BTreeType::NodeAllocator& alloc = btree.GetNodeAllocator();
+    typename BTreeType::BTreeNode* node = alloc.allocate(1);
+    alloc.deallocate(node, 1);
+    ASSERT_EQ(node, alloc.allocate(1));
+    alloc.deallocate(node, 1);
+}
+
+TEST(BTree, TestPoolAllocator)
+{
+    using snippet::algo::PoolAllocator;
+
+    CheckPoolAllocator<BTree<int, int, std::less<int>, 512,
+                             PoolAllocator<int, 64> > >(&MakeNumberKey<int>);
+    // nodes to destroy before the pool is released
+    CheckPoolAllocator<BTree<std::string, std::string, std::less<std::string>, 512,
+                             PoolAllocator<std::string, 64> > >(&MakeStringKey);
+    CheckPoolAllocator<BTree<int, int, std::less<int>, 512,
+                             PoolAllocator<int, 64>,
+                             snippet::algo::BTreeSplitLayout> >(&MakeNumberKey<int>);
+}
+
+template<typename BTreeType>
+static void CheckOrderStatistics(const BTreeType& btree, const std::map<int, int>& expected)
+{
+    ASSERT_EQ(expected.size(), btree.size());
+    ASSERT_EQ(expected.size(), btree.GetSize());
+
+    std::size_t rank = 0;
+    for (std::map<int, int>::const_iterator it = expected.begin();
+         it != expected.end(); ++it, ++rank)
+    {
+        ASSERT_EQ(rank, btree.Rank(it->first));
+        // and between the keys
+        ASSERT_EQ(rank + 1, btree.Rank(it->first + 1));
+
+        int key = -1;
+        int value = -1;
+        ASSERT_TRUE(btree.Select(rank, &key, &value));
+        ASSERT_EQ(it->first, key);
+        ASSERT_EQ(it->second, value);
+    }
+    int key = -1;
+    int value = -1;
+    ASSERT_FALSE(btree.Select(expected.size(), &key, &value));
+    ASSERT_EQ(0u, btree.Rank(-1));
+    ASSERT_EQ(expected.size(), btree.Rank(1 << 30));
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const int from = rand() % 10000 - 100;
+        const int to = from + rand() % 3000 - 100;
+        const std::size_t count = from < to ?
+                std::distance(expected.lower_bound(from), expected.lower_bound(to)) : 0;
+        ASSERT_EQ(count, btree.CountRange(from, to));
+    }
+}
+
+TEST(BTree, TestRankAndSelect)
+{
+    typedef BTree<int, int> IntIntBTree;
+    IntIntBTree btree(5);
+    std::map<int, int> expected;
+    CheckOrderStatistics(btree, expected);
+
+    // odd keys only, so that key + 1 is never present
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int key = (rand() % 5000) * 2 + 1;
+        if (rand() % 3 == 0)
+        {
+            ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+        }
+        else
+        {
+            ASSERT_EQ(expected.insert(std::make_pair(key, i)).second, btree.Insert(key, i));
+        }
+
+        if (i % 2000 == 0)
+        {
+            CheckOrderStatistics(btree, expected);
+        }
+    }
+    CheckOrderStatistics(btree, expected);
+
+    std::vector<std::pair<int, int> > items(expected.begin(), expected.end());
+    btree.BulkLoad(items.begin(), items.end(), 0.7, 2);
+    CheckOrderStatistics(btree, expected);
+    for (std::size_t i = 0; i < items.size(); i += 2)
+    {
+        ASSERT_TRUE(btree.Delete(items[i].first));
+        expected.erase(items[i].first);
+    }
+    CheckOrderStatistics(btree, expected);
+
+    btree.Clear();
+    expected.clear();
+    CheckOrderStatistics(btree, expected);
+}
@@ -0,0 +1,132 @@
+#include "BackgroundRehashHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(BackgroundRehashHashMap, TestInsertFindDelete)
+{
+    BackgroundRehashHashMap<string, int> hash_map;
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.Insert("a", 1));
+    ASSERT_FALSE(hash_map.Insert("a", 2));
+    ASSERT_TRUE(hash_map.Insert("b", 2));
+    ASSERT_EQ(2, hash_map.size());
+
+    int value = 0;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ(1, value);
+
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+    ASSERT_TRUE(hash_map.Find("b", value));
+    ASSERT_EQ(2, value);
+}
+
+TEST(BackgroundRehashHashMap, TestRehash)
+{
+    BackgroundRehashHashMap<int, int> hash_map;
+    const std::size_t bucket_count = hash_map.GetBucketCount();
+
+    // the writes keep going while the table is rebuilt
+    for (int i = 0; i < 10000; ++i)
+    {
+        ASSERT_TRUE(hash_map.Insert(i, i));
+        if (i % 3 == 0)
+        {
+            ASSERT_TRUE(hash_map.Delete(i / 2));
+            ASSERT_TRUE(hash_map.Insert(i / 2, -i));
+        }
+    }
+    hash_map.WaitForRehash();
+    ASSERT_FALSE(hash_map.IsRehashing());
+    ASSERT_GT(hash_map.GetBucketCount(), bucket_count);
+    ASSERT_EQ(10000, hash_map.size());
+
+    std::vector<int> expected(10000);
+    for (int i = 0; i < 10000; ++i)
+    {
+        expected[i] = i;
+    }
+    for (int i = 0; i < 10000; i += 3)
+    {
+        expected[i / 2] = -i;
+    }
+    for (int i = 0; i < 10000; ++i)
+    {
+        int value = 0;
+        ASSERT_TRUE(hash_map.Find(i, value)) << i;
+        ASSERT_EQ(expected[i], value) << i;
+    }
+}
+
+namespace {
+
+typedef BackgroundRehashHashMap<int, int> IntMap;
+
+// Checks that every key inserted so far is found with its value.
+struct Reader
+{
+    Reader(const IntMap& m, const std::atomic<int>& n, const int t,
+           std::atomic<bool>& e)
+    : hash_map(m), inserted_num(n), total(t), has_error(e)
+    {}
+
+    void operator()()
+    {
+        int value = 0;
+        for (int done = 0; done < total; done = inserted_num.load())
+        {
+            for (int i = 0; i < done; i += 97)
+            {
+                if (!hash_map.Find(i, value) || value != i)
+                {
+                    has_error = true;
+                }
+            }
+        }
+    }
+
+    const IntMap& hash_map;
+    const std::atomic<int>& inserted_num;
+    const int total;
+    std::atomic<bool>& has_error;
+};
+
+}
+
+TEST(BackgroundRehashHashMap, TestConcurrentReaders)
+{
+    IntMap hash_map;
+    const int key_num = 200000;
+    std::atomic<int> inserted_num(0);
+    std::atomic<bool> has_error(false);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+    {
+        readers.push_back(std::thread(Reader(hash_map, inserted_num, key_num, has_error)));
+    }
+
+    for (int i = 0; i < key_num; ++i)
+    {
+        hash_map.Insert(i, i);
+        hash_map.Insert(key_num + i, i);
+        hash_map.Delete(key_num + i);
+        inserted_num.store(i + 1);
+    }
+    for (std::size_t t = 0; t < readers.size(); ++t)
+    {
+        readers[t].join();
+    }
+
+    ASSERT_FALSE(has_error.load());
+    ASSERT_EQ(static_cast<std::size_t>(key_num), hash_map.size());
+}
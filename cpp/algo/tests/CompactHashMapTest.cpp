@@ -0,0 +1,128 @@
+#include "CompactHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sstream>
+#include <type_traits>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(CompactHashMap, TestInsertFindDelete)
+{
+    CompactHashMap<string, string> hash_map;
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.Insert("a", "1"));
+    ASSERT_FALSE(hash_map.Insert("a", "2"));
+    ASSERT_TRUE(hash_map.Insert("b", "2"));
+    hash_map["c"] = "3";
+    ASSERT_EQ(3, hash_map.size());
+
+    string value;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ("1", value);
+    ASSERT_EQ("3", hash_map.Find("c").GetValue());
+    ASSERT_TRUE(hash_map.Find("d") == hash_map.end());
+
+    // "a" is not the last node, so "c" is moved into its place
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+    ASSERT_TRUE(hash_map.Find("c", value));
+    ASSERT_EQ("3", value);
+    ASSERT_EQ(2, hash_map.size());
+
+    hash_map.Clear();
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.begin() == hash_map.end());
+}
+
+template<typename Key>
+static Key MakeKey(int i);
+
+template<>
+int MakeKey<int>(int i)
+{
+    return i;
+}
+
+template<>
+string MakeKey<string>(int i)
+{
+    stringstream ss;
+    ss << i;
+    return ss.str();
+}
+
+template<typename Key>
+static void CheckRandomOperations()
+{
+    CompactHashMap<Key, int> hash_map;
+    map<Key, int> std_map;
+    const std::size_t bucket_count = hash_map.GetBucketCount();
+
+    srand(0);
+    for (int i = 0; i < 20000; ++i)
+    {
+        const Key key = MakeKey<Key>(rand() % 5000);
+        if (rand() % 4 == 0)
+        {
+            ASSERT_EQ(std_map.erase(key) > 0, hash_map.Delete(key));
+        }
+        else
+        {
+            hash_map[key] = i;
+            std_map[key] = i;
+        }
+    }
+    ASSERT_GT(hash_map.GetBucketCount(), bucket_count);
+    ASSERT_EQ(std_map.size(), hash_map.size());
+
+    const CompactHashMap<Key, int> copy(hash_map);
+    hash_map.Clear();
+    ASSERT_EQ(std_map.size(), copy.size());
+
+    std::size_t count = 0;
+    for (typename CompactHashMap<Key, int>::const_iterator it = copy.begin();
+         it != copy.end(); ++it)
+    {
+        ASSERT_EQ(std_map[it.GetKey()], it.GetValue());
+        ++count;
+    }
+    ASSERT_EQ(std_map.size(), count);
+
+    for (typename map<Key, int>::const_iterator it = std_map.begin();
+         it != std_map.end(); ++it)
+    {
+        int value = 0;
+        ASSERT_TRUE(copy.Find(it->first, value));
+        ASSERT_EQ(it->second, value);
+    }
+}
+
+TEST(CompactHashMap, TestRandomOperations)
+{
+    CheckRandomOperations<int>();
+    CheckRandomOperations<string>();
+}
+
+TEST(CompactHashMap, TestMemoryUsage)
+{
+    CompactHashMap<int, int> hash_map(1000);
+    ASSERT_EQ(16, sizeof(CompactHashMap<int, int>::Node));
+    // so that growing and copying the node array is a memcpy
+    ASSERT_TRUE((std::is_trivially_copyable<CompactHashMap<int, int>::Node>::value));
+    ASSERT_FALSE((std::is_trivially_copyable<CompactHashMap<string, int>::Node>::value));
+
+    const std::size_t memory_usage = hash_map.GetMemoryUsage();
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map.Insert(i, i);
+    }
+    // everything fits in the reserved arrays
+    ASSERT_EQ(memory_usage, hash_map.GetMemoryUsage());
+    ASSERT_LT(memory_usage, 1000 * 24);
+}
@@ -0,0 +1,246 @@
+#include "ConcurrentBTree.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+namespace {
+
+typedef ConcurrentBTree<int, int> IntBTree;
+
+struct CollectVisitor
+{
+    void operator()(int key, int value)
+    {
+        entries.push_back(make_pair(key, value));
+    }
+
+    vector<pair<int, int> > entries;
+};
+
+void CheckEntries(const IntBTree& btree, const map<int, int>& expected)
+{
+    ASSERT_EQ(expected.size(), btree.size());
+    CollectVisitor visitor;
+    btree.ForEach(visitor);
+    const vector<pair<int, int> > expected_entries(expected.begin(), expected.end());
+    ASSERT_EQ(expected_entries, visitor.entries);
+}
+
+// Inserts, updates and deletes the keys of its own, which are
+// key % thread_num == thread_index but not multiple of 3, and checks
+// them with Find.
+struct Writer
+{
+    Writer(IntBTree& b, const int i, const int n, const int k, atomic<bool>& e)
+    : btree(b), thread_index(i), thread_num(n), key_num(k), has_error(e)
+    {}
+
+    void operator()()
+    {
+        unsigned int seed = thread_index;
+        for (int i = 0; i < key_num * 4; ++i)
+        {
+            const int key = rand_r(&seed) % key_num / thread_num * thread_num + thread_index;
+            const int op = rand_r(&seed) % 4;
+            if (key % 3 == 0)
+            {
+                continue;
+            }
+
+            int value = 0;
+            const bool is_found = btree.Find(key, value);
+            if (is_found != (expected.count(key) > 0) ||
+                (is_found && value != expected[key]))
+            {
+                has_error = true;
+            }
+
+            if (op == 0)
+            {
+                if (btree.Delete(key) != (expected.erase(key) > 0))
+                {
+                    has_error = true;
+                }
+            }
+            else if (op == 1)
+            {
+                if (btree.Update(key, -i) != (expected.count(key) > 0))
+                {
+                    has_error = true;
+                }
+                if (expected.count(key) > 0)
+                {
+                    expected[key] = -i;
+                }
+            }
+            else if (btree.Insert(key, i) != expected.insert(make_pair(key, i)).second)
+            {
+                has_error = true;
+            }
+        }
+    }
+
+    IntBTree& btree;
+    const int thread_index;
+    const int thread_num;
+    const int key_num;
+    atomic<bool>& has_error;
+    map<int, int> expected;
+};
+
+// Keys multiple of 3 are never written, and must always be found.
+struct Reader
+{
+    Reader(const IntBTree& b, const int k, const atomic<bool>& d, atomic<bool>& e)
+    : btree(b), key_num(k), is_done(d), has_error(e)
+    {}
+
+    void operator()()
+    {
+        int value = 0;
+        while (!is_done.load())
+        {
+            for (int key = 0; key < key_num; key += 3 * 7)
+            {
+                if (!btree.Find(key, value) || value != key)
+                {
+                    has_error = true;
+                }
+            }
+        }
+    }
+
+    const IntBTree& btree;
+    const int key_num;
+    const atomic<bool>& is_done;
+    atomic<bool>& has_error;
+};
+
+}
+
+// max_key_num 5 for deep trees, with many splits and merges
+TEST(ConcurrentBTree, TestInsertFindUpdateDelete)
+{
+    IntBTree btree(5);
+    ASSERT_TRUE(btree.empty());
+    ASSERT_EQ(5u, btree.GetMaxKeyNum());
+
+    int value = 0;
+    ASSERT_FALSE(btree.Find(1, value));
+    ASSERT_FALSE(btree.Delete(1));
+    ASSERT_FALSE(btree.Update(1, 1));
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE(btree.Insert(i, i));
+    }
+    ASSERT_FALSE(btree.Insert(10, 0));
+    ASSERT_EQ(1000u, btree.size());
+    ASSERT_TRUE(btree.Find(10, value));
+    ASSERT_EQ(10, value);
+
+    ASSERT_TRUE(btree.Update(10, -10));
+    ASSERT_TRUE(btree.Find(10, value));
+    ASSERT_EQ(-10, value);
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        ASSERT_TRUE(btree.Delete(i));
+    }
+    ASSERT_FALSE(btree.Delete(10));
+    ASSERT_FALSE(btree.Find(10, value));
+    ASSERT_EQ(500u, btree.size());
+
+    for (int i = 999; i >= 0; i -= 2)
+    {
+        ASSERT_TRUE(btree.Delete(i));
+    }
+    ASSERT_TRUE(btree.empty());
+    ASSERT_TRUE(btree.Insert(1, 1));
+}
+
+TEST(ConcurrentBTree, TestRandomOperations)
+{
+    IntBTree btree(5);
+    map<int, int> expected;
+    srand(0);
+    for (int i = 0; i < 50000; ++i)
+    {
+        const int key = rand() % 3000;
+        const int op = rand() % 3;
+        if (op == 0)
+        {
+            ASSERT_EQ(expected.erase(key) > 0, btree.Delete(key));
+        }
+        else if (op == 1)
+        {
+            ASSERT_EQ(expected.count(key) > 0, btree.Update(key, -i));
+            if (expected.count(key) > 0)
+            {
+                expected[key] = -i;
+            }
+        }
+        else
+        {
+            ASSERT_EQ(expected.insert(make_pair(key, i)).second, btree.Insert(key, i));
+        }
+
+        if (i % 5000 == 0)
+        {
+            CheckEntries(btree, expected);
+        }
+    }
+    CheckEntries(btree, expected);
+}
+
+TEST(ConcurrentBTree, TestConcurrentWriters)
+{
+    const int key_num = 20000;
+    const int thread_num = 4;
+    IntBTree btree(5);
+    atomic<bool> has_error(false);
+    atomic<bool> is_done(false);
+
+    map<int, int> expected;
+    for (int key = 0; key < key_num; key += 3)
+    {
+        btree.Insert(key, key);
+        expected[key] = key;
+    }
+
+    vector<Writer> writers;
+    for (int t = 0; t < thread_num; ++t)
+    {
+        writers.push_back(Writer(btree, t, thread_num, key_num, has_error));
+    }
+
+    vector<thread> threads;
+    threads.push_back(thread(Reader(btree, key_num, is_done, has_error)));
+    for (int t = 0; t < thread_num; ++t)
+    {
+        threads.push_back(thread(std::ref(writers[t])));
+    }
+    for (int t = 1; t <= thread_num; ++t)
+    {
+        threads[t].join();
+    }
+    is_done = true;
+    threads[0].join();
+    ASSERT_FALSE(has_error.load());
+
+    for (int t = 0; t < thread_num; ++t)
+    {
+        expected.insert(writers[t].expected.begin(), writers[t].expected.end());
+    }
+    CheckEntries(btree, expected);
+}
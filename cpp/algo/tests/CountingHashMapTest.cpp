@@ -0,0 +1,105 @@
+#include "CountingHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(CountingHashMap, TestLocalCounter)
+{
+    CountingHashMap<string> counting_map(3);
+    {
+        CountingHashMap<string>::LocalCounter counter(counting_map);
+        counter.Add("a");
+        counter.Add("a");
+        counter.Add("b", 5);
+        ASSERT_EQ(0, counting_map.Get("a"));
+
+        // the third key reaches the threshold
+        counter.Add("c");
+        ASSERT_EQ(2, counting_map.Get("a"));
+        ASSERT_EQ(5, counting_map.Get("b"));
+        ASSERT_EQ(1, counting_map.Get("c"));
+
+        counter.Add("a");
+        counter.Flush();
+        ASSERT_EQ(3, counting_map.Get("a"));
+        counter.Add("d");
+    }
+    ASSERT_EQ(1, counting_map.Get("d"));
+    ASSERT_EQ(0, counting_map.Get("e"));
+    ASSERT_EQ(4, counting_map.size());
+
+    counting_map.Add("e", 2);
+    CountingHashMap<string>::MapType snapshot;
+    counting_map.GetSnapshot(&snapshot);
+    ASSERT_EQ(5, snapshot.size());
+    ASSERT_EQ(2, snapshot["e"]);
+
+    counting_map.Clear();
+    ASSERT_EQ(0, counting_map.size());
+}
+
+namespace {
+
+typedef CountingHashMap<int> IntCountingMap;
+
+struct CountingThread
+{
+    CountingThread(IntCountingMap& m, const int n)
+    : counting_map(m), key_num(n)
+    {}
+
+    void operator()()
+    {
+        IntCountingMap::LocalCounter counter(counting_map);
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int i = 0; i < key_num; ++i)
+            {
+                counter.Add(i % (round + 1));
+                counter.Add(i);
+            }
+        }
+    }
+
+    IntCountingMap& counting_map;
+    const int key_num;
+};
+
+}
+
+TEST(CountingHashMap, TestConcurrentCounting)
+{
+    IntCountingMap counting_map(100);
+    const int key_num = 1000;
+    const int thread_num = 4;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; ++t)
+    {
+        threads.push_back(std::thread(CountingThread(counting_map, key_num)));
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    std::vector<long long> expected(key_num, 0);
+    for (int round = 0; round < 10; ++round)
+    {
+        for (int i = 0; i < key_num; ++i)
+        {
+            expected[i % (round + 1)] += thread_num;
+            expected[i] += thread_num;
+        }
+    }
+    for (int i = 0; i < key_num; ++i)
+    {
+        ASSERT_EQ(expected[i], counting_map.Get(i)) << i;
+    }
+}
@@ -0,0 +1,179 @@
+#include "ExpiringHashMap.h"
+#include "TimerWheel.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+namespace {
+
+struct TimerElem
+{
+    TimerElem() : deadline(0), expired_at(0) {}
+
+    uint64_t deadline;
+    uint64_t expired_at;
+    ListNode list_node;
+};
+
+struct RecordExpire
+{
+    explicit RecordExpire(uint64_t& n) : now(n) {}
+
+    void operator()(TimerElem* elem)
+    {
+        elem->expired_at = now;
+    }
+
+    uint64_t& now;
+};
+
+}
+
+TEST(TimerWheel, TestExpireInOrder)
+{
+    TimerWheel<TimerElem> wheel;
+    // cover the root level, the first upper levels and the parking slot
+    const uint64_t deadlines[] = { 1, 2, 255, 256, 257, 1000, 16383, 16384,
+                                   70000, 1048577, (1ull << 33) + 5 };
+    const size_t elem_num = sizeof(deadlines) / sizeof(deadlines[0]);
+    vector<TimerElem> elems(elem_num);
+    for (size_t i = 0; i < elem_num; ++i)
+    {
+        elems[i].deadline = deadlines[i];
+        wheel.Add(&elems[i]);
+    }
+    ASSERT_EQ(elem_num, wheel.size());
+
+    uint64_t now = 0;
+    RecordExpire callback(now);
+    for (size_t i = 0; i < elem_num - 1; ++i)
+    {
+        now = deadlines[i] - 1;
+        ASSERT_EQ(0, wheel.Advance(now, callback)) << deadlines[i];
+        now = deadlines[i];
+        ASSERT_EQ(1, wheel.Advance(now, callback)) << deadlines[i];
+        ASSERT_EQ(deadlines[i], elems[i].expired_at);
+    }
+
+    now = deadlines[elem_num - 1];
+    ASSERT_EQ(1, wheel.Advance(now, callback));
+    ASSERT_EQ(now, elems[elem_num - 1].expired_at);
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, TestRemoveAndReschedule)
+{
+    TimerWheel<TimerElem> wheel(100);
+    TimerElem elem1, elem2;
+    elem1.deadline = 200;
+    elem2.deadline = 300;
+    wheel.Add(&elem1);
+    wheel.Add(&elem2);
+
+    wheel.Remove(&elem1);
+    wheel.Reschedule(&elem2, 5000);
+    ASSERT_EQ(1, wheel.size());
+
+    uint64_t now = 4999;
+    RecordExpire callback(now);
+    ASSERT_EQ(0, wheel.Advance(now, callback));
+    now = 5000;
+    ASSERT_EQ(1, wheel.Advance(now, callback));
+    ASSERT_EQ(5000, elem2.expired_at);
+    ASSERT_EQ(0, elem1.expired_at);
+}
+
+TEST(ExpiringHashMap, TestInsertAndFind)
+{
+    ExpiringHashMap<int, string> map;
+    ASSERT_TRUE(map.Insert(1, "a", 10));
+    ASSERT_FALSE(map.Insert(1, "b", 10));
+    ASSERT_EQ(1, map.size());
+
+    string value;
+    ASSERT_TRUE(map.Find(1, value));
+    ASSERT_EQ("a", value);
+    ASSERT_TRUE(map.Find(1, value, 9));
+    // stale but not ticked out yet
+    ASSERT_FALSE(map.Find(1, value, 10));
+    ASSERT_EQ(1, map.size());
+}
+
+TEST(ExpiringHashMap, TestTick)
+{
+    ExpiringHashMap<int, int> map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.Insert(i, i, static_cast<uint64_t>(i + 1));
+    }
+
+    ASSERT_EQ(500, map.Tick(500));
+    ASSERT_EQ(500, map.size());
+    int value = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i >= 500, map.Find(i, value)) << i;
+    }
+
+    ASSERT_EQ(500, map.Tick(100000));
+    ASSERT_TRUE(map.empty());
+}
+
+TEST(ExpiringHashMap, TestTouchAndDelete)
+{
+    ExpiringHashMap<string, int> map;
+    map.Insert("a", 1, 10);
+    map.Insert("b", 2, 10);
+
+    ASSERT_TRUE(map.Touch("a", 20));
+    ASSERT_TRUE(map.Delete("b"));
+    ASSERT_FALSE(map.Delete("b"));
+    ASSERT_FALSE(map.Touch("b", 20));
+
+    ASSERT_EQ(0, map.Tick(19));
+    ASSERT_EQ(1, map.size());
+    ASSERT_EQ(1, map.Tick(20));
+    ASSERT_TRUE(map.empty());
+}
+
+TEST(ExpiringHashMap, TestReplaceStale)
+{
+    ExpiringHashMap<int, int> map;
+    map.Insert(1, 1, 10);
+    map.Tick(5);
+
+    ASSERT_FALSE(map.Insert(1, 2, 20));
+    map.Tick(10);
+    ASSERT_TRUE(map.Insert(1, 2, 20));
+
+    int value = 0;
+    ASSERT_TRUE(map.Find(1, value));
+    ASSERT_EQ(2, value);
+    ASSERT_EQ(0, map.Tick(19));
+    ASSERT_EQ(1, map.Tick(20));
+}
+
+TEST(ExpiringHashMap, TestReplaceStaleBeforeTick)
+{
+    ExpiringHashMap<int, int> map;
+    map.Insert(1, 1, 10);
+
+    int value = 0;
+    ASSERT_FALSE(map.Find(1, value, 10));
+    ASSERT_FALSE(map.Touch(1, 30, 10));
+    ASSERT_FALSE(map.Insert(1, 2, 20, 9));
+    ASSERT_TRUE(map.Insert(1, 2, 20, 10));
+    ASSERT_TRUE(map.Find(1, value, 10));
+    ASSERT_EQ(2, value);
+    ASSERT_TRUE(map.Touch(1, 30, 10));
+
+    ASSERT_EQ(0, map.Tick(29));
+    ASSERT_EQ(1, map.Tick(30));
+    ASSERT_TRUE(map.empty());
+}
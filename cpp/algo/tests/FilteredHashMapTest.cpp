@@ -0,0 +1,99 @@
+#include "FilteredHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(BlockedBloomFilter, TestFalsePositiveRate)
+{
+    BlockedBloomFilter filter(100000);
+    ASSERT_GE(filter.GetCapacity(), 100000);
+    for (std::size_t i = 0; i < 100000; ++i)
+    {
+        filter.Add(i);
+    }
+    for (std::size_t i = 0; i < 100000; ++i)
+    {
+        ASSERT_TRUE(filter.MayContain(i)) << i;
+    }
+
+    int false_positive_num = 0;
+    for (std::size_t i = 100000; i < 200000; ++i)
+    {
+        if (filter.MayContain(i))
+        {
+            ++false_positive_num;
+        }
+    }
+    ASSERT_LT(false_positive_num, 3000);
+
+    filter.Clear();
+    ASSERT_FALSE(filter.MayContain(0));
+}
+
+TEST(FilteredHashMap, TestInsertFindDelete)
+{
+    FilteredHashMap<string, int> hash_map;
+    ASSERT_TRUE(hash_map.Insert("a", 1));
+    ASSERT_FALSE(hash_map.Insert("a", 2));
+    hash_map["b"] = 2;
+    ASSERT_EQ(2, hash_map.size());
+
+    int value = 0;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ(1, value);
+    ASSERT_EQ(2, hash_map.Find("b").GetValue());
+    ASSERT_FALSE(hash_map.Find("c", value));
+    ASSERT_TRUE(hash_map.Find("c") == hash_map.end());
+
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+
+    hash_map.Clear();
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_FALSE(hash_map.Find("b", value));
+}
+
+TEST(FilteredHashMap, TestFilterFollowsRehash)
+{
+    FilteredHashMap<int, int> hash_map;
+    for (int i = 0; i < 100000; ++i)
+    {
+        ASSERT_TRUE(hash_map.Insert(i, i));
+    }
+    ASSERT_GE(hash_map.GetFilter().GetCapacity(), hash_map.GetBucketCount());
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(hash_map.Find(i, value));
+        ASSERT_EQ(i, value);
+    }
+
+    // the filter is rebuilt after the 50001st delete, dropping the
+    // keys deleted so far
+    for (int i = 0; i < 60000; ++i)
+    {
+        ASSERT_TRUE(hash_map.Delete(i));
+    }
+    int false_positive_num = 0;
+    for (int i = 0; i <= 50000; ++i)
+    {
+        if (hash_map.GetFilter().MayContain(DefaultHashMapHashPolicy<int>::DoHash(i)))
+        {
+            ++false_positive_num;
+        }
+    }
+    ASSERT_LT(false_positive_num, 3000);
+
+    hash_map.Rehash(hash_map.GetBucketCount() * 4);
+    for (int i = 0; i < 100000; ++i)
+    {
+        int value = -1;
+        ASSERT_EQ(i >= 60000, hash_map.Find(i, value));
+    }
+}
@@ -0,0 +1,69 @@
+#include "GroupByAggregator.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(GroupByAggregator, TestReducers)
+{
+    GroupByAggregator<string, SumReducer<int> > sum;
+    GroupByAggregator<string, CountReducer<int> > count;
+    GroupByAggregator<string, MinReducer<int> > min;
+    GroupByAggregator<string, MaxReducer<int> > max;
+    GroupByAggregator<string, AvgReducer<int> > avg;
+    const char* keys[] = { "a", "b", "a", "c", "a", "b" };
+    const int inputs[] = { 3, -1, 5, 7, -2, 4 };
+    for (int i = 0; i < 6; ++i)
+    {
+        sum.Add(keys[i], inputs[i]);
+        count.Add(keys[i], inputs[i]);
+        min.Add(keys[i], inputs[i]);
+        max.Add(keys[i], inputs[i]);
+        avg.Add(keys[i], inputs[i]);
+    }
+    ASSERT_EQ(3, sum.size());
+
+    int value = 0;
+    ASSERT_TRUE(sum.Find("a", value));
+    ASSERT_EQ(6, value);
+    ASSERT_TRUE(min.Find("a", value));
+    ASSERT_EQ(-2, value);
+    ASSERT_TRUE(max.Find("b", value));
+    ASSERT_EQ(4, value);
+    ASSERT_FALSE(max.Find("d", value));
+
+    std::size_t group_count = 0;
+    ASSERT_TRUE(count.Find("b", group_count));
+    ASSERT_EQ(2, group_count);
+
+    AvgState<int> avg_state;
+    ASSERT_TRUE(avg.Find("b", avg_state));
+    ASSERT_DOUBLE_EQ(1.5, avg_state.GetAverage());
+}
+
+TEST(GroupByAggregator, TestMerge)
+{
+    GroupByAggregator<int, SumReducer<long long> > partials[2];
+    vector<int> keys;
+    vector<long long> inputs;
+    for (int i = 0; i < 10000; ++i)
+    {
+        keys.push_back(i % 100);
+        inputs.push_back(i);
+    }
+    partials[0].Add(&keys[0], &inputs[0], 5000);
+    partials[1].Add(&keys[5000], &inputs[5000], 5000);
+
+    partials[0].Merge(partials[1]);
+    ASSERT_TRUE(partials[1].empty());
+    ASSERT_EQ(100, partials[0].size());
+    for (GroupByAggregator<int, SumReducer<long long> >::const_iterator it =
+             partials[0].begin(); it != partials[0].end(); ++it)
+    {
+        // 100 inputs key + 100 * j for j in [0, 100)
+        ASSERT_EQ(100LL * it.GetKey() + 100LL * 99 * 100 / 2, it.GetValue());
+    }
+}
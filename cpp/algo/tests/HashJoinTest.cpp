@@ -0,0 +1,110 @@
+#include "HashJoin.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+namespace {
+
+struct CollectMatches
+{
+    void operator()(std::size_t i, int value)
+    {
+        matches.push_back(make_pair(i, value));
+    }
+
+    vector<pair<std::size_t, int> > matches;
+};
+
+}
+
+TEST(HashJoin, TestFindBatch)
+{
+    HashMap<int, int> hash_map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map[i * 2] = i;
+    }
+
+    vector<int> keys;
+    for (int i = 0; i < 100; ++i)
+    {
+        keys.push_back(i);
+    }
+    CollectMatches collect;
+    hash_map.FindBatch(&keys[0], keys.size(), collect);
+    ASSERT_EQ(50, collect.matches.size());
+    for (std::size_t i = 0; i < collect.matches.size(); ++i)
+    {
+        ASSERT_EQ(i * 2, collect.matches[i].first);
+        ASSERT_EQ(static_cast<int>(i), collect.matches[i].second);
+    }
+}
+
+TEST(HashJoin, TestProbe)
+{
+    // small partitions so that the build is radix partitioned
+    HashJoinTable<int, int> join_table(10000, 4096);
+    ASSERT_GT(join_table.GetPartitionNum(), 1);
+    for (int i = 0; i < 10000; ++i)
+    {
+        join_table.Add(i * 3, i);
+    }
+    join_table.Add(0, 1);
+    ASSERT_TRUE(join_table.empty());
+    join_table.Build();
+    ASSERT_EQ(10000, join_table.size());
+
+    std::size_t max_partition_size = 0;
+    for (std::size_t i = 0; i < join_table.GetPartitionNum(); ++i)
+    {
+        max_partition_size = max(max_partition_size, join_table.GetPartition(i).size());
+    }
+    ASSERT_LT(max_partition_size, 10000 / join_table.GetPartitionNum() * 2);
+
+    // the first tuple of a key is kept
+    int value = -1;
+    ASSERT_TRUE(join_table.Find(0, value));
+    ASSERT_EQ(0, value);
+    ASSERT_TRUE(join_table.Find(300, value));
+    ASSERT_EQ(100, value);
+    ASSERT_FALSE(join_table.Find(301, value));
+
+    vector<int> probe_keys;
+    for (int i = 0; i < 30000; ++i)
+    {
+        probe_keys.push_back(29999 - i);
+    }
+    CollectMatches collect;
+    ASSERT_EQ(10000, join_table.Probe(&probe_keys[0], probe_keys.size(), collect));
+
+    map<std::size_t, int> matches(collect.matches.begin(), collect.matches.end());
+    ASSERT_EQ(10000, matches.size());
+    for (map<std::size_t, int>::const_iterator it = matches.begin();
+         it != matches.end(); ++it)
+    {
+        ASSERT_EQ(probe_keys[it->first], it->second * 3);
+    }
+
+    // too small a batch to be partitioned
+    CollectMatches small_collect;
+    ASSERT_EQ(33, join_table.Probe(&probe_keys[0], 100, small_collect));
+    for (std::size_t i = 0; i < small_collect.matches.size(); ++i)
+    {
+        ASSERT_EQ(probe_keys[small_collect.matches[i].first],
+                  small_collect.matches[i].second * 3);
+    }
+
+    join_table.Clear();
+    ASSERT_TRUE(join_table.empty());
+    ASSERT_EQ(0, join_table.Probe(&probe_keys[0], probe_keys.size(), collect));
+
+    // Probe() builds the tuples added since
+    join_table.Add(3, 1);
+    ASSERT_EQ(1, join_table.Probe(&probe_keys[0], probe_keys.size(), collect));
+}
@@ -1,4 +1,7 @@
 #include "HashMap.h"
+#include "HugePageAllocator.h"
+#include "ParallelHashMap.h"
+#include "PoolAllocator.h"
 
 #include <gtest/gtest.h>
 
@@ -10,6 +13,8 @@
 #include <map>
 #include <sstream>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 using snippet::algo::HashMap;
 using namespace snippet::algo;
@@ -76,6 +81,35 @@ TEST(HashMap, TestFind)
     }
 }
 
+TEST(HashMap, TestFindWithHash)
+{
+    HashMap<string, int> hash_map;
+    HashMap<string, int, DefaultKeyEqual<string>, DefaultHashMapHashPolicy<string>,
+            DefaultHashMapRehashPolicy, std::allocator<string>, false> uncached_map;
+    for (int i = 0; i < 100; ++i)
+    {
+        stringstream ss;
+        ss << i;
+        hash_map[ss.str()] = i;
+        uncached_map[ss.str()] = i;
+    }
+
+    for (HashMap<string, int>::const_iterator it = hash_map.begin();
+         it != hash_map.end(); ++it)
+    {
+        const std::size_t hash_code = Hash(it.GetKey());
+        ASSERT_EQ(hash_code, hash_map.GetHashCode(it));
+        ASSERT_EQ(hash_code, uncached_map.GetHashCode(uncached_map.Find(it.GetKey())));
+
+        int value = -1;
+        ASSERT_TRUE(hash_map.FindWithHash(it.GetKey(), hash_code, value));
+        ASSERT_EQ(it.GetValue(), value);
+        ASSERT_TRUE(hash_map.FindWithHash(it.GetKey(), hash_code) == it);
+    }
+    const string absent = "x";
+    ASSERT_TRUE(hash_map.FindWithHash(absent, Hash(absent)) == hash_map.end());
+}
+
 TEST(HashMap, TestInsert)
 {
     HashMap<int, int> hash_map;
@@ -387,6 +421,7 @@ struct MemRecordAllocator
         typedef MemRecordAllocator<Other> other;
     };
 
+    typedef T value_type;
     typedef T Elem;
 
     MemRecordAllocator() : allocated_bytes(0) {}
@@ -466,3 +501,709 @@ TEST(HashMap, TestNotCachedHash)
 
 
 
+
+TEST(HashMap, TestHugePageAllocator)
+{
+    typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                    DefaultHashMapRehashPolicy, HugePageAllocator<int> > HugePageHashMap;
+
+    // a small threshold so that the bucket array gets mapped
+    HugePageHashMap hash_map(static_cast<std::size_t>(0),
+                             HugePageHashMap::key_equal(),
+                             HugePageHashMap::hash_policy(),
+                             HugePageHashMap::rehash_policy(),
+                             HugePageHashMap::NodeAllocator(NUMA_DEFAULT, 0, 4096),
+                             HugePageHashMap::BucketAllocator(NUMA_INTERLEAVE, 0, 4096));
+    for (int i = 0; i < 10000; ++i)
+    {
+        hash_map[i] = i;
+    }
+    ASSERT_GT(hash_map.GetBucketCount() * sizeof(HugePageHashMap::Node*),
+              hash_map.GetBucketAllocator().GetThreshold());
+
+    HugePageHashMap hash_map2(hash_map);
+    for (int i = 0; i < 10000; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(hash_map2.Find(i, value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_EQ(NUMA_INTERLEAVE, hash_map2.GetBucketAllocator().GetNumaPolicy());
+}
+
+TEST(HashMap, TestHugePageAllocatorBadNumaNode)
+{
+    ASSERT_THROW(HugePageAllocator<int>(NUMA_BIND, -1), std::invalid_argument);
+    ASSERT_THROW(HugePageAllocator<int>(NUMA_BIND, 64), std::invalid_argument);
+    HugePageAllocator<int> alloc(NUMA_BIND, 63);
+    ASSERT_EQ(63, alloc.GetNumaNode());
+}
+
+namespace {
+
+template<typename HashMapType>
+void DoTestParallelRehashAndCopy()
+{
+    const int node_num = 4 * ParallelHashMapRehashPolicy::MIN_NODES_PER_THREAD + 7;
+    HashMapType hash_map(static_cast<std::size_t>(0), typename HashMapType::key_equal(),
+                         typename HashMapType::hash_policy(),
+                         ParallelHashMapRehashPolicy(2, 4));
+    for (int i = 0; i < node_num; ++i)
+    {
+        hash_map[i] = i;
+    }
+    ASSERT_EQ(4u, ParallelHashMapRehashPolicy(2, 4).GetThreadNum(hash_map.size()));
+    ASSERT_EQ(1u, ParallelHashMapRehashPolicy(2, 4).GetThreadNum(
+                          2 * ParallelHashMapRehashPolicy::MIN_NODES_PER_THREAD - 1));
+    ASSERT_EQ(2u, ParallelHashMapRehashPolicy(2, 4).GetThreadNum(
+                          2 * ParallelHashMapRehashPolicy::MIN_NODES_PER_THREAD));
+
+    // shrink and grow again with several threads
+    hash_map.Rehash(hash_map.GetBucketCount() / 4);
+    hash_map.Rehash(hash_map.GetBucketCount() * 8);
+
+    HashMapType hash_map2(hash_map);
+    ASSERT_EQ(static_cast<std::size_t>(node_num), hash_map.size());
+    ASSERT_EQ(static_cast<std::size_t>(node_num), hash_map2.size());
+    for (int i = 0; i < node_num; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(hash_map.Find(i, value));
+        ASSERT_EQ(i, value);
+        ASSERT_TRUE(hash_map2.Find(i, value));
+        ASSERT_EQ(i, value);
+    }
+
+    std::size_t iter_count = 0;
+    for (typename HashMapType::const_iterator it = hash_map2.begin();
+         it != hash_map2.end(); ++it)
+    {
+        ++iter_count;
+    }
+    ASSERT_EQ(hash_map2.size(), iter_count);
+}
+
+}
+
+TEST(HashMap, TestParallelRehashAndCopy)
+{
+    DoTestParallelRehashAndCopy<HashMap<int, int, DefaultKeyEqual<int>,
+                                        DefaultHashMapHashPolicy<int>,
+                                        ParallelHashMapRehashPolicy> >();
+    DoTestParallelRehashAndCopy<HashMap<int, int, DefaultKeyEqual<int>,
+                                        DefaultHashMapHashPolicy<int>,
+                                        ParallelHashMapRehashPolicy,
+                                        std::allocator<int>, false> >();
+    DoTestParallelRehashAndCopy<HashMap<int, int, DefaultKeyEqual<int>,
+                                        DefaultHashMapHashPolicy<int>,
+                                        ParallelHashMapRehashPolicy,
+                                        PoolAllocator<int> > >();
+}
+
+namespace {
+
+struct ThrowingTask
+{
+    explicit ThrowingTask(unsigned int n) : done(n, 0) {}
+
+    void operator()(const unsigned int i)
+    {
+        done[i] = 1;
+        if (i % 2 == 1)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    std::vector<int> done;
+};
+
+}
+
+TEST(HashMap, TestRunInParallelRethrows)
+{
+    ThrowingTask task(4);
+    ASSERT_THROW(RunInParallel(4, task), std::bad_alloc);
+    // every task has run before the exception gets to the caller
+    ASSERT_EQ(std::vector<int>(4, 1), task.done);
+}
+
+namespace {
+
+struct TrivialStruct
+{
+    int a;
+    double b;
+};
+
+}
+
+TEST(HashMap, TestTypeTrait)
+{
+    ASSERT_TRUE(IsTriviallyDestructible<int>::Result);
+    ASSERT_TRUE(IsTriviallyDestructible<const char*>::Result);
+    ASSERT_TRUE((IsTriviallyDestructible<std::pair<int, double> >::Result));
+    ASSERT_FALSE(IsTriviallyDestructible<string>::Result);
+    ASSERT_FALSE((IsTriviallyDestructible<std::pair<int, string> >::Result));
+    ASSERT_TRUE(IsTriviallyDestructible<TrivialStruct>::Result);
+    ASSERT_TRUE(IsTriviallyDestructible<int[4]>::Result);
+    ASSERT_FALSE(IsTriviallyDestructible<string[4]>::Result);
+
+    ASSERT_FALSE(IsBulkReleaseAllocator<std::allocator<int> >::Result);
+    ASSERT_TRUE(IsBulkReleaseAllocator<PoolAllocator<int> >::Result);
+}
+
+namespace {
+
+template<typename HashMapType, typename T>
+void DoTestPoolAllocator(T (*make_value)(int))
+{
+    HashMapType hash_map(static_cast<std::size_t>(0), typename HashMapType::key_equal(),
+                         typename HashMapType::hash_policy(),
+                         typename HashMapType::rehash_policy(),
+                         typename HashMapType::NodeAllocator(16));
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT_TRUE(hash_map.Insert(make_value(i), make_value(i + 1)));
+        }
+        for (int i = 0; i < 1000; i += 3)
+        {
+            ASSERT_TRUE(hash_map.Delete(make_value(i)));
+        }
+
+        // the copy has its own pool
+        HashMapType hash_map2(hash_map);
+        hash_map.Clear();
+        ASSERT_TRUE(hash_map.empty());
+        ASSERT_EQ(666, hash_map2.size());
+        for (int i = 0; i < 1000; ++i)
+        {
+            T value;
+            ASSERT_EQ(i % 3 != 0, hash_map2.Find(make_value(i), value));
+            if (i % 3 != 0)
+            {
+                ASSERT_EQ(make_value(i + 1), value);
+            }
+        }
+        ASSERT_TRUE(hash_map2.Insert(make_value(0), make_value(1)));
+        ASSERT_TRUE(hash_map2.Delete(make_value(1)));
+    }
+}
+
+int MakeInt(int i)
+{
+    return i;
+}
+
+string MakeString(int i)
+{
+    stringstream ss;
+    ss << i;
+    return ss.str();
+}
+
+}
+
+TEST(HashMap, TestPoolAllocator)
+{
+    DoTestPoolAllocator<HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                                DefaultHashMapRehashPolicy, PoolAllocator<int> > >(MakeInt);
+    DoTestPoolAllocator<HashMap<string, string, DefaultKeyEqual<string>,
+                                DefaultHashMapHashPolicy<string>,
+                                DefaultHashMapRehashPolicy, PoolAllocator<string> > >(MakeString);
+}
+
+TEST(HashMap, TestPoolAllocatorCopies)
+{
+    // the copies, rebound ones included, share the pool
+    PoolAllocator<int, 64> alloc(16);
+    PoolAllocator<int, 64> copy(alloc);
+    PoolAllocator<double, 64> rebound(alloc);
+    ASSERT_TRUE(copy == alloc);
+    ASSERT_TRUE(rebound == alloc);
+    ASSERT_TRUE((PoolAllocator<int, 64>(rebound) == alloc));
+    ASSERT_FALSE((PoolAllocator<int, 64>(16) == alloc));
+    ASSERT_FALSE(alloc.select_on_container_copy_construction() == alloc);
+    ASSERT_TRUE(alloc.IsPoolShared());
+
+    int* p = alloc.allocate(1);
+    ASSERT_EQ(0u, reinterpret_cast<std::size_t>(p) % 64);
+    copy.deallocate(p, 1);
+    ASSERT_EQ(p, alloc.allocate(1));
+    alloc.deallocate(p, 1);
+
+    // arrays are aligned too
+    double* array = rebound.allocate(10);
+    ASSERT_EQ(0u, reinterpret_cast<std::size_t>(array) % 64);
+    rebound.deallocate(array, 10);
+
+    // the moved map takes the nodes, which outlive the moved-from map
+    typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                    DefaultHashMapRehashPolicy, PoolAllocator<int> > PoolHashMap;
+    PoolHashMap* moved = new PoolHashMap();
+    for (int i = 0; i < 1000; ++i)
+    {
+        (*moved)[i] = i;
+    }
+    PoolHashMap hash_map(std::move(*moved));
+    ASSERT_TRUE(hash_map.GetNodeAllocator() == moved->GetNodeAllocator());
+    moved->Clear();
+    delete moved;
+    ASSERT_EQ(1000u, hash_map.size());
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i, hash_map[i]);
+    }
+}
+
+namespace {
+
+struct AddValue
+{
+    void operator()(int& value, int other_value) const
+    {
+        value += other_value;
+    }
+};
+
+}
+
+TEST(HashMap, TestMerge)
+{
+    HashMap<int, int> hash_map;
+    HashMap<int, int> other;
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map[i] = i;
+        other[i + 500] = 1;
+    }
+
+    // the common keys stay in other
+    hash_map.Merge(other);
+    ASSERT_EQ(1500, hash_map.size());
+    ASSERT_EQ(500, other.size());
+    for (int i = 0; i < 1500; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(hash_map.Find(i, value));
+        ASSERT_EQ(i < 1000 ? i : 1, value);
+        ASSERT_EQ(i >= 500 && i < 1000, other.Find(i) != other.end());
+    }
+
+    hash_map.Merge(other, AddValue());
+    ASSERT_TRUE(other.empty());
+    ASSERT_TRUE(other.begin() == other.end());
+    ASSERT_EQ(1500, hash_map.size());
+    for (int i = 500; i < 1000; ++i)
+    {
+        ASSERT_EQ(i + 1, hash_map[i]);
+    }
+
+    hash_map.Merge(hash_map, AddValue());
+    ASSERT_EQ(1500, hash_map.size());
+}
+
+TEST(HashMap, TestMergeWithPoolAllocator)
+{
+    // the pools differ, so the nodes are copied
+    typedef HashMap<string, int, DefaultKeyEqual<string>, DefaultHashMapHashPolicy<string>,
+                    DefaultHashMapRehashPolicy, PoolAllocator<string> > PoolHashMap;
+    PoolHashMap hash_map;
+    {
+        PoolHashMap other;
+        for (int i = 0; i < 100; ++i)
+        {
+            stringstream ss;
+            ss << i;
+            hash_map[ss.str()] = i;
+            other[ss.str() + "x"] = i;
+        }
+        hash_map.Merge(other, AddValue());
+        ASSERT_TRUE(other.empty());
+    }
+    ASSERT_EQ(200, hash_map.size());
+    ASSERT_EQ(99, hash_map["99x"]);
+}
+
+TEST(HashMap, TestIntersectAndDifference)
+{
+    HashMap<int, int> small_map;
+    HashMap<int, int> large_map;
+    for (int i = 0; i < 100; ++i)
+    {
+        small_map[i * 3] = i;
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        large_map[i * 2] = i;
+    }
+
+    HashMap<int, int> small_copy(small_map);
+    HashMap<int, int> large_copy(large_map);
+    small_copy.Intersect(large_map);
+    large_copy.Intersect(small_map);
+    ASSERT_EQ(50, small_copy.size());
+    ASSERT_EQ(50, large_copy.size());
+    for (int i = 0; i < 300; i += 6)
+    {
+        ASSERT_EQ(i / 3, small_copy[i]);
+        ASSERT_EQ(i / 2, large_copy[i]);
+    }
+    ASSERT_EQ(50, small_copy.size());
+    ASSERT_EQ(50, large_copy.size());
+
+    HashMap<int, int> small_copy2(small_map);
+    HashMap<int, int> large_copy2(large_map);
+    small_copy2.Difference(large_map);
+    large_copy2.Difference(small_map);
+    ASSERT_EQ(50, small_copy2.size());
+    ASSERT_EQ(950, large_copy2.size());
+    for (int i = 0; i < 300; i += 6)
+    {
+        ASSERT_TRUE(small_copy2.Find(i) == small_copy2.end());
+        ASSERT_TRUE(large_copy2.Find(i) == large_copy2.end());
+        ASSERT_TRUE(small_copy2.Find(i + 3) != small_copy2.end());
+    }
+
+    large_copy2.Difference(large_copy2);
+    ASSERT_TRUE(large_copy2.empty());
+}
+
+TEST(HashMap, TestErase)
+{
+    HashMap<int, string> hash_map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map[i] = "a";
+    }
+
+    // erase the odd keys while iterating
+    int visited = 0;
+    for (HashMap<int, string>::iterator it = hash_map.begin(); it != hash_map.end(); )
+    {
+        ++visited;
+        if (it.GetKey() % 2 == 1)
+        {
+            it = hash_map.Erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    ASSERT_EQ(1000, visited);
+    ASSERT_EQ(500, hash_map.size());
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i % 2 == 0, hash_map.Find(i) != hash_map.end());
+    }
+
+    HashMap<int, string>::iterator it = hash_map.Find(10);
+    hash_map.Erase(it);
+    ASSERT_TRUE(hash_map.Find(10) == hash_map.end());
+    ASSERT_EQ(499, hash_map.size());
+}
+
+struct IsValueLess
+{
+    explicit IsValueLess(int v) : value(v) {}
+
+    bool operator()(const string&, int v) const
+    {
+        return v < value;
+    }
+
+    int value;
+};
+
+TEST(HashMap, TestEraseIf)
+{
+    HashMap<string, int> hash_map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map[MakeString(i)] = i;
+    }
+    const std::size_t bucket_count = hash_map.GetBucketCount();
+
+    ASSERT_EQ(300, hash_map.EraseIf(IsValueLess(300)));
+    ASSERT_EQ(700, hash_map.size());
+    ASSERT_EQ(bucket_count, hash_map.GetBucketCount());
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i >= 300, hash_map.Find(MakeString(i)) != hash_map.end());
+    }
+    ASSERT_EQ(0, hash_map.EraseIf(IsValueLess(300)));
+
+    typedef HashMap<string, int, DefaultKeyEqual<string>, DefaultHashMapHashPolicy<string>,
+                    DefaultHashMapRehashPolicy, PoolAllocator<string> > PoolHashMap;
+    PoolHashMap pool_map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        pool_map[MakeString(i)] = i;
+    }
+    ASSERT_EQ(500, pool_map.EraseIf(IsValueLess(500)));
+    ASSERT_EQ(500, pool_map.size());
+    // the last ones are released with the pool
+    ASSERT_EQ(500, pool_map.EraseIf(IsValueLess(1000)));
+    ASSERT_TRUE(pool_map.empty());
+    pool_map["a"] = 1;
+    ASSERT_EQ(1, pool_map["a"]);
+}
+
+TEST(HashMap, TestParallelMerge)
+{
+    const int map_num = 13;
+    std::vector<HashMap<int, int>*> maps;
+    for (int i = 0; i < map_num; ++i)
+    {
+        maps.push_back(new HashMap<int, int>());
+        for (int j = 0; j < 1000; ++j)
+        {
+            (*maps.back())[j * (i + 1)] = 1;
+        }
+    }
+
+    ParallelMerge(&maps[0], maps.size(), AddValue(), 4);
+    std::map<int, int> expected;
+    for (int i = 0; i < map_num; ++i)
+    {
+        for (int j = 0; j < 1000; ++j)
+        {
+            ++expected[j * (i + 1)];
+        }
+    }
+    ASSERT_EQ(expected.size(), maps[0]->size());
+    for (std::map<int, int>::const_iterator it = expected.begin(); it != expected.end(); ++it)
+    {
+        ASSERT_EQ(it->second, (*maps[0])[it->first]);
+    }
+    for (int i = 0; i < map_num; ++i)
+    {
+        if (i > 0)
+        {
+            ASSERT_TRUE(maps[i]->empty());
+        }
+        delete maps[i];
+    }
+}
+
+namespace {
+
+// An allocator with an identity, which follows its containers
+// on copy, move and swap.
+template<typename T>
+struct TaggedAllocator : public std::allocator<T>
+{
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef TaggedAllocator<Other> other;
+    };
+
+    explicit TaggedAllocator(int t = 0) : tag(t) {}
+
+    template<typename Other>
+    TaggedAllocator(const TaggedAllocator<Other>& other) : tag(other.tag) {}
+
+    int tag;
+};
+
+template<typename T, typename U>
+bool operator==(const TaggedAllocator<T>& lhs, const TaggedAllocator<U>& rhs)
+{
+    return lhs.tag == rhs.tag;
+}
+
+template<typename T, typename U>
+bool operator!=(const TaggedAllocator<T>& lhs, const TaggedAllocator<U>& rhs)
+{
+    return lhs.tag != rhs.tag;
+}
+
+template<typename HashMapType>
+void FillHashMap(HashMapType& hash_map, int first, int last)
+{
+    for (int i = first; i < last; ++i)
+    {
+        hash_map[MakeString(i)] = i;
+    }
+}
+
+template<typename HashMapType>
+void CheckHashMap(const HashMapType& hash_map, int first, int last)
+{
+    ASSERT_EQ(static_cast<std::size_t>(last - first), hash_map.size());
+    for (int i = first; i < last; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(hash_map.Find(MakeString(i), value));
+        ASSERT_EQ(i, value);
+    }
+}
+
+template<typename HashMapType>
+void DoTestCopyMoveAndSwap(const typename HashMapType::allocator_type& alloc1,
+                           const typename HashMapType::allocator_type& alloc2)
+{
+    HashMapType hash_map(static_cast<std::size_t>(0), alloc1);
+    FillHashMap(hash_map, 0, 1000);
+
+    HashMapType copied(hash_map);
+    CheckHashMap(copied, 0, 1000);
+    CheckHashMap(hash_map, 0, 1000);
+
+    HashMapType assigned(static_cast<std::size_t>(0), alloc2);
+    FillHashMap(assigned, 5000, 5100);
+    assigned = hash_map;
+    CheckHashMap(assigned, 0, 1000);
+
+    HashMapType moved(std::move(copied));
+    CheckHashMap(moved, 0, 1000);
+    ASSERT_TRUE(copied.empty());
+    copied[MakeString(1)] = 1;
+    CheckHashMap(copied, 1, 2);
+
+    HashMapType move_assigned(static_cast<std::size_t>(0), alloc2);
+    FillHashMap(move_assigned, 5000, 5100);
+    move_assigned = std::move(moved);
+    CheckHashMap(move_assigned, 0, 1000);
+    ASSERT_TRUE(moved.empty());
+
+    HashMapType other(static_cast<std::size_t>(0), alloc2);
+    FillHashMap(other, 2000, 2500);
+    swap(hash_map, other);
+    CheckHashMap(hash_map, 2000, 2500);
+    CheckHashMap(other, 0, 1000);
+    hash_map.Swap(other);
+    CheckHashMap(hash_map, 0, 1000);
+    CheckHashMap(other, 2000, 2500);
+}
+
+}
+
+TEST(HashMap, TestCopyMoveAndSwap)
+{
+    DoTestCopyMoveAndSwap<HashMap<string, int> >(std::allocator<string>(),
+                                                 std::allocator<string>());
+    // two pools never compare equal
+    DoTestCopyMoveAndSwap<HashMap<string, int, DefaultKeyEqual<string>,
+                                  DefaultHashMapHashPolicy<string>,
+                                  DefaultHashMapRehashPolicy, PoolAllocator<string> > >(
+            PoolAllocator<string>(16), PoolAllocator<string>(16));
+    DoTestCopyMoveAndSwap<HashMap<string, int, DefaultKeyEqual<string>,
+                                  DefaultHashMapHashPolicy<string>,
+                                  DefaultHashMapRehashPolicy, TaggedAllocator<string> > >(
+            TaggedAllocator<string>(1), TaggedAllocator<string>(2));
+}
+
+TEST(HashMap, TestAllocatorPropagation)
+{
+    typedef HashMap<int, int, DefaultKeyEqual<int>, DefaultHashMapHashPolicy<int>,
+                    DefaultHashMapRehashPolicy, TaggedAllocator<int> > TaggedHashMap;
+    TaggedHashMap hash_map(static_cast<std::size_t>(0), TaggedAllocator<int>(1));
+    hash_map[1] = 1;
+    ASSERT_EQ(1, hash_map.get_allocator().tag);
+    ASSERT_EQ(1, hash_map.GetNodeAllocator().tag);
+    ASSERT_EQ(1, hash_map.GetBucketAllocator().tag);
+
+    TaggedHashMap copied(hash_map);
+    ASSERT_EQ(1, copied.get_allocator().tag);
+    TaggedHashMap copied2(hash_map, TaggedAllocator<int>(3));
+    ASSERT_EQ(3, copied2.get_allocator().tag);
+    ASSERT_EQ(1, copied2[1]);
+
+    TaggedHashMap other(static_cast<std::size_t>(0), TaggedAllocator<int>(2));
+    other = hash_map;
+    ASSERT_EQ(1, other.get_allocator().tag);
+
+    TaggedHashMap other2(static_cast<std::size_t>(0), TaggedAllocator<int>(2));
+    other2[2] = 2;
+    other2.Swap(hash_map);
+    ASSERT_EQ(2, hash_map.get_allocator().tag);
+    ASSERT_EQ(1, other2.get_allocator().tag);
+    ASSERT_EQ(2, hash_map[2]);
+
+    other2 = std::move(hash_map);
+    ASSERT_EQ(2, other2.get_allocator().tag);
+    ASSERT_EQ(2, other2[2]);
+}
+
+#if __cplusplus >= 201703L
+namespace {
+
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    CountingResource() : allocated_bytes(0) {}
+
+    std::size_t allocated_bytes;
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        allocated_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+    {
+        allocated_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+};
+
+}
+
+TEST(HashMap, TestPmrHashMap)
+{
+    typedef snippet::algo::pmr::HashMap<string, int> PmrHashMap;
+    CountingResource resource;
+    {
+        PmrHashMap hash_map(static_cast<std::size_t>(0), &resource);
+        ASSERT_EQ(&resource, hash_map.get_allocator().resource());
+        const std::size_t bucket_bytes = resource.allocated_bytes;
+        ASSERT_GT(bucket_bytes, 0);
+        FillHashMap(hash_map, 0, 1000);
+        ASSERT_GT(resource.allocated_bytes, bucket_bytes);
+
+        // the copy does not propagate the resource
+        PmrHashMap copied(hash_map);
+        ASSERT_EQ(std::pmr::get_default_resource(), copied.get_allocator().resource());
+        CheckHashMap(copied, 0, 1000);
+
+        // but the move does, and takes the nodes over
+        const std::size_t allocated_bytes = resource.allocated_bytes;
+        PmrHashMap moved(std::move(hash_map));
+        ASSERT_EQ(&resource, moved.get_allocator().resource());
+        CheckHashMap(moved, 0, 1000);
+        ASSERT_LT(resource.allocated_bytes - allocated_bytes, bucket_bytes * 2);
+
+        // the maps keep their resources when swapped
+        copied.Clear();
+        FillHashMap(copied, 2000, 2100);
+        swap(moved, copied);
+        ASSERT_EQ(&resource, moved.get_allocator().resource());
+        CheckHashMap(moved, 2000, 2100);
+        CheckHashMap(copied, 0, 1000);
+    }
+    ASSERT_EQ(0, resource.allocated_bytes);
+
+    std::pmr::monotonic_buffer_resource arena;
+    PmrHashMap hash_map(static_cast<std::size_t>(0), &arena);
+    FillHashMap(hash_map, 0, 1000);
+    CheckHashMap(hash_map, 0, 1000);
+}
+#endif
@@ -0,0 +1,118 @@
+#include "InlineHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sstream>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(InlineHashMap, TestInsertFindDelete)
+{
+    InlineHashMap<string, string> hash_map;
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.Insert("a", "1"));
+    ASSERT_FALSE(hash_map.Insert("a", "2"));
+    ASSERT_TRUE(hash_map.Insert("b", "2"));
+    ASSERT_EQ(2, hash_map.size());
+
+    string value;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ("1", value);
+    ASSERT_TRUE(hash_map.Find("b") != hash_map.end());
+    ASSERT_TRUE(hash_map.Find("c") == hash_map.end());
+
+    hash_map["c"] = "3";
+    ASSERT_EQ("3", hash_map.Find("c").GetValue());
+
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+    ASSERT_EQ(2, hash_map.size());
+
+    hash_map.Clear();
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.begin() == hash_map.end());
+}
+
+// A single bucket, so everything goes through the overflow chain.
+struct ZeroHashPolicy
+{
+    std::size_t DoHash(int) const { return 0; }
+};
+
+TEST(InlineHashMap, TestOverflowChain)
+{
+    typedef InlineHashMap<int, int, DefaultKeyEqual<int>, ZeroHashPolicy> ChainMap;
+    ChainMap hash_map;
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(hash_map.Insert(i, i * 10));
+    }
+
+    // deleting the inline entry promotes an overflow one
+    ASSERT_TRUE(hash_map.Delete(0));
+    ASSERT_TRUE(hash_map.Delete(5));
+    ASSERT_TRUE(hash_map.Delete(9));
+    ASSERT_EQ(7, hash_map.size());
+    for (int i = 0; i < 10; ++i)
+    {
+        int value = 0;
+        const bool expected = (i != 0 && i != 5 && i != 9);
+        ASSERT_EQ(expected, hash_map.Find(i, value)) << i;
+        if (expected)
+        {
+            ASSERT_EQ(i * 10, value);
+        }
+    }
+
+    std::size_t count = 0;
+    for (ChainMap::iterator it = hash_map.begin(); it != hash_map.end(); ++it)
+    {
+        ASSERT_EQ(it.GetKey() * 10, it.GetValue());
+        ++count;
+    }
+    ASSERT_EQ(hash_map.size(), count);
+}
+
+TEST(InlineHashMap, TestRehashAndCopy)
+{
+    InlineHashMap<int, string> hash_map;
+    map<int, string> std_map;
+    const std::size_t bucket_count = hash_map.GetBucketCount();
+
+    srand(0);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const int key = rand() % 5000;
+        stringstream ss;
+        ss << i;
+        if (rand() % 4 == 0)
+        {
+            ASSERT_EQ(std_map.erase(key) > 0, hash_map.Delete(key));
+        }
+        else
+        {
+            hash_map[key] = ss.str();
+            std_map[key] = ss.str();
+        }
+    }
+    ASSERT_GT(hash_map.GetBucketCount(), bucket_count);
+    ASSERT_EQ(std_map.size(), hash_map.size());
+
+    const InlineHashMap<int, string> copy(hash_map);
+    hash_map.Clear();
+    ASSERT_EQ(std_map.size(), copy.size());
+
+    std::size_t count = 0;
+    for (InlineHashMap<int, string>::const_iterator it = copy.begin();
+         it != copy.end(); ++it)
+    {
+        ASSERT_EQ(std_map[it.GetKey()], it.GetValue());
+        ++count;
+    }
+    ASSERT_EQ(std_map.size(), count);
+}
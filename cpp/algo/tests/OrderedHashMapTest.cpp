@@ -0,0 +1,160 @@
+#include "OrderedHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(OrderedHashMap, TestInsertFindDelete)
+{
+    OrderedHashMap<string, string> hash_map;
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.Insert("a", "1"));
+    ASSERT_FALSE(hash_map.Insert("a", "2"));
+    ASSERT_TRUE(hash_map.Insert("b", "2"));
+    hash_map["c"] = "3";
+    ASSERT_EQ(3, hash_map.size());
+
+    string value;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ("1", value);
+    ASSERT_EQ("3", hash_map.Find("c").GetValue());
+    ASSERT_TRUE(hash_map.Find("d") == hash_map.end());
+
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+    ASSERT_TRUE(hash_map.Find("c", value));
+    ASSERT_EQ("3", value);
+    ASSERT_EQ(2, hash_map.size());
+    ASSERT_EQ("b", hash_map.begin().GetKey());
+
+    hash_map.Clear();
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.begin() == hash_map.end());
+}
+
+TEST(OrderedHashMap, TestInsertionOrder)
+{
+    OrderedHashMap<int, int> hash_map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map.Insert(999 - i, i);
+    }
+    // every odd key is deleted, and then 1 is inserted again at the end
+    for (int i = 1; i < 1000; i += 2)
+    {
+        ASSERT_TRUE(hash_map.Delete(i));
+    }
+    hash_map[1] = 1000;
+    for (int i = 0; i < 5000; ++i)
+    {
+        hash_map.Insert(1000 + i, 1001 + i);
+    }
+
+    vector<int> values;
+    for (OrderedHashMap<int, int>::const_iterator it = hash_map.begin();
+         it != hash_map.end(); ++it)
+    {
+        values.push_back(it.GetValue());
+    }
+    ASSERT_EQ(500 + 1 + 5000, values.size());
+    for (std::size_t i = 1; i < values.size(); ++i)
+    {
+        ASSERT_LT(values[i - 1], values[i]);
+    }
+}
+
+template<typename Key>
+static Key MakeKey(int i);
+
+template<>
+int MakeKey<int>(int i)
+{
+    return i;
+}
+
+template<>
+string MakeKey<string>(int i)
+{
+    stringstream ss;
+    ss << i;
+    return ss.str();
+}
+
+template<typename Key>
+static void CheckRandomOperations()
+{
+    OrderedHashMap<Key, int> hash_map;
+    map<Key, int> std_map;
+    const std::size_t index_size = hash_map.GetIndexSize();
+
+    srand(0);
+    for (int i = 0; i < 20000; ++i)
+    {
+        const Key key = MakeKey<Key>(rand() % 5000);
+        if (rand() % 4 == 0)
+        {
+            ASSERT_EQ(std_map.erase(key) > 0, hash_map.Delete(key));
+        }
+        else
+        {
+            hash_map[key] = i;
+            std_map[key] = i;
+        }
+    }
+    ASSERT_GT(hash_map.GetIndexSize(), index_size);
+    ASSERT_EQ(std_map.size(), hash_map.size());
+
+    const OrderedHashMap<Key, int> copy(hash_map);
+    hash_map.Clear();
+    ASSERT_EQ(std_map.size(), copy.size());
+
+    std::size_t count = 0;
+    for (typename OrderedHashMap<Key, int>::const_iterator it = copy.begin();
+         it != copy.end(); ++it)
+    {
+        ASSERT_EQ(std_map[it.GetKey()], it.GetValue());
+        ++count;
+    }
+    ASSERT_EQ(std_map.size(), count);
+
+    for (typename map<Key, int>::const_iterator it = std_map.begin();
+         it != std_map.end(); ++it)
+    {
+        int value = 0;
+        ASSERT_TRUE(copy.Find(it->first, value));
+        ASSERT_EQ(it->second, value);
+    }
+}
+
+TEST(OrderedHashMap, TestRandomOperations)
+{
+    CheckRandomOperations<int>();
+    CheckRandomOperations<string>();
+}
+
+TEST(OrderedHashMap, TestMemoryUsage)
+{
+    // indices of 1 byte while the table has at most 128 slots
+    OrderedHashMap<int, int> small_map(80);
+    ASSERT_EQ(128, small_map.GetIndexSize());
+    ASSERT_EQ(128 + 85 * sizeof(OrderedHashMap<int, int>::Entry),
+              small_map.GetMemoryUsage());
+
+    OrderedHashMap<int, int> hash_map(1000);
+    const std::size_t memory_usage = hash_map.GetMemoryUsage();
+    for (int i = 0; i < 1000; ++i)
+    {
+        hash_map.Insert(i, i);
+    }
+    // everything fits in the reserved arrays
+    ASSERT_EQ(memory_usage, hash_map.GetMemoryUsage());
+    ASSERT_LT(memory_usage, 1000 * 32);
+}
@@ -0,0 +1,79 @@
+#include "PartitionedHashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(PartitionedHashMap, TestInsertFindDelete)
+{
+    PartitionedHashMap<string, int> hash_map(4);
+    ASSERT_EQ(16, hash_map.GetPartitionNum());
+    ASSERT_TRUE(hash_map.empty());
+    ASSERT_TRUE(hash_map.Insert("a", 1));
+    ASSERT_FALSE(hash_map.Insert("a", 2));
+    ASSERT_TRUE(hash_map.Insert("b", 2));
+    ASSERT_EQ(2, hash_map.size());
+
+    int value = 0;
+    ASSERT_TRUE(hash_map.Find("a", value));
+    ASSERT_EQ(1, value);
+    const PartitionedHashMap<string, int>::MapType& partition =
+            hash_map.GetPartition(hash_map.GetPartitionIndex("a"));
+    ASSERT_TRUE(partition.Find("a") != partition.end());
+    ASSERT_TRUE(hash_map.Delete("a"));
+    ASSERT_FALSE(hash_map.Find("a", value));
+
+    hash_map.Clear();
+    ASSERT_TRUE(hash_map.empty());
+}
+
+TEST(PartitionedHashMap, TestBuild)
+{
+    vector<int> keys;
+    vector<int> values;
+    for (int i = 0; i < 100000; ++i)
+    {
+        keys.push_back(i % 60000);
+        values.push_back(i);
+    }
+
+    for (unsigned int thread_num = 1; thread_num <= 8; thread_num *= 2)
+    {
+        PartitionedHashMap<int, int> hash_map(6);
+        hash_map.Insert(7, -1);
+        hash_map.Build(&keys[0], &values[0], keys.size(), thread_num);
+        ASSERT_EQ(60000, hash_map.size());
+
+        std::size_t max_partition_size = 0;
+        for (std::size_t i = 0; i < hash_map.GetPartitionNum(); ++i)
+        {
+            const PartitionedHashMap<int, int>::MapType& partition = hash_map.GetPartition(i);
+            max_partition_size = max(max_partition_size, partition.size());
+            for (PartitionedHashMap<int, int>::MapType::const_iterator it = partition.begin();
+                 it != partition.end(); ++it)
+            {
+                ASSERT_EQ(i, hash_map.GetPartitionIndex(it.GetKey()));
+            }
+        }
+        ASSERT_LT(max_partition_size, 60000 / 64 * 2);
+
+        // the present key and the first of the repeated ones are kept
+        int value = 0;
+        ASSERT_TRUE(hash_map.Find(7, value));
+        ASSERT_EQ(-1, value);
+        for (int i = 0; i < 60000; i += 7)
+        {
+            if (i != 7)
+            {
+                ASSERT_TRUE(hash_map.Find(i, value));
+                ASSERT_EQ(i, value);
+            }
+        }
+        ASSERT_FALSE(hash_map.Find(60000, value));
+    }
+}
@@ -0,0 +1,93 @@
+#include "StaticHashMap.h"
+#include "HashMap.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+static constexpr StaticHashMapItem<int> gs_methods[] = {
+    {"GET", 1}, {"HEAD", 2}, {"POST", 3}, {"PUT", 4}, {"DELETE", 5},
+    {"CONNECT", 6}, {"OPTIONS", 7}, {"TRACE", 8}, {"PATCH", 9}, {"", 10}
+};
+
+static constexpr StaticHashMap<int, 10> gs_method_map(gs_methods);
+
+// built and looked up by the compiler
+static_assert(*gs_method_map.Find("PATCH") == 9, "PATCH is 9");
+static_assert(gs_method_map.Find("PATCH2") == NULL, "PATCH2 is absent");
+
+TEST(StaticHashMap, TestFind)
+{
+    ASSERT_EQ(10, gs_method_map.size());
+    ASSERT_EQ(16, gs_method_map.GetTableSize());
+
+    for (int i = 0; i < 10; ++i)
+    {
+        const int* value = gs_method_map.Find(gs_methods[i].key);
+        ASSERT_TRUE(value != NULL);
+        ASSERT_EQ(gs_methods[i].value, *value);
+    }
+
+    int value = 0;
+    ASSERT_TRUE(gs_method_map.Find(string("DELETE"), value));
+    ASSERT_EQ(5, value);
+    ASSERT_FALSE(gs_method_map.Find(string("GE"), value));
+    ASSERT_FALSE(gs_method_map.Find(string("GETS"), value));
+    ASSERT_FALSE(gs_method_map.Find(string("get"), value));
+    ASSERT_TRUE(gs_method_map.Find("", 0) != NULL);
+}
+
+TEST(StaticHashMap, TestHashMatchesHashMap)
+{
+    const char* strs[] = { "", "a", "Content-Type", "\xff\x80" };
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(Hash(string(strs[i])),
+                  StaticHashMapHashPolicy::DoHash(strs[i], string(strs[i]).size()));
+    }
+}
+
+// Keys of the same first char get the same hash code.
+struct BadHashPolicy
+{
+    static constexpr std::size_t DoHash(const char* str, const std::size_t str_size)
+    {
+        return str_size > 0 ? static_cast<unsigned char>(str[0]) << 8 : 0;
+    }
+};
+
+TEST(StaticHashMap, TestManyKeys)
+{
+    static std::vector<string> keys;
+    static StaticHashMapItem<int> items[300];
+    for (int i = 0; i < 300; ++i)
+    {
+        stringstream ss;
+        ss << "x" << i;
+        keys.push_back(ss.str());
+    }
+    for (int i = 0; i < 300; ++i)
+    {
+        items[i].key = keys[i].c_str();
+        items[i].value = i;
+    }
+
+    // built at runtime this time
+    const StaticHashMap<int, 300> hash_map(items);
+    ASSERT_EQ(512, hash_map.GetTableSize());
+    for (int i = 0; i < 300; ++i)
+    {
+        ASSERT_EQ(i, *hash_map.Find(keys[i].c_str()));
+    }
+    ASSERT_TRUE(hash_map.Find("x300") == NULL);
+
+    StaticHashMapItem<int> same_bucket[] = { {"x", 1}, {"xy", 2}, {"xyz", 3}, {"xyzw", 4} };
+    ASSERT_THROW((StaticHashMap<int, 4, BadHashPolicy>(same_bucket)), std::invalid_argument);
+    StaticHashMapItem<int> duplicated[] = { {"a", 1}, {"b", 2}, {"a", 3} };
+    ASSERT_THROW((StaticHashMap<int, 3>(duplicated)), std::invalid_argument);
+}
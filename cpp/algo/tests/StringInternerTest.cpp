@@ -0,0 +1,110 @@
+#include "StringInterner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace snippet::algo;
+using namespace std;
+
+TEST(StringInterner, TestIntern)
+{
+    StringInterner interner;
+    const StringInterner::Symbol a = interner.Intern("host-a");
+    const StringInterner::Symbol b = interner.Intern(string("host-b"));
+    ASSERT_NE(a, b);
+    ASSERT_EQ(a, interner.Intern("host-a", 6));
+    ASSERT_EQ(a, interner.Intern(string("host-a")));
+
+    const char* handle = interner.GetString(a);
+    ASSERT_STREQ("host-a", handle);
+    ASSERT_EQ(6, interner.GetLength(a));
+    ASSERT_STREQ("host-b", interner.GetString(b));
+
+    // an empty string and one with '\0' inside are fine
+    const StringInterner::Symbol empty = interner.Intern("", 0);
+    ASSERT_EQ(0, interner.GetLength(empty));
+    const StringInterner::Symbol with_zero = interner.Intern("a\0b", 3);
+    ASSERT_EQ(3, interner.GetLength(with_zero));
+    ASSERT_EQ(0, memcmp("a\0b", interner.GetString(with_zero), 3));
+
+    StringInterner::Symbol symbol = 0;
+    ASSERT_TRUE(interner.Find("host-b", 6, &symbol));
+    ASSERT_EQ(b, symbol);
+    ASSERT_FALSE(interner.Find("host-c", 6, &symbol));
+
+    // handles are stable while more strings are added
+    for (int i = 0; i < 100000; ++i)
+    {
+        stringstream ss;
+        ss << "metric." << i;
+        interner.Intern(ss.str());
+    }
+    ASSERT_EQ(handle, interner.GetString(a));
+    ASSERT_EQ(100004, interner.size());
+
+    StringInterner::Stats stats;
+    interner.GetStats(&stats);
+    ASSERT_EQ(100006, stats.intern_count);
+    ASSERT_EQ(100004, stats.string_count);
+    ASSERT_EQ(12, stats.GetSavedBytes());
+}
+
+namespace {
+
+struct InternThread
+{
+    InternThread(StringInterner& i, vector<StringInterner::Symbol>& s)
+    : interner(i), symbols(s)
+    {}
+
+    void operator()()
+    {
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            stringstream ss;
+            ss << "key" << i;
+            symbols[i] = interner.Intern(ss.str());
+        }
+    }
+
+    StringInterner& interner;
+    vector<StringInterner::Symbol>& symbols;
+};
+
+}
+
+TEST(StringInterner, TestConcurrentIntern)
+{
+    StringInterner interner;
+    const int key_num = 20000;
+    vector<vector<StringInterner::Symbol> > symbols(4, vector<StringInterner::Symbol>(key_num));
+
+    vector<thread> threads;
+    for (size_t t = 0; t < symbols.size(); ++t)
+    {
+        threads.push_back(thread(InternThread(interner, symbols[t])));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    ASSERT_EQ(static_cast<size_t>(key_num), interner.size());
+    HashMap<StringInterner::Symbol, int> symbol_map;
+    for (int i = 0; i < key_num; ++i)
+    {
+        for (size_t t = 1; t < symbols.size(); ++t)
+        {
+            ASSERT_EQ(symbols[0][i], symbols[t][i]);
+        }
+        stringstream ss;
+        ss << "key" << i;
+        ASSERT_EQ(ss.str(), interner.GetString(symbols[0][i]));
+        ASSERT_TRUE(symbol_map.Insert(symbols[0][i], i));
+    }
+}
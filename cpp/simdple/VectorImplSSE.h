@@ -85,6 +85,12 @@ template<> struct VectorImpl<char, 16> :
         res.gv = _mm_cmpgt_epi8(gv, other.gv);
         return res;
     }
+
+    // one bit per byte, from the most significant bit of each byte
+    inline int MoveMask() const
+    {
+        return _mm_movemask_epi8(gv);
+    }
 };
 
 template<> struct VectorImpl<short, 8> :
@@ -165,6 +171,12 @@ template<> struct VectorImpl<short, 8> :
         res.gv = _mm_cmpgt_epi16(gv, other.gv);
         return res;
     }
+
+    // one bit per byte, from the most significant bit of each byte
+    inline int MoveMask() const
+    {
+        return _mm_movemask_epi8(gv);
+    }
 };
 
 template<> struct VectorImpl<int, 4> :
@@ -205,6 +217,26 @@ template<> struct VectorImpl<int, 4> :
         res.BitwiseAndNotFrom(other);
         return res;
     }
+
+    inline VectorImpl IsEqual(const VectorImpl other) const
+    {
+        VectorImpl res;
+        res.gv = _mm_cmpeq_epi32(gv, other.gv);
+        return res;
+    }
+
+    inline VectorImpl IsGreater(const VectorImpl other) const
+    {
+        VectorImpl res;
+        res.gv = _mm_cmpgt_epi32(gv, other.gv);
+        return res;
+    }
+
+    // one bit per byte, from the most significant bit of each byte
+    inline int MoveMask() const
+    {
+        return _mm_movemask_epi8(gv);
+    }
 };
 
 template<> struct VectorImpl<long long, 2> :
@@ -245,6 +277,28 @@ template<> struct VectorImpl<long long, 2> :
         res.BitwiseAndNotFrom(other);
         return res;
     }
+
+#ifdef __SSE4_2__
+    inline VectorImpl IsEqual(const VectorImpl other) const
+    {
+        VectorImpl res;
+        res.gv = _mm_cmpeq_epi64(gv, other.gv);
+        return res;
+    }
+
+    inline VectorImpl IsGreater(const VectorImpl other) const
+    {
+        VectorImpl res;
+        res.gv = _mm_cmpgt_epi64(gv, other.gv);
+        return res;
+    }
+#endif  // __SSE4_2__
+
+    // one bit per byte, from the most significant bit of each byte
+    inline int MoveMask() const
+    {
+        return _mm_movemask_epi8(gv);
+    }
 };
 
 template<> struct VectorImpl<float, 4> : public detail::Pack<float, __v4sf, __m128, 4>
@@ -85,3 +85,40 @@ TYPED_TEST(VectorImplBitwiseTest, TestAndNot)
     ASSERT_EQ(65, v_3[0]);
 }
 
+
+template<typename T>
+class VectorImplCompareTest : public ::testing::Test {};
+
+typedef ::testing::Types<VectorImpl<char, 16>, VectorImpl<short, 8>, VectorImpl<int, 4>
+#ifdef __SSE4_2__
+        , VectorImpl<long long, 2>
+#endif
+> CompareTypes;
+TYPED_TEST_CASE(VectorImplCompareTest, CompareTypes);
+
+TYPED_TEST(VectorImplCompareTest, TestIsGreaterAndMoveMask)
+{
+    typedef typename TypeParam::ElemType ElemType;
+    const int elem_bytes = sizeof(ElemType);
+    TypeParam v = TypeParam::Load(static_cast<ElemType>(0));
+    for (size_t i = 0; i < TypeParam::ElemNum; ++i) {
+        v[i] = static_cast<ElemType>(i) - 2;
+    }
+
+    TypeParam needle = TypeParam::Load(static_cast<ElemType>(1));
+    int greater_mask = 0;
+    int equal_mask = 0;
+    for (size_t i = 0; i < TypeParam::ElemNum; ++i) {
+        const int elem_mask = ((1 << elem_bytes) - 1) << (i * elem_bytes);
+        if (v[i] < 1) {
+            greater_mask |= elem_mask;
+        } else if (v[i] == 1) {
+            equal_mask |= elem_mask;
+        }
+    }
+    ASSERT_NE(0, greater_mask);
+    ASSERT_EQ(greater_mask, needle.IsGreater(v).MoveMask());
+    ASSERT_EQ(equal_mask, needle.IsEqual(v).MoveMask());
+    ASSERT_EQ(0, v.IsGreater(v).MoveMask());
+    ASSERT_EQ((1 << TypeParam::Size()) - 1, v.IsEqual(v).MoveMask());
+}